@@ -0,0 +1,654 @@
+#ifndef BATCHMODE_H
+#define BATCHMODE_H
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "Task.h"
+#include "PriorityQueue.h"
+#include "Metrics.h"
+#include "RecurrenceRules.h"
+
+// Collects output in one large buffer and writes it to a file descriptor only
+// when the buffer fills or flush() is called. sync() - what endl and flush
+// trigger on the stream - does nothing, so the scheduler's per-line flushes
+// cost nothing in batch mode.
+class BatchWriter : public streambuf
+{
+    private:
+        int fd;
+        vector<char> buffer;
+        bool writeAll(const char* data, size_t length)
+        {
+            while (length > 0)
+            {
+                ssize_t written = ::write(fd, data, length);
+                if (written < 0)
+                {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                data += written;
+                length -= written;
+            }
+            return true;
+        }
+    protected:
+        int_type overflow(int_type c) override
+        {
+            if (!flush()) return traits_type::eof();
+            if (!traits_type::eq_int_type(c, traits_type::eof()))
+            {
+                *pptr() = traits_type::to_char_type(c);
+                pbump(1);
+            }
+            return traits_type::not_eof(c);
+        }
+        streamsize xsputn(const char* data, streamsize length) override
+        {
+            if (length > epptr() - pptr())
+            {
+                if (!flush()) return 0;
+                if (length >= (streamsize)buffer.size())
+                    return writeAll(data, length) ? length : 0;
+            }
+            memcpy(pptr(), data, length);
+            pbump(length);
+            return length;
+        }
+        int sync() override
+        {
+            return 0;
+        }
+    public:
+        explicit BatchWriter(int outputFd = STDOUT_FILENO, size_t capacity = 1 << 20)
+            : fd(outputFd), buffer(capacity)
+        {
+            setp(buffer.data(), buffer.data() + buffer.size());
+        }
+        ~BatchWriter()
+        {
+            flush();
+        }
+        bool flush()
+        {
+            bool ok = writeAll(pbase(), pptr() - pbase());
+            setp(buffer.data(), buffer.data() + buffer.size());
+            return ok;
+        }
+};
+
+// Discards everything written to it.
+class NullBuffer : public streambuf
+{
+    protected:
+        int_type overflow(int_type c) override
+        {
+            return traits_type::not_eof(c);
+        }
+        streamsize xsputn(const char*, streamsize length) override
+        {
+            return length;
+        }
+};
+
+// Splits a command line into arguments at whitespace. Double quotes group
+// words and accept \" and \\ escapes. Returns false on an unterminated quote.
+inline bool splitCommand(const string& line, vector<string>& args)
+{
+    args.clear();
+    size_t i = 0;
+    while (true)
+    {
+        while (i < line.size() && isspace((unsigned char)line[i]))
+            i++;
+        if (i == line.size()) return true;
+        string arg;
+        if (line[i] == '"')
+        {
+            i++;
+            while (i < line.size() && line[i] != '"')
+            {
+                if (line[i] == '\\' && i + 1 < line.size())
+                    i++;
+                arg += line[i++];
+            }
+            if (i == line.size()) return false;
+            i++;
+        }
+        else
+        {
+            while (i < line.size() && !isspace((unsigned char)line[i]))
+                arg += line[i++];
+        }
+        args.push_back(arg);
+    }
+}
+
+// YYYY-MM-DD at local midnight, or "none" for no due date.
+inline bool parseDate(const string& text, time_t& date)
+{
+    if (text == "none")
+    {
+        date = 0;
+        return true;
+    }
+    struct tm parts = {};
+    char extra;
+    if (sscanf(text.c_str(), "%d-%d-%d%c", &parts.tm_year, &parts.tm_mon, &parts.tm_mday, &extra) != 3)
+        return false;
+    parts.tm_year -= 1900;
+    parts.tm_mon -= 1;
+    parts.tm_isdst = -1;
+    date = mktime(&parts);
+    return date != -1;
+}
+
+inline bool parseNumber(const string& text, int& value)
+{
+    char* end;
+    errno = 0;
+    long parsed = strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || errno == ERANGE || parsed != (int)parsed)
+        return false;
+    value = parsed;
+    return true;
+}
+
+inline bool parseNumber(const string& text, uint64_t& value)
+{
+    char* end;
+    errno = 0;
+    unsigned long long parsed = strtoull(text.c_str(), &end, 10);
+    if (!isdigit((unsigned char)text[0]) || *end != '\0' || errno == ERANGE)
+        return false;
+    value = parsed;
+    return true;
+}
+
+inline bool parseStatus(const string& text, TaskStatus& status)
+{
+    int value;
+    if (!parseNumber(text, value) || value < PENDING || value > COMPLETED)
+        return false;
+    status = (TaskStatus)value;
+    return true;
+}
+
+// Reads a file for add-many: one task per line as "NAME DESCRIPTION PRIORITY
+// STATUS DUE", quoted and checked like the add command. Blank lines and lines
+// starting with # are skipped. On error, names the offending line.
+inline bool readTaskSpecs(const string& fileName, vector<TaskSpec>& specs, string& error)
+{
+    ifstream file(fileName);
+    if (!file)
+    {
+        error = "cannot open " + fileName;
+        return false;
+    }
+    string line;
+    vector<string> fields;
+    int lineNumber = 0;
+    while (getline(file, line))
+    {
+        lineNumber++;
+        if (!splitCommand(line, fields))
+        {
+            error = fileName + " line " + to_string(lineNumber) + ": unterminated quote";
+            return false;
+        }
+        if (fields.empty() || fields[0][0] == '#') continue;
+        TaskSpec spec;
+        if (fields.size() != 5 || !parseNumber(fields[2], spec.priority) || !parseStatus(fields[3], spec.status) ||
+            !parseDate(fields[4], spec.dueDate))
+        {
+            error = fileName + " line " + to_string(lineNumber) + ": expected NAME DESCRIPTION PRIORITY STATUS DUE";
+            return false;
+        }
+        spec.name = fields[0];
+        spec.description = fields[1];
+        specs.push_back(spec);
+    }
+    return true;
+}
+
+inline void writeJsonString(ostream& out, string_view text)
+{
+    out << '"';
+    for (unsigned char c : text)
+    {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (c == '\n')
+            out << "\\n";
+        else if (c == '\t')
+            out << "\\t";
+        else if (c < 0x20)
+        {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        }
+        else
+            out << c;
+    }
+    out << '"';
+}
+
+inline void writeTaskJson(ostream& out, const Task& task)
+{
+    static const char* statusNames[] = { "pending", "in_progress", "completed" };
+    out << "{\"id\":" << task.taskId << ",\"name\":";
+    writeJsonString(out, task.taskName);
+    out << ",\"description\":";
+    writeJsonString(out, task.taskDescription);
+    out << ",\"status\":\"" << statusNames[task.taskStatus] << "\",\"priority\":" << task.taskPriority
+        << ",\"due\":" << (long long)task.taskDueDate << ",\"created\":" << (long long)task.taskCreationDate
+        << ",\"completed\":" << (long long)task.taskCompletionDate << '}';
+}
+
+// Command-line switches for batch mode: [--batch] [--json] [FILE]. Commands
+// come from FILE, or standard input when it is omitted. --json and FILE each
+// imply --batch.
+struct BatchOptions
+{
+    bool enabled = false;
+    bool json = false;
+    string file;
+};
+
+// Returns false on an unknown argument.
+inline bool parseBatchOptions(int argc, char* argv[], BatchOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--batch")
+        {
+            options.enabled = true;
+        }
+        else if (arg == "--json")
+        {
+            options.enabled = true;
+            options.json = true;
+        }
+        else if (arg[0] != '-' && options.file.empty())
+        {
+            options.enabled = true;
+            options.file = arg;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Outcome of one batch command, written as a JSON line in --json mode.
+struct BatchReply
+{
+    bool ok = true;
+    string error;
+    int id = -1;                // task or recurrence rule created by the command, if any
+    uint64_t token = 0;         // lease token granted by claim
+    bool listing = false;       // tasks holds the command's result set
+    vector<const Task*> tasks;
+    string output;              // human-readable text for commands without a structured form
+    void fail(const string& message)
+    {
+        ok = false;
+        error = message;
+    }
+};
+
+// Headless driver for a TaskScheduler. Reads one command per line, runs it
+// without prompts, and writes everything through a single BatchWriter. In
+// JSON mode the scheduler's own messages are dropped and each command yields
+// one JSON object per line instead; overdue notices become
+// {"event":"overdue",...} lines.
+//
+//   add NAME DESCRIPTION PRIORITY STATUS DUE    status: 0-2, DUE: YYYY-MM-DD or none
+//   add-many FILE    one "NAME DESCRIPTION PRIORITY STATUS DUE" per line, added as one
+//       undo step; replies with the first new ID
+//   modify ID NAME DESCRIPTION PRIORITY STATUS DUE
+//   remove ID | status ID STATUS | undo | redo
+//   list | by-status STATUS | by-priority | overdue | due HOURS | structure
+//   recur NAME DESCRIPTION PRIORITY DUE_AFTER SCHEDULE
+//       DUE_AFTER: 0 or a duration such as 12h; SCHEDULE: "every 1d" or "cron 0 9 * * 1-5"
+//   unrecur RULE_ID | rules
+//   claim SECONDS | heartbeat ID TOKEN SECONDS | complete ID TOKEN | release ID TOKEN
+//       claim leases the next queued task for SECONDS and replies with its ID and lease TOKEN
+//   policy 0-3 | stats [prometheus] | quit
+//
+// Blank lines and lines starting with # are skipped. The scheduler type only
+// needs the methods used below; programs add their own commands through the
+// extra callback given to run().
+class BatchSession
+{
+    private:
+        bool json;
+        BatchWriter writer;
+        ostream out;
+        NullBuffer discard;
+        stringbuf capture;
+        streambuf* console;
+        int failures;
+
+        static bool arity(const vector<string>& args, size_t count, const char* usage, BatchReply& reply)
+        {
+            if (args.size() == count) return true;
+            reply.fail(string("usage: ") + usage);
+            return false;
+        }
+        static void list(const vector<Task*>& tasks, BatchReply& reply)
+        {
+            reply.listing = true;
+            reply.tasks.assign(tasks.begin(), tasks.end());
+        }
+        // Returns false if the command is not one of the common ones.
+        template <typename Scheduler>
+        bool runCommon(Scheduler& scheduler, const vector<string>& args, BatchReply& reply)
+        {
+            const string& command = args[0];
+            int id, priority, number;
+            uint64_t token;
+            TaskStatus status;
+            time_t due;
+            if (command == "add")
+            {
+                if (!arity(args, 6, "add NAME DESCRIPTION PRIORITY STATUS DUE", reply)) return true;
+                if (!parseNumber(args[3], priority) || !parseStatus(args[4], status) || !parseDate(args[5], due))
+                    reply.fail("invalid priority, status or due date");
+                else
+                    reply.id = scheduler.addTask(args[1], args[2], status, priority, due);
+            }
+            else if (command == "add-many")
+            {
+                if (!arity(args, 2, "add-many FILE", reply)) return true;
+                vector<TaskSpec> specs;
+                string error;
+                if (!readTaskSpecs(args[1], specs, error))
+                    reply.fail(error);
+                else
+                    reply.id = scheduler.addTasks(specs);
+            }
+            else if (command == "modify")
+            {
+                if (!arity(args, 7, "modify ID NAME DESCRIPTION PRIORITY STATUS DUE", reply)) return true;
+                if (!parseNumber(args[1], id) || !parseNumber(args[4], priority) || !parseStatus(args[5], status) || !parseDate(args[6], due))
+                    reply.fail("invalid ID, priority, status or due date");
+                else if (!scheduler.modifyTask(id, args[2], args[3], status, priority, due))
+                    reply.fail("task not found");
+            }
+            else if (command == "remove")
+            {
+                if (!arity(args, 2, "remove ID", reply)) return true;
+                if (!parseNumber(args[1], id))
+                    reply.fail("invalid ID");
+                else if (!scheduler.removeTask(id))
+                    reply.fail("task not found");
+            }
+            else if (command == "status")
+            {
+                if (!arity(args, 3, "status ID STATUS", reply)) return true;
+                if (!parseNumber(args[1], id) || !parseStatus(args[2], status))
+                    reply.fail("invalid ID or status");
+                else if (!scheduler.changeTaskStatus(id, status))
+                    reply.fail("task not found");
+            }
+            else if (command == "undo" || command == "redo")
+            {
+                if (!arity(args, 1, command.c_str(), reply)) return true;
+                if (!(command == "undo" ? scheduler.undo() : scheduler.redo()))
+                    reply.fail("nothing to " + command);
+            }
+            else if (command == "list")
+            {
+                if (!arity(args, 1, "list", reply)) return true;
+                if (!json)
+                    scheduler.displayAllTasks();
+                else
+                {
+                    reply.listing = true;
+                    for (int i = 0; i < scheduler.getTaskCount(); i++)
+                        reply.tasks.push_back(scheduler.getTaskByIndex(i));
+                }
+            }
+            else if (command == "by-status")
+            {
+                if (!arity(args, 2, "by-status STATUS", reply)) return true;
+                if (!parseStatus(args[1], status))
+                    reply.fail("invalid status");
+                else if (!json)
+                    scheduler.displayTasksByStatus(status);
+                else
+                    list(scheduler.getTasksByStatus(status), reply);
+            }
+            else if (command == "by-priority")
+            {
+                if (!arity(args, 1, "by-priority", reply)) return true;
+                if (!json)
+                    scheduler.displayTasksByPriority();
+                else
+                    list(scheduler.getTasksByPriority(), reply);
+            }
+            else if (command == "overdue")
+            {
+                if (!arity(args, 1, "overdue", reply)) return true;
+                if (!json)
+                    scheduler.displayOverdueTasks();
+                else
+                    list(scheduler.getOverdueTasks(), reply);
+            }
+            else if (command == "due")
+            {
+                if (!arity(args, 2, "due HOURS", reply)) return true;
+                if (!parseNumber(args[1], number))
+                    reply.fail("invalid number of hours");
+                else if (!json)
+                    scheduler.displayTasksDueWithin(number);
+                else
+                    list(scheduler.getTasksDueWithin(number), reply);
+            }
+            else if (command == "structure")
+            {
+                if (!arity(args, 1, "structure", reply)) return true;
+                scheduler.displayTaskStructure();
+                if (json)
+                    reply.output = capture.str();
+            }
+            else if (command == "recur")
+            {
+                if (!arity(args, 6, "recur NAME DESCRIPTION PRIORITY DUE_AFTER SCHEDULE", reply)) return true;
+                if (!parseNumber(args[3], priority) || !RecurrenceRule::parseDuration(args[4], due))
+                    reply.fail("invalid priority or due-after duration");
+                else if ((reply.id = scheduler.addRecurringTask(args[1], args[2], priority, due, args[5])) == -1)
+                    reply.fail("invalid schedule");
+            }
+            else if (command == "unrecur")
+            {
+                if (!arity(args, 2, "unrecur RULE_ID", reply)) return true;
+                if (!parseNumber(args[1], id))
+                    reply.fail("invalid rule ID");
+                else if (!scheduler.removeRecurringTask(id))
+                    reply.fail("recurring task not found");
+            }
+            else if (command == "rules")
+            {
+                if (!arity(args, 1, "rules", reply)) return true;
+                scheduler.displayRecurringTasks();
+                if (json)
+                    reply.output = capture.str();
+            }
+            else if (command == "claim")
+            {
+                if (!arity(args, 2, "claim SECONDS", reply)) return true;
+                if (!parseNumber(args[1], number) || number <= 0)
+                    reply.fail("invalid lease duration");
+                else if ((reply.id = scheduler.claimNextTask(number, reply.token)) == -1)
+                    reply.fail("no tasks to claim");
+            }
+            else if (command == "heartbeat")
+            {
+                if (!arity(args, 4, "heartbeat ID TOKEN SECONDS", reply)) return true;
+                if (!parseNumber(args[1], id) || !parseNumber(args[2], token) || !parseNumber(args[3], number) || number <= 0)
+                    reply.fail("invalid ID, token or lease duration");
+                else if (!scheduler.heartbeatTask(id, token, number))
+                    reply.fail("lease not held");
+            }
+            else if (command == "complete" || command == "release")
+            {
+                if (!arity(args, 3, (command + " ID TOKEN").c_str(), reply)) return true;
+                if (!parseNumber(args[1], id) || !parseNumber(args[2], token))
+                    reply.fail("invalid ID or token");
+                else if (!scheduler.finishLeasedTask(id, token, command == "complete"))
+                    reply.fail("lease not held");
+            }
+            else if (command == "stats")
+            {
+                if (args.size() > 2 || (args.size() == 2 && args[1] != "prometheus"))
+                {
+                    reply.fail("usage: stats [prometheus]");
+                    return true;
+                }
+                if (args.size() == 2)
+                    writeMetricsPrometheus(cout);
+                else
+                    writeMetricsTable(cout);
+                if (json)
+                    reply.output = capture.str();
+            }
+            else if (command == "policy")
+            {
+                if (!arity(args, 2, "policy 0-3", reply)) return true;
+                if (!parseNumber(args[1], number) || number < POLICY_PRIORITY || number > POLICY_WEIGHTED)
+                    reply.fail("invalid policy");
+                else
+                    scheduler.setSchedulingPolicy((SchedulingPolicy)number);
+            }
+            else
+            {
+                return false;
+            }
+            return true;
+        }
+        void writeReply(int lineNumber, const string& command, const BatchReply& reply)
+        {
+            out << "{\"line\":" << lineNumber << ",\"command\":";
+            writeJsonString(out, command);
+            out << ",\"ok\":" << (reply.ok ? "true" : "false");
+            if (!reply.ok)
+            {
+                out << ",\"error\":";
+                writeJsonString(out, reply.error);
+            }
+            if (reply.id != -1)
+                out << ",\"id\":" << reply.id;
+            if (reply.token != 0)
+                out << ",\"token\":" << reply.token;
+            if (reply.listing)
+            {
+                out << ",\"tasks\":[";
+                for (size_t i = 0; i < reply.tasks.size(); i++)
+                {
+                    if (i) out << ',';
+                    writeTaskJson(out, *reply.tasks[i]);
+                }
+                out << ']';
+            }
+            if (!reply.output.empty())
+            {
+                out << ",\"output\":";
+                writeJsonString(out, reply.output);
+            }
+            out << "}\n";
+        }
+    public:
+        // From here until the session ends, cout goes to the batch writer (or,
+        // in JSON mode, nowhere).
+        explicit BatchSession(bool jsonOutput)
+            : json(jsonOutput), out(&writer), failures(0)
+        {
+            console = cout.rdbuf(json ? (streambuf*)&discard : &writer);
+        }
+        ~BatchSession()
+        {
+            cout.rdbuf(console);
+            writer.flush();
+        }
+        BatchSession(const BatchSession&) = delete;
+        BatchSession& operator=(const BatchSession&) = delete;
+        // What the current command has printed so far in JSON mode, for extra
+        // commands that report as text; empty otherwise.
+        string capturedOutput() const
+        {
+            return json ? capture.str() : string();
+        }
+
+        // Runs every command in input. extra(args, reply) handles program-specific
+        // commands and returns false for ones it does not know. Returns the
+        // number of commands that failed.
+        template <typename Scheduler, typename Extra>
+        int run(Scheduler& scheduler, istream& input, Extra extra)
+        {
+            string line;
+            vector<string> args;
+            int lineNumber = 0;
+            while (getline(input, line))
+            {
+                lineNumber++;
+                BatchReply reply;
+                bool parsed = splitCommand(line, args);
+                if (parsed && (args.empty() || args[0][0] == '#')) continue;
+                if (parsed && (args[0] == "quit" || args[0] == "exit")) break;
+
+                if (json)
+                {
+                    scheduler.checkDeadlines([this](Task* task) {
+                        out << "{\"event\":\"overdue\",\"task\":";
+                        writeTaskJson(out, *task);
+                        out << "}\n";
+                    });
+                    cout.rdbuf(&capture);
+                    capture.str("");
+                }
+                else
+                {
+                    scheduler.checkDeadlines();
+                }
+                if (!parsed)
+                    reply.fail("unterminated quote");
+                else if (!runCommon(scheduler, args, reply) && !extra(args, reply))
+                    reply.fail("unknown command: " + args[0]);
+                if (json)
+                    cout.rdbuf(&discard);
+
+                if (!reply.ok)
+                    failures++;
+                if (json)
+                    writeReply(lineNumber, parsed ? args[0] : string(), reply);
+                else if (!reply.ok)
+                    out << "Error on line " << lineNumber << ": " << reply.error << "\n";
+            }
+            return failures;
+        }
+        template <typename Scheduler>
+        int run(Scheduler& scheduler, istream& input)
+        {
+            return run(scheduler, input, [](const vector<string>&, BatchReply&) { return false; });
+        }
+};
+
+#endif
@@ -0,0 +1,507 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Checksum.h"
+
+using namespace std;
+
+// Fixed-size pages of one file, cached in a fixed number of frames. Pages are
+// read with pread on first use and written back with pwrite when evicted or
+// flushed; eviction picks frames with the clock (second chance) algorithm, so
+// a page touched since the hand last passed survives one more sweep.
+//
+// The first four bytes of every page hold a CRC32 of the rest, filled in on
+// write and checked on read, so a torn or stale page is reported instead of
+// being used.
+//
+// Changes become durable together at flush(). Before a page that existed at
+// the last flush is overwritten - by an eviction or by flush itself - its
+// image from then is appended to a rollback journal next to the file (path +
+// ".rollback") and the journal is synced. flush() syncs the file and then
+// empties the journal, which is the commit point. open() finds a journal that
+// still holds images after a crash, copies them back and cuts off pages added
+// since, returning the file to its state at the last flush.
+//   Journal: [8 "ROLLBACK"][u32 pages at the last flush][u32 crc of the 12
+//            bytes before], then [u32 crc of the rest][u32 page][image] records.
+class BufferPool
+{
+    public:
+        static const size_t PAGE_SIZE = 4096;
+    private:
+        struct Frame
+        {
+            uint32_t page;
+            int pins;
+            bool dirty;
+            bool referenced;
+            bool used;
+            char* data;
+        };
+        int fd;
+        vector<Frame> frames;
+        unordered_map<uint32_t, int> resident;     // page number -> frame
+        size_t hand;
+        char* memory;
+        string lastError;
+        long long reads;
+        long long writes;
+        int journalFd;
+        off_t journalBytes;
+        uint32_t committedPages;            // pages in the file at the last flush
+        unordered_set<uint32_t> saved;      // pages whose image from then is in the journal
+
+        static const size_t JOURNAL_HEADER = 16;
+        static const size_t JOURNAL_RECORD = 8 + PAGE_SIZE;
+
+        bool writeAt(int file, const char* data, size_t length, off_t offset)
+        {
+            size_t done = 0;
+            while (done < length)
+            {
+                ssize_t wrote = ::pwrite(file, data + done, length - done, offset + done);
+                if (wrote < 0)
+                {
+                    if (errno == EINTR) continue;
+                    lastError = string("write failed: ") + strerror(errno);
+                    return false;
+                }
+                done += wrote;
+            }
+            return true;
+        }
+        // Reads up to length bytes; returns how many, or -1 on error.
+        ssize_t readAt(int file, char* data, size_t length, off_t offset)
+        {
+            size_t done = 0;
+            while (done < length)
+            {
+                ssize_t got = ::pread(file, data + done, length - done, offset + done);
+                if (got < 0)
+                {
+                    if (errno == EINTR) continue;
+                    lastError = string("read failed: ") + strerror(errno);
+                    return -1;
+                }
+                if (got == 0) break;
+                done += got;
+            }
+            return done;
+        }
+        bool sync(int file)
+        {
+            if (::fsync(file) == 0) return true;
+            lastError = string("fsync failed: ") + strerror(errno);
+            return false;
+        }
+        // Replaces the journal with one that cuts the file back to pages long.
+        // The caller syncs it.
+        bool startJournal(uint32_t pages)
+        {
+            char header[JOURNAL_HEADER];
+            memcpy(header, "ROLLBACK", 8);
+            memcpy(header + 8, &pages, 4);
+            uint32_t crc = crc32(header, 12);
+            memcpy(header + 12, &crc, 4);
+            if (::ftruncate(journalFd, 0) != 0)
+            {
+                lastError = string("truncate failed: ") + strerror(errno);
+                return false;
+            }
+            if (!writeAt(journalFd, header, JOURNAL_HEADER, 0)) return false;
+            journalBytes = JOURNAL_HEADER;
+            saved.clear();
+            return true;
+        }
+        // Makes sure the journal holds the image from the last flush of every
+        // page in pages that existed then, syncing it once if anything was added.
+        // The first write after a flush starts a journal even if it only adds
+        // pages, so a crash cuts them off again.
+        bool saveCommitted(const vector<uint32_t>& pages)
+        {
+            if (pages.empty()) return true;
+            bool started = journalBytes == 0;
+            if (started && !startJournal(committedPages)) return false;
+            string records;
+            vector<uint32_t> added;
+            vector<char> image(PAGE_SIZE);
+            for (uint32_t page : pages)
+            {
+                if (page >= committedPages || saved.count(page)) continue;
+                if (readAt(fd, image.data(), PAGE_SIZE, (off_t)page * PAGE_SIZE) != (ssize_t)PAGE_SIZE)
+                {
+                    if (lastError.empty())
+                        lastError = "page " + to_string(page) + " is past the end of the file";
+                    return false;
+                }
+                size_t start = records.size();
+                records.append(4, '\0');
+                records.append(reinterpret_cast<const char*>(&page), 4);
+                records.append(image.data(), PAGE_SIZE);
+                uint32_t crc = crc32(records.data() + start + 4, 4 + PAGE_SIZE);
+                memcpy(&records[start], &crc, 4);
+                added.push_back(page);
+            }
+            if (added.empty()) return !started || sync(journalFd);
+            if (!writeAt(journalFd, records.data(), records.size(), journalBytes) || !sync(journalFd))
+                return false;
+            journalBytes += records.size();
+            saved.insert(added.begin(), added.end());
+            return true;
+        }
+        // Empties the journal once every page it protects has been synced.
+        bool commit()
+        {
+            if (journalBytes > 0 && ::ftruncate(journalFd, 0) != 0)
+            {
+                lastError = string("truncate failed: ") + strerror(errno);
+                return false;
+            }
+            if (journalBytes > 0 && !sync(journalFd)) return false;
+            journalBytes = 0;
+            saved.clear();
+            committedPages = filePages();
+            return true;
+        }
+        // Puts back the images a crash left in the journal and drops the pages
+        // added after them. A torn last record was never acted on: the journal
+        // is synced before any page it protects is written.
+        bool recover()
+        {
+            struct stat info;
+            if (fstat(journalFd, &info) != 0)
+            {
+                lastError = string("could not stat the rollback journal: ") + strerror(errno);
+                return false;
+            }
+            journalBytes = info.st_size;
+            char header[JOURNAL_HEADER];
+            uint32_t pages, crc;
+            if (journalBytes >= (off_t)JOURNAL_HEADER && readAt(journalFd, header, JOURNAL_HEADER, 0) == (ssize_t)JOURNAL_HEADER)
+            {
+                memcpy(&pages, header + 8, 4);
+                memcpy(&crc, header + 12, 4);
+                if (memcmp(header, "ROLLBACK", 8) == 0 && crc == crc32(header, 12))
+                {
+                    vector<char> record(JOURNAL_RECORD);
+                    for (off_t offset = JOURNAL_HEADER; offset + (off_t)JOURNAL_RECORD <= journalBytes; offset += JOURNAL_RECORD)
+                    {
+                        if (readAt(journalFd, record.data(), JOURNAL_RECORD, offset) != (ssize_t)JOURNAL_RECORD) return false;
+                        uint32_t page;
+                        memcpy(&crc, record.data(), 4);
+                        memcpy(&page, record.data() + 4, 4);
+                        if (crc != crc32(record.data() + 4, 4 + PAGE_SIZE)) break;
+                        if (!writeAt(fd, record.data() + 8, PAGE_SIZE, (off_t)page * PAGE_SIZE)) return false;
+                    }
+                    if (::ftruncate(fd, (off_t)pages * PAGE_SIZE) != 0)
+                    {
+                        lastError = string("truncate failed: ") + strerror(errno);
+                        return false;
+                    }
+                    if (!sync(fd)) return false;
+                }
+            }
+            return commit();
+        }
+
+        bool writeFrame(Frame& frame)
+        {
+            if (!saveCommitted({ frame.page })) return false;
+            uint32_t crc = crc32(frame.data + 4, PAGE_SIZE - 4);
+            memcpy(frame.data, &crc, 4);
+            if (!writeAt(fd, frame.data, PAGE_SIZE, (off_t)frame.page * PAGE_SIZE)) return false;
+            frame.dirty = false;
+            writes++;
+            return true;
+        }
+        bool readFrame(Frame& frame)
+        {
+            ssize_t got = readAt(fd, frame.data, PAGE_SIZE, (off_t)frame.page * PAGE_SIZE);
+            if (got < 0) return false;
+            if (got < (ssize_t)PAGE_SIZE)
+            {
+                lastError = "page " + to_string(frame.page) + " is past the end of the file";
+                return false;
+            }
+            uint32_t crc;
+            memcpy(&crc, frame.data, 4);
+            if (crc != crc32(frame.data + 4, PAGE_SIZE - 4))
+            {
+                lastError = "page " + to_string(frame.page) + " failed its checksum";
+                return false;
+            }
+            reads++;
+            return true;
+        }
+        // A frame to load a page into: a free one, or the clock's next victim.
+        // Returns -1 if every frame is pinned or the victim could not be written.
+        int victim()
+        {
+            for (size_t step = 0; step < 2 * frames.size() + 1; step++)
+            {
+                Frame& frame = frames[hand];
+                int index = hand;
+                hand = (hand + 1) % frames.size();
+                if (!frame.used) return index;
+                if (frame.pins > 0) continue;
+                if (frame.referenced)
+                {
+                    frame.referenced = false;
+                    continue;
+                }
+                if (frame.dirty && !writeFrame(frame)) return -1;
+                resident.erase(frame.page);
+                frame.used = false;
+                return index;
+            }
+            lastError = "every buffer frame is pinned";
+            return -1;
+        }
+    public:
+        explicit BufferPool(size_t frameCount = 256)
+            : fd(-1), frames(frameCount), hand(0), memory(nullptr), reads(0), writes(0),
+              journalFd(-1), journalBytes(0), committedPages(0)
+        {
+            memory = static_cast<char*>(aligned_alloc(PAGE_SIZE, frameCount * PAGE_SIZE));
+            for (size_t i = 0; i < frameCount; i++)
+                frames[i] = Frame{ 0, 0, false, false, false, memory + i * PAGE_SIZE };
+        }
+        ~BufferPool()
+        {
+            close();
+            free(memory);
+        }
+        BufferPool(const BufferPool&) = delete;
+        BufferPool& operator=(const BufferPool&) = delete;
+
+        // Opens path and its rollback journal, creating them if needed, and
+        // undoes any changes a crash left half written.
+        bool open(const string& path)
+        {
+            close();
+            string journalPath = path + ".rollback";
+            bool created = access(journalPath.c_str(), F_OK) != 0;
+            fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            if (fd != -1)
+                journalFd = ::open(journalPath.c_str(), O_RDWR | O_CREAT, 0644);
+            if (fd == -1 || journalFd == -1)
+            {
+                lastError = "could not open " + (fd == -1 ? path : journalPath) + ": " + strerror(errno);
+                close();
+                return false;
+            }
+            if (created)
+            {
+                // The journal only protects anything once its name is durable.
+                size_t slash = path.rfind('/');
+                string directory = slash == string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+                int directoryFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+                if (directoryFd != -1)
+                {
+                    ::fsync(directoryFd);
+                    ::close(directoryFd);
+                }
+            }
+            if (!recover())
+            {
+                string error = lastError;
+                close();
+                lastError = "could not roll back " + path + ": " + error;
+                return false;
+            }
+            return true;
+        }
+        // Drops every cached page without writing it. Changes since the last
+        // flush that already reached the file are rolled back by the next open().
+        void close()
+        {
+            for (Frame& frame : frames)
+            {
+                frame.used = false;
+                frame.dirty = false;
+                frame.pins = 0;
+            }
+            resident.clear();
+            if (fd != -1)
+                ::close(fd);
+            if (journalFd != -1)
+                ::close(journalFd);
+            fd = -1;
+            journalFd = -1;
+            journalBytes = 0;
+            saved.clear();
+        }
+        bool isOpen() const
+        {
+            return fd != -1;
+        }
+        // Pages the file holds, including a partial one at the end.
+        uint32_t filePages() const
+        {
+            struct stat info;
+            if (fd == -1 || fstat(fd, &info) != 0) return 0;
+            return (info.st_size + PAGE_SIZE - 1) / PAGE_SIZE;
+        }
+
+        // Pins page and returns its frame, reading it from disk unless fresh is
+        // set (a newly allocated page, which starts zeroed). nullptr on failure;
+        // see error().
+        char* pin(uint32_t page, bool fresh = false)
+        {
+            auto it = resident.find(page);
+            if (it != resident.end())
+            {
+                Frame& frame = frames[it->second];
+                frame.pins++;
+                frame.referenced = true;
+                if (fresh)
+                {
+                    memset(frame.data, 0, PAGE_SIZE);
+                    frame.dirty = true;
+                }
+                return frame.data;
+            }
+            int index = victim();
+            if (index == -1) return nullptr;
+            Frame& frame = frames[index];
+            frame.page = page;
+            if (fresh)
+                memset(frame.data, 0, PAGE_SIZE);
+            else if (!readFrame(frame))
+                return nullptr;
+            frame.used = true;
+            frame.pins = 1;
+            frame.dirty = fresh;
+            frame.referenced = true;
+            resident[page] = index;
+            return frame.data;
+        }
+        void unpin(uint32_t page, bool dirtied)
+        {
+            Frame& frame = frames[resident.at(page)];
+            frame.pins--;
+            frame.dirty = frame.dirty || dirtied;
+        }
+        // Writes every dirty page back and, if durable is set, fsyncs the file
+        // and commits: the changes survive a crash from here on.
+        bool flush(bool durable = true)
+        {
+            vector<uint32_t> dirty;
+            for (Frame& frame : frames)
+            {
+                if (frame.used && frame.dirty)
+                    dirty.push_back(frame.page);
+            }
+            if (!saveCommitted(dirty)) return false;
+            for (Frame& frame : frames)
+            {
+                if (frame.used && frame.dirty && !writeFrame(frame))
+                    return false;
+            }
+            return !durable || (sync(fd) && commit());
+        }
+        // Forgets every cached page and truncates the file to nothing. The
+        // journal is pointed at the empty file first, so a crash part way
+        // through still leaves it empty.
+        bool truncate()
+        {
+            for (Frame& frame : frames)
+            {
+                frame.used = false;
+                frame.dirty = false;
+                frame.pins = 0;
+            }
+            resident.clear();
+            if (!startJournal(0) || !sync(journalFd)) return false;
+            if (::ftruncate(fd, 0) != 0)
+            {
+                lastError = string("truncate failed: ") + strerror(errno);
+                return false;
+            }
+            return sync(fd) && commit();
+        }
+        const string& error() const
+        {
+            return lastError;
+        }
+        long long pageReads() const
+        {
+            return reads;
+        }
+        long long pageWrites() const
+        {
+            return writes;
+        }
+};
+
+// Pins a page for the lifetime of the object; markDirty() before changing it.
+class PageRef
+{
+    private:
+        BufferPool* pool;
+        uint32_t number;
+        char* bytes;
+        bool dirty;
+    public:
+        PageRef() : pool(nullptr), number(0), bytes(nullptr), dirty(false) {}
+        PageRef(BufferPool& owner, uint32_t page, bool fresh = false)
+            : pool(&owner), number(page), bytes(owner.pin(page, fresh)), dirty(fresh) {}
+        PageRef(PageRef&& other) noexcept
+            : pool(other.pool), number(other.number), bytes(other.bytes), dirty(other.dirty)
+        {
+            other.bytes = nullptr;
+        }
+        PageRef& operator=(PageRef&& other) noexcept
+        {
+            if (this != &other)
+            {
+                release();
+                pool = other.pool;
+                number = other.number;
+                bytes = other.bytes;
+                dirty = other.dirty;
+                other.bytes = nullptr;
+            }
+            return *this;
+        }
+        PageRef(const PageRef&) = delete;
+        PageRef& operator=(const PageRef&) = delete;
+        ~PageRef()
+        {
+            release();
+        }
+        void release()
+        {
+            if (bytes)
+                pool->unpin(number, dirty);
+            bytes = nullptr;
+        }
+        explicit operator bool() const
+        {
+            return bytes != nullptr;
+        }
+        uint32_t page() const
+        {
+            return number;
+        }
+        char* data() const
+        {
+            return bytes;
+        }
+        void markDirty()
+        {
+            dirty = true;
+        }
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef CHANGELOG_H
+#define CHANGELOG_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// Which task IDs changed at which version, for "changes since version N"
+// queries. Every record() takes the next version number. Only the newest
+// entries are kept (about twice the limit), so a reader further behind than
+// that, or one that predates a reset(), must reload everything.
+//
+// Versions start at the current time in microseconds rather than 0, so they
+// keep increasing across restarts and a version from an earlier run is never
+// mistaken for one from this run.
+class ChangeLog
+{
+    private:
+        struct Entry
+        {
+            uint64_t version;
+            int taskId;
+        };
+        vector<Entry> entries;
+        uint64_t current;
+        uint64_t floor;     // versions before this one are no longer covered
+        size_t limit;
+    public:
+        explicit ChangeLog(size_t keep = 1 << 16)
+            : current(chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count()),
+              floor(current), limit(keep) {}
+        uint64_t version() const
+        {
+            return current;
+        }
+        void record(int taskId)
+        {
+            entries.push_back({++current, taskId});
+            if (entries.size() >= 2 * limit)
+            {
+                entries.erase(entries.begin(), entries.end() - limit);
+                floor = entries.front().version - 1;
+            }
+        }
+        // Every task may have changed (a reload or import).
+        void reset()
+        {
+            entries.clear();
+            floor = ++current;
+        }
+        // IDs changed after version since, each once and in ascending order.
+        // Returns false if since is outside the window the log still covers.
+        bool changedSince(uint64_t since, vector<int>& taskIds) const
+        {
+            taskIds.clear();
+            if (since < floor || since > current)
+                return false;
+            auto first = upper_bound(entries.begin(), entries.end(), since, [](uint64_t v, const Entry& e) {
+                return v < e.version;
+            });
+            for (auto it = first; it != entries.end(); ++it)
+                taskIds.push_back(it->taskId);
+            sort(taskIds.begin(), taskIds.end());
+            taskIds.erase(unique(taskIds.begin(), taskIds.end()), taskIds.end());
+            return true;
+        }
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+
+struct Crc32Table
+{
+    uint32_t entries[256];
+    Crc32Table()
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[i] = c;
+        }
+    }
+};
+
+// CRC-32 (IEEE 802.3, reflected) used to detect torn or corrupted records on disk.
+// Pass the previous result as crc to checksum data in pieces.
+inline uint32_t crc32(const void* data, size_t length, uint32_t crc = 0)
+{
+    static const Crc32Table table;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++)
+        crc = table.entries[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+#endif
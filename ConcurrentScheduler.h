@@ -0,0 +1,541 @@
+#ifndef CONCURRENTSCHEDULER_H
+#define CONCURRENTSCHEDULER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "EpochDomain.h"
+#include "Task.h"
+
+// Task ID -> Task map with multi-version records. Each ID holds a chain of
+// immutable versions, newest first; a write copies the newest version, changes
+// the copy and links it in front, stamped from EpochDomain's commit clock.
+// Writers to the same ID serialize on one of a set of striped locks, so threads
+// touching different IDs rarely contend.
+//
+// Readers take no locks at all. snapshot() returns a consistent point-in-time
+// view that can be iterated for as long as needed while writes carry on; get()
+// reads the newest committed version. Versions no snapshot can see any more
+// are unlinked by later writes and handed to the epoch domain for deletion.
+//
+// Chains hang off a three-level radix array indexed by task ID, so lookups
+// need no hashing and a scan visits IDs in order.
+class ConcurrentTaskMap
+{
+    private:
+        struct Version
+        {
+            Task task;
+            atomic<uint64_t> stamp;     // EpochDomain::PENDING until committed
+            atomic<Version*> older;
+            bool removed;               // a tombstone: the task was erased
+            Version(const Task& state, bool erased, Version* previous)
+                : task(state), stamp(EpochDomain::PENDING), older(previous), removed(erased) {}
+        };
+        static const int LEAF_BITS = 12;
+        static const int MID_BITS = 10;
+        static const int TOP_BITS = 31 - LEAF_BITS - MID_BITS;
+        struct Leaf
+        {
+            atomic<Version*> heads[1 << LEAF_BITS] = {};
+        };
+        struct Mid
+        {
+            atomic<Leaf*> leaves[1 << MID_BITS] = {};
+        };
+        struct Stripe
+        {
+            mutex lock;
+            deque<int> unpruned;    // IDs whose old versions were still visible when last written
+        };
+        atomic<Mid*> top[1 << TOP_BITS] = {};
+        mutex growLock;
+        vector<unique_ptr<Stripe>> stripes;
+        uint32_t mask;
+        atomic<int> liveCount;
+        atomic<int> highestId;
+
+        Stripe& stripeFor(int taskId) const
+        {
+            return *stripes[(uint32_t)taskId & mask];
+        }
+        // The chain head for taskId, or nullptr if no leaf covers it yet and
+        // create is not set.
+        atomic<Version*>* headFor(int taskId, bool create)
+        {
+            uint32_t id = taskId;
+            Mid* mid = top[id >> (LEAF_BITS + MID_BITS)].load(memory_order_acquire);
+            Leaf* leaf = mid ? mid->leaves[(id >> LEAF_BITS) & ((1 << MID_BITS) - 1)].load(memory_order_acquire) : nullptr;
+            if (!leaf)
+            {
+                if (!create) return nullptr;
+                lock_guard<mutex> guard(growLock);
+                atomic<Mid*>& midSlot = top[id >> (LEAF_BITS + MID_BITS)];
+                if (!(mid = midSlot.load(memory_order_relaxed)))
+                {
+                    mid = new Mid();
+                    midSlot.store(mid, memory_order_release);
+                }
+                atomic<Leaf*>& leafSlot = mid->leaves[(id >> LEAF_BITS) & ((1 << MID_BITS) - 1)];
+                if (!(leaf = leafSlot.load(memory_order_relaxed)))
+                {
+                    leaf = new Leaf();
+                    leafSlot.store(leaf, memory_order_release);
+                }
+            }
+            return &leaf->heads[id & ((1 << LEAF_BITS) - 1)];
+        }
+        const atomic<Version*>* headFor(int taskId) const
+        {
+            return const_cast<ConcurrentTaskMap*>(this)->headFor(taskId, false);
+        }
+        // The newest version committed at or before stamp. A version still being
+        // committed is waited for: its stamp may turn out to be at or before ours.
+        static const Version* visible(const atomic<Version*>& head, uint64_t stamp)
+        {
+            for (const Version* version = head.load(memory_order_acquire); version; version = version->older.load(memory_order_acquire))
+            {
+                uint64_t committed;
+                while ((committed = version->stamp.load(memory_order_acquire)) == EpochDomain::PENDING)
+                    this_thread::yield();
+                if (committed <= stamp)
+                    return version->removed ? nullptr : version;
+            }
+            return nullptr;
+        }
+        // The newest committed version. Versions behind it may be pruned at any
+        // time, so this is for reads that want the latest state, not a snapshot.
+        static const Version* latest(const atomic<Version*>& head)
+        {
+            for (const Version* version = head.load(memory_order_acquire); version; version = version->older.load(memory_order_acquire))
+            {
+                if (version->stamp.load(memory_order_acquire) != EpochDomain::PENDING)
+                    return version->removed ? nullptr : version;
+            }
+            return nullptr;
+        }
+        // Unlinks and retires the versions of taskId no snapshot can see: those
+        // behind the newest version committed at or before the oldest snapshot.
+        // Returns false if older versions have to stay for now. Stripe lock held.
+        bool prune(int taskId)
+        {
+            EpochDomain& domain = EpochDomain::global();
+            atomic<Version*>& head = *headFor(taskId, false);
+            Version* keep = head.load(memory_order_relaxed);
+            if (!keep) return true;     // already pruned down to nothing
+            uint64_t horizon = domain.oldestSnapshot(domain.currentStamp());
+            while (keep && keep->stamp.load(memory_order_relaxed) > horizon)
+                keep = keep->older.load(memory_order_relaxed);
+            if (!keep) return false;
+            // A tombstone nobody can see past takes the whole chain with it.
+            Version* garbage;
+            if (keep->removed && keep == head.load(memory_order_relaxed))
+            {
+                head.store(nullptr);
+                garbage = keep;
+            }
+            else
+            {
+                garbage = keep->older.exchange(nullptr);
+            }
+            for (Version* version = garbage; version; )
+            {
+                Version* older = version->older.load(memory_order_relaxed);
+                domain.retire(version);
+                version = older;
+            }
+            Version* newest = head.load(memory_order_relaxed);
+            return !newest || (!newest->removed && !newest->older.load(memory_order_relaxed));
+        }
+        // Links a new version in front of taskId's chain and commits it. Stripe lock held.
+        void install(Stripe& stripe, int taskId, const Task& state, bool erased)
+        {
+            atomic<Version*>& head = *headFor(taskId, true);
+            Version* previous = head.load(memory_order_relaxed);
+            bool wasClean = !previous || (!previous->removed && !previous->older.load(memory_order_relaxed));
+            Version* version = new Version(state, erased, previous);
+            head.store(version, memory_order_release);
+            version->stamp.store(EpochDomain::global().commitStamp(), memory_order_release);
+            // Old versions a snapshot still needed when they were superseded are
+            // pruned by later writes to the stripe, a couple at a time.
+            for (int i = 0; i < 2 && !stripe.unpruned.empty(); i++)
+            {
+                int id = stripe.unpruned.front();
+                stripe.unpruned.pop_front();
+                if (!prune(id))
+                    stripe.unpruned.push_back(id);
+            }
+            if (!prune(taskId) && wasClean)
+                stripe.unpruned.push_back(taskId);
+        }
+        const Version* newest(int taskId) const
+        {
+            const atomic<Version*>* head = headFor(taskId);
+            const Version* version = head ? head->load(memory_order_acquire) : nullptr;
+            return version && !version->removed ? version : nullptr;
+        }
+    public:
+        // A consistent view of the map as of one commit stamp. Holding it keeps
+        // the versions it can see alive without blocking writers; it must be
+        // used and destroyed on the thread that took it.
+        class Snapshot
+        {
+            private:
+                const ConcurrentTaskMap& map;
+                EpochDomain::Guard guard;
+                uint64_t stamp;
+            public:
+                explicit Snapshot(const ConcurrentTaskMap& source)
+                    : map(source), guard(), stamp(EpochDomain::global().publishSnapshot()) {}
+                ~Snapshot()
+                {
+                    EpochDomain::global().unpublishSnapshot();
+                }
+                Snapshot(const Snapshot&) = delete;
+                Snapshot& operator=(const Snapshot&) = delete;
+                uint64_t version() const
+                {
+                    return stamp;
+                }
+                bool get(int taskId, Task& out) const
+                {
+                    const atomic<Version*>* head = taskId < 0 ? nullptr : map.headFor(taskId);
+                    const Version* version = head ? visible(*head, stamp) : nullptr;
+                    if (!version) return false;
+                    out = version->task;
+                    return true;
+                }
+                // Calls visit(task) for every task in the snapshot, in ID order.
+                template <typename Visit>
+                void forEach(Visit visit) const
+                {
+                    int last = map.highestId.load(memory_order_acquire);
+                    for (int id = 0; id <= last; id += 1 << LEAF_BITS)
+                    {
+                        const atomic<Version*>* heads = map.headFor(id);
+                        if (!heads) continue;
+                        for (int i = 0; i < (1 << LEAF_BITS) && id + i <= last; i++)
+                        {
+                            const Version* version = visible(heads[i], stamp);
+                            if (version)
+                                visit(version->task);
+                        }
+                    }
+                }
+        };
+
+        explicit ConcurrentTaskMap(int stripeCount = 64) : liveCount(0), highestId(-1)
+        {
+            uint32_t count = 1;
+            while ((int)count < stripeCount)
+                count <<= 1;
+            mask = count - 1;
+            for (uint32_t i = 0; i < count; i++)
+                stripes.push_back(unique_ptr<Stripe>(new Stripe()));
+        }
+        // No reader or writer may still be using the map.
+        ~ConcurrentTaskMap()
+        {
+            for (atomic<Mid*>& midSlot : top)
+            {
+                Mid* mid = midSlot.load();
+                if (!mid) continue;
+                for (atomic<Leaf*>& leafSlot : mid->leaves)
+                {
+                    Leaf* leaf = leafSlot.load();
+                    if (!leaf) continue;
+                    for (atomic<Version*>& head : leaf->heads)
+                    {
+                        for (Version* version = head.load(); version; )
+                        {
+                            Version* older = version->older.load();
+                            delete version;
+                            version = older;
+                        }
+                    }
+                    delete leaf;
+                }
+                delete mid;
+            }
+        }
+        ConcurrentTaskMap(const ConcurrentTaskMap&) = delete;
+        ConcurrentTaskMap& operator=(const ConcurrentTaskMap&) = delete;
+
+        // Task IDs must not be negative.
+        void insert(const Task& task)
+        {
+            Stripe& stripe = stripeFor(task.taskId);
+            lock_guard<mutex> guard(stripe.lock);
+            EpochDomain::Guard epoch;
+            if (!newest(task.taskId))
+                liveCount.fetch_add(1, memory_order_relaxed);
+            install(stripe, task.taskId, task, false);
+            int highest = highestId.load(memory_order_relaxed);
+            while (task.taskId > highest && !highestId.compare_exchange_weak(highest, task.taskId, memory_order_release)) {}
+        }
+        // The newest committed state of taskId.
+        bool get(int taskId, Task& out) const
+        {
+            EpochDomain::Guard epoch;
+            const atomic<Version*>* head = taskId < 0 ? nullptr : headFor(taskId);
+            const Version* version = head ? latest(*head) : nullptr;
+            if (!version) return false;
+            out = version->task;
+            return true;
+        }
+        bool erase(int taskId)
+        {
+            Stripe& stripe = stripeFor(taskId);
+            lock_guard<mutex> guard(stripe.lock);
+            EpochDomain::Guard epoch;
+            const Version* current = newest(taskId);
+            if (!current) return false;
+            install(stripe, taskId, current->task, true);
+            liveCount.fetch_sub(1, memory_order_relaxed);
+            return true;
+        }
+        // Runs update(task) on a copy of the newest version under the stripe
+        // lock and commits the copy if it returns true. Returns false if the ID
+        // is unknown or update declined.
+        template <typename Update>
+        bool update(int taskId, Update update)
+        {
+            Stripe& stripe = stripeFor(taskId);
+            lock_guard<mutex> guard(stripe.lock);
+            EpochDomain::Guard epoch;
+            const Version* current = newest(taskId);
+            if (!current) return false;
+            Task copy = current->task;
+            if (!update(copy)) return false;
+            install(stripe, taskId, copy, false);
+            return true;
+        }
+        int size() const
+        {
+            return liveCount.load(memory_order_relaxed);
+        }
+        Snapshot snapshot() const
+        {
+            return Snapshot(*this);
+        }
+};
+
+// Thread-safe counterpart of TaskScheduler for many producers and consumers.
+//
+// Ready tasks wait in a set of max-heaps, one lock each. Entries are ordered by
+// priority and then by arrival (FIFO). Every heap publishes its best key in an
+// atomic so consumers can pick a heap without locking any of them.
+//   STRICT  - pop scans every heap's published top and takes the best; the
+//             result is the highest-priority task apart from inserts racing
+//             with the scan.
+//   RELAXED - MultiQueue: push to a random heap, pop the better of two random
+//             heaps. Expected rank error is O(number of heaps), in exchange
+//             for pops that almost never wait on a lock.
+// Heap entries hold only (key, task ID); removed or already-claimed tasks are
+// skipped when their entry surfaces.
+class ConcurrentScheduler
+{
+    public:
+        enum QueueMode
+        {
+            STRICT,
+            RELAXED
+        };
+        typedef ConcurrentTaskMap::Snapshot Snapshot;
+    private:
+        static constexpr uint64_t EMPTY_KEY = 0;
+        struct Entry
+        {
+            uint64_t key;
+            int taskId;
+            bool operator<(const Entry& other) const
+            {
+                return key < other.key;
+            }
+        };
+        struct QueueShard
+        {
+            mutex lock;
+            vector<Entry> heap;
+            atomic<uint64_t> topKey;     // EMPTY_KEY while the heap is empty
+            QueueShard() : topKey(EMPTY_KEY) {}
+        };
+        QueueMode mode;
+        vector<unique_ptr<QueueShard>> queues;
+        ConcurrentTaskMap tasks;
+        atomic<int> nextTaskId;
+        atomic<uint32_t> sequence;
+        atomic<int> queuedCount;
+        // Priority in the high half, biased so negative priorities sort below
+        // positive ones without shifting a negative value, and inverted arrival
+        // order in the low half: a larger key always means "run sooner". The low
+        // half is never zero, so no real key equals EMPTY_KEY.
+        uint64_t makeKey(int priority)
+        {
+            uint32_t arrival = sequence.fetch_add(1, memory_order_relaxed) % 0xFFFFFFFFu;
+            uint64_t biased = (uint32_t)priority ^ 0x80000000u;
+            return (biased << 32) | (0xFFFFFFFFu - arrival);
+        }
+        static uint32_t threadRandom()
+        {
+            static thread_local minstd_rand engine(random_device{}());
+            return engine();
+        }
+        void publishTop(QueueShard& queue)
+        {
+            queue.topKey.store(queue.heap.empty() ? EMPTY_KEY : queue.heap.front().key, memory_order_release);
+        }
+        void pushEntry(Entry entry)
+        {
+            QueueShard& queue = *queues[threadRandom() % queues.size()];
+            lock_guard<mutex> guard(queue.lock);
+            queue.heap.push_back(entry);
+            push_heap(queue.heap.begin(), queue.heap.end());
+            publishTop(queue);
+            queuedCount.fetch_add(1, memory_order_relaxed);
+        }
+        bool popFrom(QueueShard& queue, Entry& entry, bool wait)
+        {
+            unique_lock<mutex> guard(queue.lock, defer_lock);
+            if (wait)
+                guard.lock();
+            else if (!guard.try_lock())
+                return false;
+            if (queue.heap.empty()) return false;
+            pop_heap(queue.heap.begin(), queue.heap.end());
+            entry = queue.heap.back();
+            queue.heap.pop_back();
+            publishTop(queue);
+            queuedCount.fetch_sub(1, memory_order_relaxed);
+            return true;
+        }
+        bool popStrict(Entry& entry)
+        {
+            while (queuedCount.load(memory_order_relaxed) > 0)
+            {
+                int best = -1;
+                uint64_t bestKey = EMPTY_KEY;
+                for (size_t i = 0; i < queues.size(); i++)
+                {
+                    uint64_t key = queues[i]->topKey.load(memory_order_acquire);
+                    if (key > bestKey)
+                    {
+                        bestKey = key;
+                        best = i;
+                    }
+                }
+                if (best == -1) return false;
+                if (popFrom(*queues[best], entry, true))
+                    return true;
+            }
+            return false;
+        }
+        bool popRelaxed(Entry& entry)
+        {
+            while (queuedCount.load(memory_order_relaxed) > 0)
+            {
+                for (int attempt = 0; attempt < 8; attempt++)
+                {
+                    QueueShard& a = *queues[threadRandom() % queues.size()];
+                    QueueShard& b = *queues[threadRandom() % queues.size()];
+                    QueueShard& better = a.topKey.load(memory_order_acquire) >= b.topKey.load(memory_order_acquire) ? a : b;
+                    if (better.topKey.load(memory_order_relaxed) != EMPTY_KEY && popFrom(better, entry, false))
+                        return true;
+                }
+                // Mostly empty: fall back to a locked sweep so pop never misses work.
+                for (const unique_ptr<QueueShard>& queue : queues)
+                {
+                    if (popFrom(*queue, entry, true))
+                        return true;
+                }
+            }
+            return false;
+        }
+    public:
+        // queueCount 0 picks twice the hardware thread count, the usual MultiQueue factor.
+        explicit ConcurrentScheduler(QueueMode queueMode = RELAXED, int queueCount = 0)
+            : mode(queueMode), nextTaskId(1), sequence(0), queuedCount(0)
+        {
+            if (queueCount <= 0)
+                queueCount = 2 * max(1u, thread::hardware_concurrency());
+            for (int i = 0; i < queueCount; i++)
+                queues.push_back(unique_ptr<QueueShard>(new QueueShard()));
+        }
+        QueueMode getMode() const
+        {
+            return mode;
+        }
+        int addTask(const string& name, const string& description, TaskStatus status, int priority, time_t dueDate)
+        {
+            int id = nextTaskId.fetch_add(1);
+            tasks.insert(Task(id, name, description, status, priority, dueDate));
+            if (status == PENDING)
+                pushEntry(Entry{ makeKey(priority), id });
+            return id;
+        }
+        // Claims the most urgent pending task (exactly or approximately, per mode),
+        // marks it IN_PROGRESS and copies it to out.
+        bool pop(Task& out)
+        {
+            Entry entry;
+            while (mode == STRICT ? popStrict(entry) : popRelaxed(entry))
+            {
+                bool claimed = tasks.update(entry.taskId, [&](Task& task) {
+                    if (task.taskStatus != PENDING) return false;
+                    task.taskStatus = IN_PROGRESS;
+                    out = task;
+                    return true;
+                });
+                if (claimed) return true;
+            }
+            return false;
+        }
+        bool completeTask(int taskId)
+        {
+            return tasks.update(taskId, [](Task& task) {
+                if (task.taskStatus != COMPLETED)
+                    task.completeTask();
+                return true;
+            });
+        }
+        // Puts a claimed task back in the queue, e.g. after its worker gave up on it.
+        bool releaseTask(int taskId)
+        {
+            int priority = 0;
+            bool released = tasks.update(taskId, [&](Task& task) {
+                if (task.taskStatus != IN_PROGRESS) return false;
+                task.taskStatus = PENDING;
+                priority = task.taskPriority;
+                return true;
+            });
+            if (released)
+                pushEntry(Entry{ makeKey(priority), taskId });
+            return released;
+        }
+        bool removeTask(int taskId)
+        {
+            return tasks.erase(taskId);
+        }
+        bool getTask(int taskId, Task& out) const
+        {
+            return tasks.get(taskId, out);
+        }
+        int getTaskCount() const
+        {
+            return tasks.size();
+        }
+        // A point-in-time view of every task for listings and exports. Writers
+        // carry on while it is iterated and never wait for it.
+        Snapshot snapshot() const
+        {
+            return tasks.snapshot();
+        }
+};
+
+#endif
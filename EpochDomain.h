@@ -0,0 +1,213 @@
+#ifndef EPOCHDOMAIN_H
+#define EPOCHDOMAIN_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Epoch-based reclamation for data read without locks, plus the commit clock
+// and snapshot registry that multi-version readers need.
+//
+// A reader enters the domain (Guard) before following shared pointers and
+// leaves when it is done. A writer that unlinks an object retires it instead of
+// deleting it; the object is deleted once the global epoch has advanced twice
+// past the retirement, which can only happen after every reader that was inside
+// at the time has left. Readers never wait for writers and writers never wait
+// for readers: a long reader only delays reclamation.
+//
+// Writers stamp every committed version from one process-wide clock. A reader
+// that wants a consistent view publishes the stamp it reads at; writers may
+// discard an old version only if no published stamp can still see it.
+//
+// Each thread uses a slot of its own, found through a thread_local. Slots are
+// never freed: one outlives its thread, keeps any objects still waiting to be
+// deleted, and is handed to the next thread that starts using the domain.
+class EpochDomain
+{
+    public:
+        static const uint64_t PENDING = UINT64_MAX;    // stamp of a write not yet committed
+    private:
+        struct Retired
+        {
+            void* object;
+            void (*destroy)(void*);
+            uint64_t epoch;
+        };
+        struct Slot
+        {
+            atomic<uint64_t> epoch{0};      // global epoch on entry; 0 while outside
+            atomic<uint64_t> snapshot{0};   // published read stamp; 0 when none
+            atomic<bool> inUse{false};
+            int depth = 0;
+            int snapshotDepth = 0;
+            vector<Retired> retired;
+            Slot* next = nullptr;
+        };
+        // Returns the thread's slot to the domain when the thread exits.
+        struct Lease
+        {
+            Slot* slot = nullptr;
+            ~Lease()
+            {
+                if (slot)
+                {
+                    global().collect(*slot);
+                    slot->inUse.store(false, memory_order_release);
+                }
+            }
+        };
+        static const size_t COLLECT_EVERY = 64;
+
+        atomic<uint64_t> globalEpoch;
+        atomic<uint64_t> clock;
+        atomic<Slot*> slots;    // push-only list
+
+        EpochDomain() : globalEpoch(1), clock(1), slots(nullptr) {}
+
+        Slot* take()
+        {
+            for (Slot* slot = slots.load(memory_order_acquire); slot; slot = slot->next)
+            {
+                bool idle = false;
+                if (!slot->inUse.load(memory_order_relaxed) &&
+                    slot->inUse.compare_exchange_strong(idle, true, memory_order_acquire))
+                    return slot;
+            }
+            Slot* slot = new Slot();
+            slot->inUse.store(true, memory_order_relaxed);
+            slot->next = slots.load(memory_order_relaxed);
+            while (!slots.compare_exchange_weak(slot->next, slot, memory_order_release, memory_order_relaxed)) {}
+            return slot;
+        }
+        Slot& threadSlot()
+        {
+            static thread_local Lease lease;
+            if (!lease.slot)
+                lease.slot = take();
+            return *lease.slot;
+        }
+        // Moves the epoch on if every reader inside has seen the current one.
+        void tryAdvance()
+        {
+            uint64_t epoch = globalEpoch.load();
+            for (Slot* slot = slots.load(memory_order_acquire); slot; slot = slot->next)
+            {
+                uint64_t seen = slot->epoch.load();
+                if (seen != 0 && seen != epoch) return;
+            }
+            globalEpoch.compare_exchange_strong(epoch, epoch + 1);
+        }
+        // Deletes the slot's retired objects that no reader can still reach.
+        void collect(Slot& slot)
+        {
+            tryAdvance();
+            uint64_t epoch = globalEpoch.load();
+            size_t freed = 0;
+            while (freed < slot.retired.size() && slot.retired[freed].epoch + 2 <= epoch)
+            {
+                slot.retired[freed].destroy(slot.retired[freed].object);
+                freed++;
+            }
+            slot.retired.erase(slot.retired.begin(), slot.retired.begin() + freed);
+        }
+    public:
+        // Never destroyed, so threads that exit during shutdown can still return their slots.
+        static EpochDomain& global()
+        {
+            static EpochDomain* domain = new EpochDomain();
+            return *domain;
+        }
+        EpochDomain(const EpochDomain&) = delete;
+        EpochDomain& operator=(const EpochDomain&) = delete;
+
+        // Keeps every object reachable on entry alive until the guard is destroyed.
+        // Guards nest, and must be destroyed on the thread that created them.
+        class Guard
+        {
+            private:
+                Slot& slot;
+            public:
+                Guard() : slot(global().threadSlot())
+                {
+                    if (slot.depth++ > 0) return;
+                    // Re-check so an advance that missed this slot cannot pass it by.
+                    uint64_t epoch;
+                    do
+                    {
+                        epoch = global().globalEpoch.load();
+                        slot.epoch.store(epoch);
+                    } while (global().globalEpoch.load() != epoch);
+                }
+                ~Guard()
+                {
+                    if (--slot.depth == 0)
+                        slot.epoch.store(0, memory_order_release);
+                }
+                Guard(const Guard&) = delete;
+                Guard& operator=(const Guard&) = delete;
+        };
+
+        // Deletes object once no reader can reach it any more. The caller must
+        // already have unlinked it from every shared structure.
+        template <typename T>
+        void retire(T* object)
+        {
+            Slot& slot = threadSlot();
+            slot.retired.push_back(Retired{ object, [](void* p) { delete static_cast<T*>(p); }, globalEpoch.load() });
+            if (slot.retired.size() % COLLECT_EVERY == 0)
+                collect(slot);
+        }
+
+        // A new commit stamp, later than every stamp handed out so far.
+        uint64_t commitStamp()
+        {
+            return clock.fetch_add(1) + 1;
+        }
+        uint64_t currentStamp() const
+        {
+            return clock.load();
+        }
+        // Publishes and returns a read stamp: every version committed at or
+        // before it is visible to the reader, and stays so until it calls
+        // unpublishSnapshot(). Call from inside a Guard.
+        uint64_t publishSnapshot()
+        {
+            Slot& slot = threadSlot();
+            if (slot.snapshotDepth++ > 0)
+                return clock.load();    // an older stamp is already published
+            // Retry until the clock holds still across the publication, so a
+            // writer that did not see it read the clock no later than this did.
+            uint64_t stamp;
+            do
+            {
+                stamp = clock.load();
+                slot.snapshot.store(stamp);
+            } while (clock.load() != stamp);
+            return stamp;
+        }
+        void unpublishSnapshot()
+        {
+            Slot& slot = threadSlot();
+            if (--slot.snapshotDepth == 0)
+                slot.snapshot.store(0, memory_order_release);
+        }
+        // Oldest stamp any reader may read at. A writer reads the clock, then
+        // calls this; versions superseded at or before the result are garbage.
+        uint64_t oldestSnapshot(uint64_t now) const
+        {
+            uint64_t oldest = now;
+            for (Slot* slot = slots.load(memory_order_acquire); slot; slot = slot->next)
+            {
+                uint64_t stamp = slot->snapshot.load();
+                if (stamp != 0)
+                    oldest = min(oldest, stamp);
+            }
+            return oldest;
+        }
+};
+
+#endif
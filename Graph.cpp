@@ -1,11 +1,153 @@
 #include "Graph.h"
 
 Graph::Graph() {
-    for (int i = 0; i < MAX_TASKS; i++)
-        for (int j = 0; j < MAX_TASKS; j++)
-            adjMatrix[i][j] = 0;
+    overlayEdges = 0;
+    offsets.push_back(0);
 }
 
-void Graph::addDependency(int from, int to) {
-    adjMatrix[from][to] = 1;
+long long Graph::edgeKey(int from, int to) {
+    return ((long long)from << 32) | (unsigned int)to;
+}
+
+void Graph::addTask(int id) {
+    if (id < (int)inDegree.size())
+        return;
+    inDegree.resize(id + 1, 0);
+    completed.resize(id + 1, 0);
+    added.resize(id + 1);
+}
+
+bool Graph::inCompacted(int from, int to) const {
+    if (from + 1 >= (int)offsets.size())
+        return false;
+    for (int i = offsets[from]; i < offsets[from + 1]; i++) {
+        if (targets[i] == to)
+            return true;
+    }
+    return false;
+}
+
+bool Graph::hasDependency(int from, int to) const {
+    if (from < 0 || to < 0)
+        return false;
+    if (inCompacted(from, to) && !removed.count(edgeKey(from, to)))
+        return true;
+    if (from < (int)added.size()) {
+        for (int target : added[from]) {
+            if (target == to)
+                return true;
+        }
+    }
+    return false;
+}
+
+// Depth-first search along dependents; only walks what is reachable from `from`.
+bool Graph::reaches(int from, int to) const {
+    vector<int> stack(1, from);
+    unordered_set<int> visited;
+    visited.insert(from);
+    while (!stack.empty()) {
+        int node = stack.back();
+        stack.pop_back();
+        if (node == to)
+            return true;
+        forEachDependent(node, [&](int next) {
+            if (visited.insert(next).second)
+                stack.push_back(next);
+        });
+    }
+    return false;
+}
+
+bool Graph::addDependency(int from, int to) {
+    if (from < 0 || to < 0 || from == to)
+        return false;
+    addTask(from > to ? from : to);
+    if (hasDependency(from, to) || reaches(to, from))
+        return false;
+    if (removed.erase(edgeKey(from, to))) {
+        overlayEdges--;
+    } else {
+        added[from].push_back(to);
+        overlayEdges++;
+    }
+    if (!completed[from])
+        inDegree[to]++;
+    if (overlayEdges > 64 && overlayEdges > (int)targets.size() / 4)
+        compact();
+    return true;
+}
+
+bool Graph::removeDependency(int from, int to) {
+    if (!hasDependency(from, to))
+        return false;
+    vector<int>& pending = added[from];
+    bool inOverlay = false;
+    for (size_t i = 0; i < pending.size(); i++) {
+        if (pending[i] == to) {
+            pending[i] = pending.back();
+            pending.pop_back();
+            overlayEdges--;
+            inOverlay = true;
+            break;
+        }
+    }
+    if (!inOverlay) {
+        removed.insert(edgeKey(from, to));
+        overlayEdges++;
+    }
+    if (!completed[from])
+        inDegree[to]--;
+    return true;
+}
+
+bool Graph::isReady(int id) const {
+    if (id < 0 || id >= (int)inDegree.size())
+        return id >= 0;
+    return inDegree[id] == 0 && !completed[id];
+}
+
+bool Graph::isCompleted(int id) const {
+    return id >= 0 && id < (int)completed.size() && completed[id];
+}
+
+int Graph::pendingDependencies(int id) const {
+    if (id < 0 || id >= (int)inDegree.size())
+        return 0;
+    return inDegree[id];
+}
+
+void Graph::complete(int id, vector<int>& newlyReady) {
+    if (id < 0)
+        return;
+    addTask(id);
+    if (completed[id])
+        return;
+    completed[id] = 1;
+    forEachDependent(id, [&](int to) {
+        if (--inDegree[to] == 0 && !completed[to])
+            newlyReady.push_back(to);
+    });
+}
+
+vector<int> Graph::dependents(int id) const {
+    vector<int> result;
+    forEachDependent(id, [&](int to) { result.push_back(to); });
+    return result;
+}
+
+void Graph::compact() {
+    int nodes = added.size();
+    vector<int> newOffsets(nodes + 1, 0);
+    vector<int> newTargets;
+    newTargets.reserve(targets.size() + overlayEdges);
+    for (int u = 0; u < nodes; u++) {
+        forEachDependent(u, [&](int to) { newTargets.push_back(to); });
+        newOffsets[u + 1] = newTargets.size();
+        added[u].clear();
+    }
+    offsets.swap(newOffsets);
+    targets.swap(newTargets);
+    removed.clear();
+    overlayEdges = 0;
 }
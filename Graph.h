@@ -1,25 +1,64 @@
-#include "Trie.h"
+#ifndef GRAPH_H
+#define GRAPH_H
 
-Trie::Trie() {
-    root = new TrieNode();
-}
+#include <unordered_set>
+#include <vector>
 
-void Trie::insert(string word) {
-    TrieNode* node = root;
-    for (char c : word) {
-        if (!node->children[c - 'a'])
-            node->children[c - 'a'] = new TrieNode();
-        node = node->children[c - 'a'];
-    }
-    node->isEnd = true;
-}
+using namespace std;
+
+// Dependency graph over task IDs. An edge from -> to means `to` waits for `from`.
+//
+// Out-edges are kept in compressed sparse row form (dependents of u are
+// targets[offsets[u] .. offsets[u + 1])) plus a mutable overlay: per-node lists
+// of edges added since the last compaction and a set of removed CSR edges.
+// The overlay is folded back into the arrays once it grows past a quarter of
+// the compacted edge count, so updates stay cheap and scans stay contiguous.
+//
+// inDegree[v] counts v's prerequisites that are not yet complete, so a task is
+// ready exactly when its counter is zero and completing a task only touches
+// its own dependents.
+class Graph {
+private:
+    vector<int> offsets;
+    vector<int> targets;
+    vector<vector<int>> added;
+    unordered_set<long long> removed;
+    vector<int> inDegree;
+    vector<char> completed;
+    int overlayEdges;
+
+    static long long edgeKey(int from, int to);
+    bool inCompacted(int from, int to) const;
+    bool reaches(int from, int to) const;
+    void compact();
 
-bool Trie::search(string word) {
-    TrieNode* node = root;
-    for (char c : word) {
-        if (!node->children[c - 'a'])
-            return false;
-        node = node->children[c - 'a'];
+public:
+    Graph();
+    void addTask(int id);
+    bool hasDependency(int from, int to) const;
+    // Fails if either ID is negative, the edge exists, or it would close a cycle.
+    bool addDependency(int from, int to);
+    bool removeDependency(int from, int to);
+    bool isReady(int id) const;
+    bool isCompleted(int id) const;
+    int pendingDependencies(int id) const;
+    // Marks id complete and appends each dependent whose last open prerequisite it was.
+    void complete(int id, vector<int>& newlyReady);
+    vector<int> dependents(int id) const;
+
+    template <typename Visit>
+    void forEachDependent(int id, Visit visit) const {
+        if (id + 1 < (int)offsets.size()) {
+            for (int i = offsets[id]; i < offsets[id + 1]; i++) {
+                if (removed.empty() || !removed.count(edgeKey(id, targets[i])))
+                    visit(targets[i]);
+            }
+        }
+        if (id < (int)added.size()) {
+            for (int to : added[id])
+                visit(to);
+        }
     }
-    return node->isEnd;
-}
+};
+
+#endif
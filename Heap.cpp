@@ -1,37 +1,54 @@
 #include "Heap.h"
 
-Heap::Heap() {
-    size = 0;
+Heap::Heap() : nextSequence(0) {
 }
 
-void Heap::insert(string name, int priority) {
-    tasks[size].name = name;
-    tasks[size].priority = priority;
-    int i = size;
-    while (i > 0 && tasks[i].priority < tasks[(i - 1) / 2].priority) {
+bool Heap::before(const HeapNode& a, const HeapNode& b) {
+    if (a.priority != b.priority) return a.priority < b.priority;
+    return a.sequence < b.sequence;
+}
+
+void Heap::insert(string_view name, int priority, int id) {
+    insert(SharedString(name), priority, id);
+}
+
+void Heap::insert(SharedString name, int priority, int id) {
+    tasks.push_back(HeapNode{std::move(name), priority, id, nextSequence++});
+    int i = tasks.size() - 1;
+    while (i > 0 && before(tasks[i], tasks[(i - 1) / 2])) {
         swap(tasks[i], tasks[(i - 1) / 2]);
         i = (i - 1) / 2;
     }
-    size++;
 }
 
-string Heap::getTop() {
-    if (size > 0) return tasks[0].name;
-    return "No Tasks Available";
+SharedString Heap::getTop() {
+    if (!tasks.empty()) return tasks[0].name;
+    return SharedString("No Tasks Available");
+}
+
+int Heap::getTopId() {
+    if (!tasks.empty()) return tasks[0].id;
+    return -1;
+}
+
+bool Heap::isEmpty() {
+    return tasks.empty();
 }
 
-string Heap::extractTop() {
-    if (size == 0) return "No Tasks Available";
-    string topTask = tasks[0].name;
-    tasks[0] = tasks[--size];
+SharedString Heap::extractTop() {
+    if (tasks.empty()) return SharedString("No Tasks Available");
+    SharedString topTask = std::move(tasks[0].name);
+    tasks[0] = std::move(tasks.back());
+    tasks.pop_back();
+    int size = tasks.size();
     int i = 0;
     while (2 * i + 1 < size) {
         int left = 2 * i + 1;
         int right = 2 * i + 2;
         int smallest = left;
-        if (right < size && tasks[right].priority < tasks[left].priority)
+        if (right < size && before(tasks[right], tasks[left]))
             smallest = right;
-        if (tasks[i].priority <= tasks[smallest].priority)
+        if (!before(tasks[smallest], tasks[i]))
             break;
         swap(tasks[i], tasks[smallest]);
         i = smallest;
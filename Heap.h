@@ -1,15 +1,33 @@
-#include "TaskScheduler.h"
+#ifndef HEAP_H
+#define HEAP_H
 
-void TaskScheduler::addTask(string task, int priority) {
-    taskQueue.insert(task, priority);
-    taskSearch.insert(task);
-}
+#include <string>
+#include <string_view>
+#include <vector>
+#include "StringPool.h"
 
-string TaskScheduler::getNextTask() {
-    return taskQueue.getTop();
-}
+using namespace std;
 
-void TaskScheduler::completeTask() {
-    string task = taskQueue.extractTop();
-    taskHistory.insert(task);
-}
+struct HeapNode {
+    SharedString name;
+    int priority;
+    int id;
+    long long sequence;  // insertion order; breaks priority ties FIFO
+};
+
+class Heap {
+private:
+    vector<HeapNode> tasks;
+    long long nextSequence;
+    static bool before(const HeapNode& a, const HeapNode& b);
+public:
+    Heap();
+    void insert(string_view name, int priority, int id = -1);
+    void insert(SharedString name, int priority, int id = -1);
+    SharedString getTop();
+    int getTopId();
+    SharedString extractTop();
+    bool isEmpty();
+};
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef LEASETABLE_H
+#define LEASETABLE_H
+
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+using namespace std;
+
+// Leases on claimed tasks, in a min-heap by expiry with a position index by
+// task ID, so granting, renewing, releasing and expiring a lease are each
+// O(log leases) and finding expired leases never scans the tasks.
+//
+// Every grant gets a new token. A worker proves it still holds a task by
+// presenting its token, so one whose lease expired and was granted to another
+// worker is refused rather than overwriting the new holder's work.
+class LeaseTable
+{
+    private:
+        struct Lease
+        {
+            time_t expiry;
+            uint64_t token;
+            int taskId;
+        };
+        vector<Lease> heap;
+        vector<int> position;   // by task ID; -1 when the task holds no lease
+        uint64_t nextToken;
+
+        void place(int index, const Lease& lease)
+        {
+            heap[index] = lease;
+            position[lease.taskId] = index;
+        }
+        void siftUp(int index)
+        {
+            Lease lease = heap[index];
+            while (index > 0 && lease.expiry < heap[(index - 1) / 2].expiry)
+            {
+                place(index, heap[(index - 1) / 2]);
+                index = (index - 1) / 2;
+            }
+            place(index, lease);
+        }
+        void siftDown(int index)
+        {
+            Lease lease = heap[index];
+            int size = heap.size();
+            while (true)
+            {
+                int child = 2 * index + 1;
+                if (child >= size) break;
+                if (child + 1 < size && heap[child + 1].expiry < heap[child].expiry) child++;
+                if (heap[child].expiry >= lease.expiry) break;
+                place(index, heap[child]);
+                index = child;
+            }
+            place(index, lease);
+        }
+        void removeAt(int index)
+        {
+            position[heap[index].taskId] = -1;
+            Lease last = heap.back();
+            heap.pop_back();
+            if (index == (int)heap.size()) return;
+            place(index, last);
+            siftUp(index);
+            siftDown(position[last.taskId]);
+        }
+        int indexOf(int taskId) const
+        {
+            if (taskId < 0 || taskId >= (int)position.size()) return -1;
+            return position[taskId];
+        }
+    public:
+        LeaseTable() : nextToken(1) {}
+
+        // Leases taskId until expiry, replacing any lease it held. Returns the token.
+        uint64_t grant(int taskId, time_t expiry)
+        {
+            release(taskId);
+            if (taskId >= (int)position.size())
+                position.resize(taskId + 1, -1);
+            heap.push_back(Lease{ expiry, nextToken++, taskId });
+            position[taskId] = heap.size() - 1;
+            siftUp(heap.size() - 1);
+            return heap[position[taskId]].token;
+        }
+        // Moves the expiry of a lease the caller holds. False if token is not
+        // the task's current lease.
+        bool renew(int taskId, uint64_t token, time_t expiry)
+        {
+            if (!holds(taskId, token)) return false;
+            int index = position[taskId];
+            time_t old = heap[index].expiry;
+            heap[index].expiry = expiry;
+            if (expiry < old)
+                siftUp(index);
+            else
+                siftDown(index);
+            return true;
+        }
+        bool holds(int taskId, uint64_t token) const
+        {
+            int index = indexOf(taskId);
+            return index != -1 && heap[index].token == token;
+        }
+        bool isLeased(int taskId) const
+        {
+            return indexOf(taskId) != -1;
+        }
+        // When taskId's lease runs out; 0 if it holds none.
+        time_t expiryOf(int taskId) const
+        {
+            int index = indexOf(taskId);
+            return index == -1 ? 0 : heap[index].expiry;
+        }
+        // Drops taskId's lease whoever holds it. Returns whether it had one.
+        bool release(int taskId)
+        {
+            int index = indexOf(taskId);
+            if (index == -1) return false;
+            removeAt(index);
+            return true;
+        }
+        // Removes every lease that expired at or before now, calling
+        // reclaim(taskId) for each, earliest first. Returns how many expired.
+        template <typename Reclaim>
+        int expire(time_t now, Reclaim reclaim)
+        {
+            int expired = 0;
+            while (!heap.empty() && heap[0].expiry <= now)
+            {
+                int taskId = heap[0].taskId;
+                removeAt(0);
+                reclaim(taskId);
+                expired++;
+            }
+            return expired;
+        }
+        int size() const
+        {
+            return heap.size();
+        }
+        void clear()
+        {
+            for (const Lease& lease : heap)
+                position[lease.taskId] = -1;
+            heap.clear();
+        }
+};
+
+#endif
@@ -5,8 +5,12 @@ LinkedList::LinkedList() {
     head = nullptr;
 }
 
-void LinkedList::insert(string task) {
-    Node* newNode = new Node{task, head};
+void LinkedList::insert(string_view task) {
+    insert(SharedString(task));
+}
+
+void LinkedList::insert(SharedString task) {
+    Node* newNode = new Node{std::move(task), head};
     head = newNode;
 }
 
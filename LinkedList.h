@@ -1,8 +1,14 @@
 #ifndef LINKEDLIST_H
 #define LINKEDLIST_H
 
+#include <string>
+#include <string_view>
+#include "StringPool.h"
+
+using namespace std;
+
 struct Node {
-    string task;
+    SharedString task;
     Node* next;
 };
 
@@ -11,7 +17,8 @@ private:
     Node* head;
 public:
     LinkedList();
-    void insert(string task);
+    void insert(string_view task);
+    void insert(SharedString task);
     void display();
 };
 
@@ -0,0 +1,345 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <vector>
+
+#if !defined(TASKSCHEDULER_METRICS)
+#define TASKSCHEDULER_METRICS 1
+#endif
+
+#if TASKSCHEDULER_METRICS
+#include <atomic>
+#include <mutex>
+#endif
+
+using namespace std;
+
+// Scheduler operations that are timed and counted.
+enum Operation
+{
+    OP_ADD,
+    OP_ADD_BATCH,
+    OP_REMOVE,
+    OP_MODIFY,
+    OP_STATUS,
+    OP_UNDO,
+    OP_REDO,
+    OP_SAVE,
+    OP_LOAD,
+    OP_IMPORT,
+    OP_EXPORT,
+    OP_JOURNAL_COMMIT,
+    OP_BACKGROUND_SAVE,
+    OPERATION_COUNT
+};
+
+inline const char* operationName(Operation op)
+{
+    static const char* names[OPERATION_COUNT] = {
+        "add_task", "add_tasks", "remove_task", "modify_task", "change_status", "undo", "redo",
+        "save_tasks", "load_tasks", "import_tasks", "export_tasks", "journal_commit",
+        "background_save"
+    };
+    return names[op];
+}
+
+// Latency histogram with HDR-style log-linear buckets: every power of two is
+// split into 16 equal sub-buckets, so any recorded value is known to within
+// about 6%. Values are nanoseconds; anything beyond 2^40 ns (about 18 minutes)
+// lands in the last bucket.
+struct LatencyBuckets
+{
+    static const int SUB_BITS = 4;
+    static const int SUB_COUNT = 1 << SUB_BITS;
+    static const int MAX_BITS = 40;
+    static const int COUNT = (MAX_BITS - SUB_BITS + 1) * SUB_COUNT;
+
+    static int indexOf(uint64_t value)
+    {
+        if (value < (uint64_t)SUB_COUNT) return (int)value;
+        int msb = 63 - __builtin_clzll(value);
+        if (msb >= MAX_BITS) return COUNT - 1;
+        return (msb - SUB_BITS + 1) * SUB_COUNT + (int)((value >> (msb - SUB_BITS)) & (SUB_COUNT - 1));
+    }
+    // Smallest value that falls in bucket index.
+    static uint64_t lowerBound(int index)
+    {
+        if (index < SUB_COUNT) return index;
+        int msb = index / SUB_COUNT + SUB_BITS - 1;
+        return (uint64_t)(SUB_COUNT + index % SUB_COUNT) << (msb - SUB_BITS);
+    }
+    // Largest value that falls in bucket index.
+    static uint64_t upperBound(int index)
+    {
+        return index == COUNT - 1 ? UINT64_MAX : lowerBound(index + 1) - 1;
+    }
+};
+
+// Totals for one operation, summed over every thread.
+struct OperationStats
+{
+    uint64_t calls = 0;
+    uint64_t errors = 0;
+    uint64_t totalNs = 0;
+    uint64_t maxNs = 0;
+    vector<uint64_t> buckets = vector<uint64_t>(LatencyBuckets::COUNT, 0);
+
+    // Latency at quantile q (0-1), reported as the midpoint of its bucket.
+    uint64_t percentile(double q) const
+    {
+        if (calls == 0) return 0;
+        uint64_t rank = (uint64_t)(q * (calls - 1)) + 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < LatencyBuckets::COUNT; i++)
+        {
+            seen += buckets[i];
+            if (seen >= rank)
+            {
+                uint64_t low = LatencyBuckets::lowerBound(i);
+                uint64_t high = min(LatencyBuckets::upperBound(i), maxNs);
+                return low + (high - low) / 2;
+            }
+        }
+        return maxNs;
+    }
+    // Calls that took at most limitNs, as far as the buckets can tell.
+    uint64_t countAtMost(uint64_t limitNs) const
+    {
+        uint64_t count = 0;
+        for (int i = 0; i < LatencyBuckets::COUNT && LatencyBuckets::upperBound(i) <= limitNs; i++)
+            count += buckets[i];
+        return count;
+    }
+};
+
+#if TASKSCHEDULER_METRICS
+
+// Process-wide operation metrics. Each thread records into a slot of its own,
+// so recording is a few relaxed loads and stores with no locked instruction and
+// no shared cache line; snapshot() adds the slots up on demand. A slot outlives
+// its thread and is handed to the next thread that starts recording, so the
+// totals never lose counts.
+class Metrics
+{
+    private:
+        struct Counters
+        {
+            atomic<uint64_t> errors{0};
+            atomic<uint64_t> totalNs{0};
+            atomic<uint64_t> maxNs{0};
+            atomic<uint64_t> buckets[LatencyBuckets::COUNT];
+            Counters()
+            {
+                for (atomic<uint64_t>& bucket : buckets)
+                    bucket.store(0, memory_order_relaxed);
+            }
+        };
+        struct Slot
+        {
+            Counters operations[OPERATION_COUNT];
+        };
+        // Returns the thread's slot to the pool when the thread exits.
+        struct Lease
+        {
+            Slot* slot = nullptr;
+            ~Lease()
+            {
+                if (slot) global().giveBack(slot);
+            }
+        };
+
+        mutex lock;
+        vector<Slot*> slots;
+        vector<Slot*> idle;
+
+        // Only the owning thread writes a slot, so a plain load and store is enough.
+        static void add(atomic<uint64_t>& counter, uint64_t amount)
+        {
+            counter.store(counter.load(memory_order_relaxed) + amount, memory_order_relaxed);
+        }
+        Slot* take()
+        {
+            lock_guard<mutex> guard(lock);
+            if (!idle.empty())
+            {
+                Slot* slot = idle.back();
+                idle.pop_back();
+                return slot;
+            }
+            slots.push_back(new Slot());
+            return slots.back();
+        }
+        void giveBack(Slot* slot)
+        {
+            lock_guard<mutex> guard(lock);
+            idle.push_back(slot);
+        }
+        Slot& threadSlot()
+        {
+            static thread_local Lease lease;
+            if (!lease.slot)
+                lease.slot = take();
+            return *lease.slot;
+        }
+    public:
+        // Never destroyed, so threads that exit during shutdown can still return their slots.
+        static Metrics& global()
+        {
+            static Metrics* metrics = new Metrics();
+            return *metrics;
+        }
+        void record(Operation op, uint64_t elapsedNs, bool failed)
+        {
+            Counters& counters = threadSlot().operations[op];
+            if (failed)
+                add(counters.errors, 1);
+            add(counters.totalNs, elapsedNs);
+            if (elapsedNs > counters.maxNs.load(memory_order_relaxed))
+                counters.maxNs.store(elapsedNs, memory_order_relaxed);
+            add(counters.buckets[LatencyBuckets::indexOf(elapsedNs)], 1);
+        }
+        // Totals per operation, indexed by Operation. Calls are the sum of the
+        // buckets, so the histogram is always self-consistent; the other figures
+        // may lag it by a call that another thread is recording.
+        vector<OperationStats> snapshot()
+        {
+            vector<OperationStats> stats(OPERATION_COUNT);
+            lock_guard<mutex> guard(lock);
+            for (Slot* slot : slots)
+            {
+                for (int op = 0; op < OPERATION_COUNT; op++)
+                {
+                    const Counters& counters = slot->operations[op];
+                    OperationStats& total = stats[op];
+                    total.errors += counters.errors.load(memory_order_relaxed);
+                    total.totalNs += counters.totalNs.load(memory_order_relaxed);
+                    total.maxNs = max(total.maxNs, counters.maxNs.load(memory_order_relaxed));
+                    for (int i = 0; i < LatencyBuckets::COUNT; i++)
+                    {
+                        uint64_t count = counters.buckets[i].load(memory_order_relaxed);
+                        total.buckets[i] += count;
+                        total.calls += count;
+                    }
+                }
+            }
+            return stats;
+        }
+};
+
+// Times one call of an operation from construction to destruction. Call fail()
+// on paths that report an error.
+class OperationTimer
+{
+    private:
+        Operation op;
+        chrono::steady_clock::time_point start;
+        bool failed;
+    public:
+        explicit OperationTimer(Operation operation)
+            : op(operation), start(chrono::steady_clock::now()), failed(false) {}
+        ~OperationTimer()
+        {
+            uint64_t elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+            Metrics::global().record(op, elapsed, failed);
+        }
+        OperationTimer(const OperationTimer&) = delete;
+        OperationTimer& operator=(const OperationTimer&) = delete;
+        void fail()
+        {
+            failed = true;
+        }
+};
+
+inline vector<OperationStats> metricsSnapshot()
+{
+    return Metrics::global().snapshot();
+}
+
+#else
+
+// Built with TASKSCHEDULER_METRICS=0: timers are empty and optimize away.
+class OperationTimer
+{
+    public:
+        explicit OperationTimer(Operation) {}
+        void fail() {}
+};
+
+inline vector<OperationStats> metricsSnapshot()
+{
+    return vector<OperationStats>();
+}
+
+#endif
+
+// Per-operation table for the stats command. Latencies are in microseconds.
+inline void writeMetricsTable(ostream& out)
+{
+    vector<OperationStats> stats = metricsSnapshot();
+    if (stats.empty())
+    {
+        out << "Metrics are disabled in this build.\n";
+        return;
+    }
+    char line[160];
+    snprintf(line, sizeof(line), "%-15s %9s %7s %10s %10s %10s %10s %10s %10s\n",
+             "operation", "calls", "errors", "mean(us)", "p50", "p90", "p99", "p99.9", "max");
+    out << "\n--- Operation Statistics ---\n" << line;
+    bool any = false;
+    for (int op = 0; op < OPERATION_COUNT; op++)
+    {
+        const OperationStats& s = stats[op];
+        if (s.calls == 0) continue;
+        any = true;
+        snprintf(line, sizeof(line), "%-15s %9llu %7llu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                 operationName((Operation)op), (unsigned long long)s.calls, (unsigned long long)s.errors,
+                 s.totalNs / 1000.0 / s.calls, s.percentile(0.5) / 1000.0, s.percentile(0.9) / 1000.0,
+                 s.percentile(0.99) / 1000.0, s.percentile(0.999) / 1000.0, s.maxNs / 1000.0);
+        out << line;
+    }
+    if (!any)
+        out << "No operations recorded yet.\n";
+}
+
+// The same figures in the Prometheus text exposition format (version 0.0.4):
+// one histogram of durations in seconds and one error counter, labelled by
+// operation. A bucket counts the calls whose histogram bucket lies wholly
+// under its bound, so it may miss calls within 6% of the bound.
+inline void writeMetricsPrometheus(ostream& out)
+{
+    static const double bounds[] = {
+        1e-6, 2.5e-6, 5e-6, 1e-5, 2.5e-5, 5e-5, 1e-4, 2.5e-4, 5e-4,
+        1e-3, 2.5e-3, 5e-3, 1e-2, 2.5e-2, 5e-2, 0.1, 0.25, 0.5, 1, 2.5, 5, 10
+    };
+    vector<OperationStats> stats = metricsSnapshot();
+    if (stats.empty()) return;
+    char value[32];
+    out << "# HELP taskscheduler_operation_duration_seconds Time spent in each scheduler operation.\n"
+        << "# TYPE taskscheduler_operation_duration_seconds histogram\n";
+    for (int op = 0; op < OPERATION_COUNT; op++)
+    {
+        const OperationStats& s = stats[op];
+        const char* name = operationName((Operation)op);
+        for (double bound : bounds)
+        {
+            snprintf(value, sizeof(value), "%g", bound);
+            out << "taskscheduler_operation_duration_seconds_bucket{op=\"" << name << "\",le=\"" << value << "\"} "
+                << s.countAtMost((uint64_t)(bound * 1e9)) << '\n';
+        }
+        out << "taskscheduler_operation_duration_seconds_bucket{op=\"" << name << "\",le=\"+Inf\"} " << s.calls << '\n';
+        snprintf(value, sizeof(value), "%.9f", s.totalNs / 1e9);
+        out << "taskscheduler_operation_duration_seconds_sum{op=\"" << name << "\"} " << value << '\n'
+            << "taskscheduler_operation_duration_seconds_count{op=\"" << name << "\"} " << s.calls << '\n';
+    }
+    out << "# HELP taskscheduler_operation_errors_total Scheduler operations that reported an error.\n"
+        << "# TYPE taskscheduler_operation_errors_total counter\n";
+    for (int op = 0; op < OPERATION_COUNT; op++)
+        out << "taskscheduler_operation_errors_total{op=\"" << operationName((Operation)op) << "\"} " << stats[op].errors << '\n';
+}
+
+#endif
@@ -0,0 +1,386 @@
+#ifndef PRIORITYQUEUE_H
+#define PRIORITYQUEUE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <variant>
+#include <vector>
+#include "Task.h"
+
+// Scheduling policies. Policy::before(a, b) is true when a should run strictly
+// before b; the queue breaks every remaining tie by arrival order (FIFO), so
+// equally ranked tasks cannot starve each other.
+struct PriorityPolicy
+{
+    static const char* name() { return "Priority"; }
+    static bool before(const Task& a, const Task& b)
+    {
+        return a.taskPriority > b.taskPriority;
+    }
+};
+
+// Tasks without a due date (0) sort after every dated task.
+inline time_t deadlineOf(const Task& task)
+{
+    return task.taskDueDate ? task.taskDueDate : (time_t)INT64_MAX;
+}
+
+// Earliest deadline first.
+struct DeadlinePolicy
+{
+    static const char* name() { return "Due Date"; }
+    static bool before(const Task& a, const Task& b)
+    {
+        return deadlineOf(a) < deadlineOf(b);
+    }
+};
+
+struct PriorityDeadlinePolicy
+{
+    static const char* name() { return "Priority, then Due Date"; }
+    static bool before(const Task& a, const Task& b)
+    {
+        if (a.taskPriority != b.taskPriority)
+            return a.taskPriority > b.taskPriority;
+        return deadlineOf(a) < deadlineOf(b);
+    }
+};
+
+// Scores PriorityWeight per priority level against HourWeight per hour of
+// deadline, so by default one priority level is worth a day of urgency.
+// Undated tasks count as due on 2100-01-01.
+template <int PriorityWeight = 24, int HourWeight = 1>
+struct WeightedPolicy
+{
+    static const char* name() { return "Weighted Priority/Due Date"; }
+    static long long score(const Task& task)
+    {
+        long long hours = (task.taskDueDate ? task.taskDueDate : 4102444800LL) / 3600;
+        return (long long)PriorityWeight * task.taskPriority - (long long)HourWeight * hours;
+    }
+    static bool before(const Task& a, const Task& b)
+    {
+        return score(a) > score(b);
+    }
+};
+
+// Indexed binary heap ordered by Policy. position[taskId] holds the heap slot of
+// every queued task (-1 when absent), so remove/update by ID are O(log n) sifts
+// instead of a scan followed by a full rebuild. The policy is a template
+// parameter, so its comparison is inlined into the sift loops.
+template <typename Policy>
+class BasicPriorityQueue
+{
+    private:
+        struct Entry
+        {
+            Task* task;
+            uint64_t sequence;  // arrival order, kept across updates
+        };
+        vector<Entry> heap;
+        vector<int> position;
+        uint64_t nextSequence;
+        static bool runsBefore(const Entry& a, const Entry& b)
+        {
+            if (Policy::before(*a.task, *b.task)) return true;
+            if (Policy::before(*b.task, *a.task)) return false;
+            return a.sequence < b.sequence;
+        }
+        void place(int i, const Entry& entry)
+        {
+            heap[i] = entry;
+            position[entry.task->taskId] = i;
+        }
+        int siftUp(int i)
+        {
+            Entry entry = heap[i];
+            while (i > 0 && runsBefore(entry, heap[(i - 1) / 2]))
+            {
+                place(i, heap[(i - 1) / 2]);
+                i = (i - 1) / 2;
+            }
+            place(i, entry);
+            return i;
+        }
+        void heapify(int i)
+        {
+            int size = heap.size();
+            Entry entry = heap[i];
+            while (true)
+            {
+                int first = i;
+                const Entry* best = &entry;
+                int left = 2 * i + 1;
+                int right = 2 * i + 2;
+                if (left < size && runsBefore(heap[left], *best))
+                {
+                    first = left;
+                    best = &heap[left];
+                }
+                if (right < size && runsBefore(heap[right], *best))
+                    first = right;
+                if (first == i)
+                    break;
+                place(i, heap[first]);
+                i = first;
+            }
+            place(i, entry);
+        }
+        void removeAt(int index)
+        {
+            position[heap[index].task->taskId] = -1;
+            Entry last = heap.back();
+            heap.pop_back();
+            if (index == (int)heap.size()) return;
+            place(index, last);
+            if (siftUp(index) == index)
+                heapify(index);
+        }
+    public:
+        BasicPriorityQueue(int expectedTasks = 0) : nextSequence(0)
+        {
+            heap.reserve(expectedTasks);
+        }
+        static const char* policyName()
+        {
+            return Policy::name();
+        }
+        int indexOf(int taskId) const
+        {
+            if (taskId < 0 || taskId >= (int)position.size()) return -1;
+            return position[taskId];
+        }
+        bool contains(int taskId) const
+        {
+            return indexOf(taskId) != -1;
+        }
+        void insert(Task* task)
+        {
+            if (!task->isValid()) return;
+            if (contains(task->taskId))
+            {
+                updateTask(task);
+                return;
+            }
+            if (task->taskId >= (int)position.size())
+                position.resize(task->taskId + 1, -1);
+            heap.push_back(Entry{ task, nextSequence++ });
+            siftUp(heap.size() - 1);
+        }
+        // Adds a batch of tasks. When the batch is at least as large as the queue
+        // the heap is rebuilt bottom-up (Floyd) in O(n) instead of sifting every
+        // task up. Tasks already queued are updated in place.
+        void insertAll(Task* const* tasks, size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                if (contains(tasks[i]->taskId))
+                    updateTask(tasks[i]);
+            }
+            size_t queued = heap.size();
+            heap.reserve(queued + count);
+            for (size_t i = 0; i < count; i++)
+            {
+                Task* task = tasks[i];
+                if (!task->isValid() || contains(task->taskId)) continue;
+                if (task->taskId >= (int)position.size())
+                    position.resize(task->taskId + 1, -1);
+                position[task->taskId] = heap.size();
+                heap.push_back(Entry{ task, nextSequence++ });
+            }
+            if (heap.size() - queued >= queued)
+            {
+                for (int i = (int)heap.size() / 2 - 1; i >= 0; i--)
+                    heapify(i);
+            }
+            else
+            {
+                for (size_t i = queued; i < heap.size(); i++)
+                    siftUp(i);
+            }
+        }
+        Task* pop()
+        {
+            if (heap.empty()) return nullptr;
+            Task* topTask = heap[0].task;
+            removeAt(0);
+            return topTask;
+        }
+        Task* top() const
+        {
+            return heap.empty() ? nullptr : heap[0].task;
+        }
+        bool removeTask(int taskId)
+        {
+            int index = indexOf(taskId);
+            if (index == -1) return false;
+            removeAt(index);
+            return true;
+        }
+        // Restores heap order after the task's ranking fields changed in either direction.
+        void updateTask(Task* task)
+        {
+            int index = indexOf(task->taskId);
+            if (index == -1)
+            {
+                insert(task);
+                return;
+            }
+            heap[index].task = task;
+            if (siftUp(index) == index)
+                heapify(index);
+        }
+        // Queued tasks, oldest arrival first.
+        vector<Task*> tasksByArrival() const
+        {
+            vector<Entry> entries(heap);
+            sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+                return a.sequence < b.sequence;
+            });
+            vector<Task*> tasks;
+            tasks.reserve(entries.size());
+            for (const Entry& entry : entries)
+                tasks.push_back(entry.task);
+            return tasks;
+        }
+        // Queued tasks in the order pop() would return them.
+        vector<Task*> tasksInOrder() const
+        {
+            vector<Entry> entries(heap);
+            sort(entries.begin(), entries.end(), runsBefore);
+            vector<Task*> tasks;
+            tasks.reserve(entries.size());
+            for (const Entry& entry : entries)
+                tasks.push_back(entry.task);
+            return tasks;
+        }
+        void display() const
+        {
+            cout << "\n--- Priority Queue (Tasks by " << Policy::name() << ") ---\n";
+            if (heap.empty()) {
+                cout << "No tasks in the priority queue.\n";
+                return;
+            }
+            for (size_t i = 0; i < heap.size(); i++)
+            {
+                heap[i].task->displayTask();
+            }
+        }
+        bool isEmpty() const
+        {
+            return heap.empty();
+        }
+        int getSize() const
+        {
+            return heap.size();
+        }
+
+        // Method to clear the queue - added for file handling
+        void clear()
+        {
+            for (const Entry& entry : heap)
+                position[entry.task->taskId] = -1;
+            heap.clear();
+        }
+};
+
+typedef BasicPriorityQueue<PriorityPolicy> PriorityQueue;
+
+// Order of the alternatives in SchedulingQueue's variant.
+enum SchedulingPolicy
+{
+    POLICY_PRIORITY,
+    POLICY_DEADLINE,
+    POLICY_PRIORITY_DEADLINE,
+    POLICY_WEIGHTED
+};
+
+// Picks a BasicPriorityQueue specialization at run time. Each call dispatches
+// once through std::visit; everything inside the heap is the inlined policy.
+class SchedulingQueue
+{
+    private:
+        typedef variant<BasicPriorityQueue<PriorityPolicy>,
+                        BasicPriorityQueue<DeadlinePolicy>,
+                        BasicPriorityQueue<PriorityDeadlinePolicy>,
+                        BasicPriorityQueue<WeightedPolicy<>>> Queue;
+        Queue queue;
+        static Queue make(SchedulingPolicy policy)
+        {
+            switch (policy)
+            {
+                case POLICY_DEADLINE: return Queue(in_place_index<POLICY_DEADLINE>);
+                case POLICY_PRIORITY_DEADLINE: return Queue(in_place_index<POLICY_PRIORITY_DEADLINE>);
+                case POLICY_WEIGHTED: return Queue(in_place_index<POLICY_WEIGHTED>);
+                default: return Queue(in_place_index<POLICY_PRIORITY>);
+            }
+        }
+    public:
+        SchedulingQueue(SchedulingPolicy policy = POLICY_PRIORITY) : queue(make(policy)) {}
+        SchedulingPolicy getPolicy() const
+        {
+            return (SchedulingPolicy)queue.index();
+        }
+        const char* policyName() const
+        {
+            return visit([](const auto& q) { return q.policyName(); }, queue);
+        }
+        // Re-queues everything under the new policy, keeping arrival order for ties.
+        void setPolicy(SchedulingPolicy policy)
+        {
+            if (policy == getPolicy()) return;
+            vector<Task*> tasks = visit([](const auto& q) { return q.tasksByArrival(); }, queue);
+            queue = make(policy);
+            insertAll(tasks.data(), tasks.size());
+        }
+        void insert(Task* task)
+        {
+            visit([task](auto& q) { q.insert(task); }, queue);
+        }
+        void insertAll(Task* const* tasks, size_t count)
+        {
+            visit([tasks, count](auto& q) { q.insertAll(tasks, count); }, queue);
+        }
+        Task* pop()
+        {
+            return visit([](auto& q) { return q.pop(); }, queue);
+        }
+        Task* top() const
+        {
+            return visit([](const auto& q) { return q.top(); }, queue);
+        }
+        bool contains(int taskId) const
+        {
+            return visit([taskId](const auto& q) { return q.contains(taskId); }, queue);
+        }
+        bool removeTask(int taskId)
+        {
+            return visit([taskId](auto& q) { return q.removeTask(taskId); }, queue);
+        }
+        void updateTask(Task* task)
+        {
+            visit([task](auto& q) { q.updateTask(task); }, queue);
+        }
+        vector<Task*> tasksInOrder() const
+        {
+            return visit([](const auto& q) { return q.tasksInOrder(); }, queue);
+        }
+        void display() const
+        {
+            visit([](const auto& q) { q.display(); }, queue);
+        }
+        bool isEmpty() const
+        {
+            return visit([](const auto& q) { return q.isEmpty(); }, queue);
+        }
+        int getSize() const
+        {
+            return visit([](const auto& q) { return q.getSize(); }, queue);
+        }
+        void clear()
+        {
+            visit([](auto& q) { q.clear(); }, queue);
+        }
+};
+
+#endif
@@ -0,0 +1,411 @@
+#ifndef RECURRENCERULES_H
+#define RECURRENCERULES_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "StringPool.h"
+
+using namespace std;
+
+// The five fields of a cron expression as bit sets, in local time:
+// minute (0-59), hour (0-23), day of month (1-31), month (1-12) and day of
+// week (0-6, Sunday 0; 7 is accepted for Sunday).
+struct CronSpec
+{
+    uint64_t minutes = 0;
+    uint32_t hours = 0;
+    uint32_t days = 0;          // bit d for day d
+    uint16_t months = 0;        // bit m for month m
+    uint8_t weekdays = 0;
+    bool anyDay = true;         // day-of-month field was *
+    bool anyWeekday = true;     // day-of-week field was *
+
+    static bool parseField(const string& text, int low, int high, uint64_t& bits, bool& any)
+    {
+        bits = 0;
+        any = text == "*";
+        stringstream parts(text);
+        string part;
+        while (getline(parts, part, ','))
+        {
+            int first = low, last = high, step = 1;
+            size_t slash = part.find('/');
+            string range = part.substr(0, slash);
+            if (slash != string::npos)
+            {
+                char* end;
+                step = strtol(part.c_str() + slash + 1, &end, 10);
+                if (*end || step <= 0) return false;
+            }
+            if (range != "*")
+            {
+                char* end;
+                first = strtol(range.c_str(), &end, 10);
+                last = first;
+                if (*end == '-')
+                    last = strtol(end + 1, &end, 10);
+                else if (slash != string::npos)
+                    last = high;
+                if (*end || range.empty() || first < low || last > high || first > last) return false;
+            }
+            for (int value = first; value <= last; value += step)
+                bits |= 1ULL << value;
+        }
+        return bits != 0;
+    }
+    bool parse(const string& text)
+    {
+        stringstream in(text);
+        string field[5], extra;
+        for (string& f : field)
+        {
+            if (!(in >> f)) return false;
+        }
+        if (in >> extra) return false;
+        uint64_t bits;
+        bool any;
+        if (!parseField(field[0], 0, 59, minutes, any)) return false;
+        if (!parseField(field[1], 0, 23, bits, any)) return false;
+        hours = bits;
+        if (!parseField(field[2], 1, 31, bits, anyDay)) return false;
+        days = bits;
+        if (!parseField(field[3], 1, 12, bits, any)) return false;
+        months = bits;
+        if (!parseField(field[4], 0, 7, bits, anyWeekday)) return false;
+        weekdays = (bits | bits >> 7) & 0x7f;
+        return true;
+    }
+    // Cron's rule: when both day fields are restricted, either may match.
+    bool matchesDay(const struct tm& date) const
+    {
+        bool day = days >> date.tm_mday & 1;
+        bool weekday = weekdays >> date.tm_wday & 1;
+        if (anyDay || anyWeekday)
+            return day && weekday;
+        return day || weekday;
+    }
+    // First matching minute strictly after `after`, or 0 if none within five years.
+    time_t next(time_t after) const
+    {
+        struct tm date;
+        time_t start = after - after % 60 + 60;
+        localtime_r(&start, &date);
+        for (int day = 0; day < 5 * 366; day++)
+        {
+            if ((months >> (date.tm_mon + 1) & 1) && matchesDay(date))
+            {
+                for (int hour = date.tm_hour; hour < 24; hour++)
+                {
+                    if (!(hours >> hour & 1)) continue;
+                    uint64_t later = minutes >> (hour == date.tm_hour ? date.tm_min : 0) << (hour == date.tm_hour ? date.tm_min : 0);
+                    if (!later) continue;
+                    struct tm fire = date;
+                    fire.tm_hour = hour;
+                    fire.tm_min = __builtin_ctzll(later);
+                    fire.tm_sec = 0;
+                    fire.tm_isdst = -1;
+                    time_t t = mktime(&fire);
+                    if (t > after) return t;
+                }
+            }
+            date.tm_mday++;
+            date.tm_hour = 0;
+            date.tm_min = 0;
+            date.tm_sec = 0;
+            date.tm_isdst = -1;
+            mktime(&date);
+        }
+        return 0;
+    }
+};
+
+// A task template plus the schedule it recurs on. Occurrences are ordinary
+// tasks created when the rule fires; until then the rule is the only record.
+struct RecurrenceRule
+{
+    int ruleId = -1;
+    SharedString name;
+    SharedString description;
+    int priority = 0;
+    time_t dueAfter = 0;        // an occurrence is due this long after it fires; 0: no due date
+    string schedule;            // "every N{s,m,h,d,w}" or "cron M H DOM MON DOW"
+    time_t start = 0;           // interval rules fire at start + k * interval
+    time_t interval = 0;        // 0 for cron rules
+    CronSpec cron;
+    time_t nextFire = 0;
+    int occurrences = 0;        // materialized so far
+    int heapIndex = -1;
+
+    // Parses schedule (see above). Interval rules count from start.
+    bool parseSchedule(const string& text, time_t from, string& error)
+    {
+        schedule = text;
+        start = from;
+        interval = 0;
+        if (text.compare(0, 5, "cron ") == 0)
+        {
+            if (!cron.parse(text.substr(5)))
+            {
+                error = "invalid cron expression";
+                return false;
+            }
+            return true;
+        }
+        if (!parseDuration(text.compare(0, 6, "every ") == 0 ? text.substr(6) : string(), interval) || interval <= 0)
+        {
+            error = "schedule must be \"every N{s,m,h,d,w}\" or \"cron M H DOM MON DOW\"";
+            return false;
+        }
+        return true;
+    }
+    // First fire time strictly after `after`; 0 if the rule never fires again.
+    time_t fireAfter(time_t after) const
+    {
+        if (interval == 0)
+            return cron.next(after);
+        if (after < start)
+            return start;
+        return start + ((after - start) / interval + 1) * interval;
+    }
+
+    // "90", "90s", "15m", "12h", "1d" or "2w" in seconds.
+    static bool parseDuration(const string& text, time_t& seconds)
+    {
+        char* end;
+        long long value = strtoll(text.c_str(), &end, 10);
+        if (end == text.c_str() || value < 0) return false;
+        static const char units[] = "smhdw";
+        static const time_t scale[] = { 1, 60, 3600, 86400, 7 * 86400 };
+        if (*end == '\0')
+        {
+            seconds = value;
+            return true;
+        }
+        const char* unit = strchr(units, *end);
+        if (!unit || end[1] != '\0') return false;
+        seconds = value * scale[unit - units];
+        return true;
+    }
+};
+
+// Recurrence rules with a min-heap of their next fire times, so finding the
+// next rule to fire is O(1) and firing or removing one is O(log rules). Only
+// rules are stored; the scheduler materializes an occurrence when its rule
+// fires, which is also when it becomes schedulable.
+class RecurrenceSchedule
+{
+    private:
+        unordered_map<int, RecurrenceRule> rules;
+        vector<RecurrenceRule*> heap;   // by nextFire
+        int nextRuleId;
+
+        bool before(int a, int b) const
+        {
+            if (heap[a]->nextFire != heap[b]->nextFire)
+                return heap[a]->nextFire < heap[b]->nextFire;
+            return heap[a]->ruleId < heap[b]->ruleId;
+        }
+        void place(int index, RecurrenceRule* rule)
+        {
+            heap[index] = rule;
+            rule->heapIndex = index;
+        }
+        void siftUp(int index)
+        {
+            while (index > 0 && before(index, (index - 1) / 2))
+            {
+                RecurrenceRule* parent = heap[(index - 1) / 2];
+                place((index - 1) / 2, heap[index]);
+                place(index, parent);
+                index = (index - 1) / 2;
+            }
+        }
+        void siftDown(int index)
+        {
+            int size = heap.size();
+            while (true)
+            {
+                int smallest = index;
+                int left = 2 * index + 1, right = left + 1;
+                if (left < size && before(left, smallest)) smallest = left;
+                if (right < size && before(right, smallest)) smallest = right;
+                if (smallest == index) return;
+                RecurrenceRule* child = heap[smallest];
+                place(smallest, heap[index]);
+                place(index, child);
+                index = smallest;
+            }
+        }
+        void push(RecurrenceRule* rule)
+        {
+            if (rule->nextFire == 0) return;
+            heap.push_back(nullptr);
+            place(heap.size() - 1, rule);
+            siftUp(rule->heapIndex);
+        }
+        void erase(RecurrenceRule* rule)
+        {
+            int index = rule->heapIndex;
+            if (index == -1) return;
+            rule->heapIndex = -1;
+            RecurrenceRule* last = heap.back();
+            heap.pop_back();
+            if (index == (int)heap.size()) return;
+            place(index, last);
+            siftUp(index);
+            siftDown(last->heapIndex);
+        }
+    public:
+        RecurrenceSchedule() : nextRuleId(1) {}
+        RecurrenceSchedule(const RecurrenceSchedule&) = delete;
+        RecurrenceSchedule& operator=(const RecurrenceSchedule&) = delete;
+
+        // Stores rule under a new ID; its first occurrence fires at the first
+        // schedule time after now (or at its start time, for interval rules
+        // starting in the future).
+        int add(RecurrenceRule rule, time_t now)
+        {
+            rule.ruleId = nextRuleId++;
+            rule.nextFire = rule.fireAfter(now - 1);
+            rule.heapIndex = -1;
+            RecurrenceRule& stored = rules[rule.ruleId] = std::move(rule);
+            push(&stored);
+            return stored.ruleId;
+        }
+        bool remove(int ruleId)
+        {
+            auto it = rules.find(ruleId);
+            if (it == rules.end()) return false;
+            erase(&it->second);
+            rules.erase(it);
+            return true;
+        }
+        const RecurrenceRule* get(int ruleId) const
+        {
+            auto it = rules.find(ruleId);
+            return it == rules.end() ? nullptr : &it->second;
+        }
+        // Rules in ID order.
+        vector<const RecurrenceRule*> list() const
+        {
+            vector<const RecurrenceRule*> all;
+            all.reserve(rules.size());
+            for (const auto& entry : rules)
+                all.push_back(&entry.second);
+            sort(all.begin(), all.end(), [](const RecurrenceRule* a, const RecurrenceRule* b) {
+                return a->ruleId < b->ruleId;
+            });
+            return all;
+        }
+        int size() const
+        {
+            return rules.size();
+        }
+        // When the next rule fires; 0 if none will.
+        time_t nextFireTime() const
+        {
+            return heap.empty() ? 0 : heap[0]->nextFire;
+        }
+        // Calls materialize(rule, fireTime) once for each rule whose fire time has
+        // come, then moves the rule to its first fire time after now. A rule that
+        // fell behind (the scheduler was not running) yields one occurrence, for
+        // the oldest time it missed, rather than one per missed time. Returns the
+        // number of occurrences.
+        template <typename Materialize>
+        int fireDue(time_t now, Materialize materialize)
+        {
+            int fired = 0;
+            while (!heap.empty() && heap[0]->nextFire <= now)
+            {
+                RecurrenceRule* rule = heap[0];
+                materialize(*rule, rule->nextFire);
+                rule->occurrences++;
+                fired++;
+                rule->nextFire = rule->fireAfter(now);
+                if (rule->nextFire == 0)
+                {
+                    erase(rule);
+                    continue;
+                }
+                siftDown(0);
+            }
+            return fired;
+        }
+        void clear()
+        {
+            heap.clear();
+            rules.clear();
+            nextRuleId = 1;
+        }
+
+        // Text file: the next rule ID and the rule count, then nine lines per
+        // rule. Written to a temporary file and renamed into place.
+        bool save(const string& fileName) const
+        {
+            string tempName = fileName + ".tmp";
+            ofstream out(tempName);
+            if (!out.is_open()) return false;
+            out << nextRuleId << '\n' << rules.size() << '\n';
+            for (const RecurrenceRule* rule : list())
+            {
+                out << rule->ruleId << '\n' << rule->name << '\n' << rule->description << '\n'
+                    << rule->priority << '\n' << rule->dueAfter << '\n' << rule->schedule << '\n'
+                    << rule->start << '\n' << rule->nextFire << '\n' << rule->occurrences << '\n';
+            }
+            out.close();
+            return !out.fail() && rename(tempName.c_str(), fileName.c_str()) == 0;
+        }
+        // Replaces every rule with the file's. A missing file means no rules.
+        bool load(const string& fileName, string& error)
+        {
+            clear();
+            ifstream in(fileName);
+            if (!in.is_open()) return true;
+            int count = 0;
+            in >> nextRuleId >> count;
+            in.ignore();
+            for (int i = 0; i < count && in; i++)
+            {
+                RecurrenceRule rule;
+                string name, description, schedule;
+                in >> rule.ruleId;
+                in.ignore();
+                getline(in, name);
+                getline(in, description);
+                in >> rule.priority >> rule.dueAfter;
+                in.ignore();
+                getline(in, schedule);
+                time_t start;
+                in >> start >> rule.nextFire >> rule.occurrences;
+                in.ignore();
+                if (!in || !rule.parseSchedule(schedule, start, error))
+                {
+                    error = "corrupt rule in " + fileName;
+                    clear();
+                    return false;
+                }
+                rule.name = name;
+                rule.description = description;
+                RecurrenceRule& stored = rules[rule.ruleId] = std::move(rule);
+                push(&stored);
+            }
+            if (!in)
+            {
+                error = "truncated " + fileName;
+                clear();
+                return false;
+            }
+            return true;
+        }
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef STATUSINDEX_H
+#define STATUSINDEX_H
+
+#include "Task.h"
+
+// Tasks partitioned by status into intrusive doubly linked lists threaded
+// through Task::statusLink, so moving a task between statuses, counting a
+// status and listing it never scan unrelated tasks. Tasks must stay at a
+// fixed address while linked (TaskStore guarantees this).
+class StatusIndex
+{
+    private:
+        static const int STATUS_COUNT = 3;
+        Task* heads[STATUS_COUNT];
+        Task* tails[STATUS_COUNT];
+        int counts[STATUS_COUNT];
+        void link(Task* task, int status)
+        {
+            task->statusLink.prev = tails[status];
+            task->statusLink.next = nullptr;
+            task->statusLink.status = status;
+            if (tails[status])
+                tails[status]->statusLink.next = task;
+            else
+                heads[status] = task;
+            tails[status] = task;
+            counts[status]++;
+        }
+        void unlink(Task* task)
+        {
+            StatusLink& links = task->statusLink;
+            if (links.prev)
+                links.prev->statusLink.next = links.next;
+            else
+                heads[links.status] = links.next;
+            if (links.next)
+                links.next->statusLink.prev = links.prev;
+            else
+                tails[links.status] = links.prev;
+            counts[links.status]--;
+            links.prev = links.next = nullptr;
+            links.status = -1;
+        }
+    public:
+        StatusIndex()
+        {
+            clear();
+        }
+        // Links a task under its current status. Any previous link values are ignored.
+        void insert(Task* task)
+        {
+            link(task, task->taskStatus);
+        }
+        void remove(Task* task)
+        {
+            if (task->statusLink.status != -1)
+                unlink(task);
+        }
+        // Moves a task to the list for its current status, if it changed.
+        void update(Task* task)
+        {
+            if (task->statusLink.status == (int)task->taskStatus) return;
+            remove(task);
+            link(task, task->taskStatus);
+        }
+        int count(TaskStatus status) const
+        {
+            return counts[status];
+        }
+        // Oldest-first iteration: for (Task* t = first(s); t; t = next(t)).
+        Task* first(TaskStatus status) const
+        {
+            return heads[status];
+        }
+        static Task* next(const Task* task)
+        {
+            return task->statusLink.next;
+        }
+        void clear()
+        {
+            for (int i = 0; i < STATUS_COUNT; i++)
+            {
+                heads[i] = tails[i] = nullptr;
+                counts[i] = 0;
+            }
+        }
+};
+
+#endif
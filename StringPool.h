@@ -0,0 +1,357 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Process-wide intern table for task text. Equal strings share one
+// reference-counted, NUL-terminated copy, so copying a Task, an undo record or
+// a snapshot entry copies a pointer instead of the characters, and the
+// descriptions that generated tasks repeat are stored once.
+//
+// Text lives in 64 KB arena chunks; blocks of swept entries are recycled by
+// size class, and only strings longer than a kilobyte get an allocation of
+// their own. The table is split into 16 shards, each with its own lock and
+// open-addressed table, so the parallel import can intern from many threads.
+//
+// Dropping the last reference only marks an entry dead: taking or dropping a
+// reference you already hold is a single atomic operation. An intern of the
+// same text revives a dead entry; a shard sweeps its dead entries once they
+// outnumber the live ones. Both happen under the shard lock.
+class StringPool
+{
+    public:
+        struct Entry
+        {
+            atomic<uint32_t> refs;
+            uint32_t length;
+            size_t hash;
+            char* text()
+            {
+                return reinterpret_cast<char*>(this + 1);
+            }
+        };
+    private:
+        static const int SHARD_BITS = 4;
+        static const size_t CHUNK_BYTES = 64 << 10;
+        static const size_t BLOCK_ALIGN = 16;
+        static const size_t MAX_SMALL_BLOCK = 1024;
+        static const long MIN_SWEEP = 256;
+        struct Shard
+        {
+            mutex lock;
+            vector<Entry*> table;       // power-of-two size; nullptr marks an empty slot
+            atomic<size_t> used{0};     // entries in table, live or dead
+            atomic<long> dead{0};       // approximate; a sweep recounts
+            vector<char*> chunks;
+            char* next = nullptr;
+            char* end = nullptr;
+            vector<Entry*> freeBlocks[MAX_SMALL_BLOCK / BLOCK_ALIGN + 1];
+            size_t textBytes = 0;
+        };
+        Shard shards[1 << SHARD_BITS];
+
+        static size_t blockSize(size_t length)
+        {
+            return (sizeof(Entry) + length + 1 + BLOCK_ALIGN - 1) / BLOCK_ALIGN * BLOCK_ALIGN;
+        }
+        static Shard& shardOf(StringPool& pool, size_t hash)
+        {
+            return pool.shards[hash >> (sizeof(size_t) * 8 - SHARD_BITS)];
+        }
+        Entry* allocate(Shard& shard, size_t length)
+        {
+            size_t size = blockSize(length);
+            if (size > MAX_SMALL_BLOCK)
+                return static_cast<Entry*>(::operator new(size));
+            vector<Entry*>& recycled = shard.freeBlocks[size / BLOCK_ALIGN];
+            if (!recycled.empty())
+            {
+                Entry* block = recycled.back();
+                recycled.pop_back();
+                return block;
+            }
+            if ((size_t)(shard.end - shard.next) < size)
+            {
+                shard.chunks.push_back(static_cast<char*>(::operator new(CHUNK_BYTES)));
+                shard.next = shard.chunks.back();
+                shard.end = shard.next + CHUNK_BYTES;
+            }
+            Entry* block = reinterpret_cast<Entry*>(shard.next);
+            shard.next += size;
+            return block;
+        }
+        static void deallocate(Shard& shard, Entry* entry)
+        {
+            size_t size = blockSize(entry->length);
+            entry->~Entry();
+            if (size > MAX_SMALL_BLOCK)
+                ::operator delete(entry);
+            else
+                shard.freeBlocks[size / BLOCK_ALIGN].push_back(entry);
+        }
+        static void place(vector<Entry*>& table, Entry* entry)
+        {
+            size_t mask = table.size() - 1;
+            size_t slot = entry->hash & mask;
+            while (table[slot])
+                slot = (slot + 1) & mask;
+            table[slot] = entry;
+        }
+        // Rebuilds the shard's table at the given size, freeing dead entries.
+        // Caller holds the lock.
+        void rebuild(Shard& shard, size_t size)
+        {
+            vector<Entry*> table(size, nullptr);
+            size_t used = 0;
+            for (Entry* entry : shard.table)
+            {
+                if (!entry) continue;
+                if (entry->refs.load(memory_order_acquire) == 0)
+                {
+                    shard.textBytes -= entry->length;
+                    deallocate(shard, entry);
+                    continue;
+                }
+                place(table, entry);
+                used++;
+            }
+            shard.table.swap(table);
+            shard.used.store(used, memory_order_relaxed);
+            shard.dead.store(0, memory_order_relaxed);
+        }
+        void sweep(Shard& shard)
+        {
+            lock_guard<mutex> guard(shard.lock);
+            long dead = shard.dead.load(memory_order_relaxed);
+            if (dead < MIN_SWEEP || (size_t)dead * 2 < shard.used.load(memory_order_relaxed))
+                return;
+            rebuild(shard, shard.table.size());
+        }
+    public:
+        StringPool() = default;
+        StringPool(const StringPool&) = delete;
+        StringPool& operator=(const StringPool&) = delete;
+        ~StringPool()
+        {
+            for (Shard& shard : shards)
+            {
+                for (Entry* entry : shard.table)
+                {
+                    if (entry && blockSize(entry->length) > MAX_SMALL_BLOCK)
+                        ::operator delete(entry);
+                }
+                for (char* chunk : shard.chunks)
+                    ::operator delete(chunk);
+            }
+        }
+        // The pool every SharedString uses. Never destroyed, so strings held by
+        // static objects stay valid during exit.
+        static StringPool& global()
+        {
+            static StringPool* pool = new StringPool();
+            return *pool;
+        }
+
+        // Returns the entry for text with a reference taken; nullptr for "".
+        Entry* intern(string_view text)
+        {
+            if (text.empty()) return nullptr;
+            size_t hash = std::hash<string_view>()(text);
+            Shard& shard = shardOf(*this, hash);
+            lock_guard<mutex> guard(shard.lock);
+            if (!shard.table.empty())
+            {
+                size_t mask = shard.table.size() - 1;
+                for (size_t slot = hash & mask; Entry* entry = shard.table[slot]; slot = (slot + 1) & mask)
+                {
+                    if (entry->hash == hash && entry->length == text.size() && memcmp(entry->text(), text.data(), text.size()) == 0)
+                    {
+                        if (entry->refs.fetch_add(1, memory_order_relaxed) == 0)
+                            shard.dead.fetch_sub(1, memory_order_relaxed);
+                        return entry;
+                    }
+                }
+            }
+            if ((shard.used.load(memory_order_relaxed) + 1) * 2 > shard.table.size())
+                rebuild(shard, max<size_t>(64, shard.table.size() * 2));
+
+            Entry* entry = allocate(shard, text.size());
+            new (entry) Entry();
+            entry->refs.store(1, memory_order_relaxed);
+            entry->length = text.size();
+            entry->hash = hash;
+            memcpy(entry->text(), text.data(), text.size());
+            entry->text()[text.size()] = '\0';
+            place(shard.table, entry);
+            shard.used.fetch_add(1, memory_order_relaxed);
+            shard.textBytes += text.size();
+            return entry;
+        }
+        static void retain(Entry* entry)
+        {
+            entry->refs.fetch_add(1, memory_order_relaxed);
+        }
+        void release(Entry* entry)
+        {
+            // Once the count reaches zero another thread's sweep may free the
+            // entry, so find its shard first.
+            Shard& shard = shardOf(*this, entry->hash);
+            if (entry->refs.fetch_sub(1, memory_order_acq_rel) != 1) return;
+            long dead = shard.dead.fetch_add(1, memory_order_relaxed) + 1;
+            if (dead >= MIN_SWEEP && (size_t)dead * 2 >= shard.used.load(memory_order_relaxed))
+                sweep(shard);
+        }
+        // Distinct strings held, live or awaiting a sweep.
+        size_t size()
+        {
+            size_t total = 0;
+            for (Shard& shard : shards)
+                total += shard.used.load(memory_order_relaxed);
+            return total;
+        }
+        // Bytes of interned text.
+        size_t textBytes()
+        {
+            size_t total = 0;
+            for (Shard& shard : shards)
+            {
+                lock_guard<mutex> guard(shard.lock);
+                total += shard.textBytes;
+            }
+            return total;
+        }
+};
+
+// A string interned in StringPool::global(). Copying takes a reference,
+// moving takes nothing, and two SharedStrings are equal exactly when they
+// name the same entry. Reads go through string_view; assigning new text
+// interns it.
+class SharedString
+{
+    private:
+        StringPool::Entry* entry;
+        explicit SharedString(StringPool::Entry* adopted) : entry(adopted) {}
+    public:
+        SharedString() : entry(nullptr) {}
+        SharedString(string_view text) : entry(StringPool::global().intern(text)) {}
+        SharedString(const SharedString& other) : entry(other.entry)
+        {
+            if (entry) StringPool::retain(entry);
+        }
+        SharedString(SharedString&& other) noexcept : entry(other.entry)
+        {
+            other.entry = nullptr;
+        }
+        ~SharedString()
+        {
+            if (entry) StringPool::global().release(entry);
+        }
+        SharedString& operator=(const SharedString& other)
+        {
+            SharedString copy(other);
+            swap(entry, copy.entry);
+            return *this;
+        }
+        SharedString& operator=(SharedString&& other) noexcept
+        {
+            swap(entry, other.entry);
+            return *this;
+        }
+        SharedString& operator=(string_view text)
+        {
+            return assign(text);
+        }
+        SharedString& assign(string_view text)
+        {
+            if (view() != text)
+            {
+                SharedString interned(text);
+                swap(entry, interned.entry);
+            }
+            return *this;
+        }
+        string_view view() const
+        {
+            return entry ? string_view(entry->text(), entry->length) : string_view();
+        }
+        operator string_view() const
+        {
+            return view();
+        }
+        const char* c_str() const
+        {
+            return entry ? entry->text() : "";
+        }
+        size_t size() const
+        {
+            return entry ? entry->length : 0;
+        }
+        bool empty() const
+        {
+            return entry == nullptr;
+        }
+        string str() const
+        {
+            return string(view());
+        }
+
+        // For containers that keep strings as raw bytes (UndoLog): token() names
+        // the string, retainToken/releaseToken count references held that way,
+        // and fromToken turns one back into a SharedString with its own reference.
+        uintptr_t token() const
+        {
+            return reinterpret_cast<uintptr_t>(entry);
+        }
+        static void retainToken(uintptr_t token)
+        {
+            if (token) StringPool::retain(reinterpret_cast<StringPool::Entry*>(token));
+        }
+        static void releaseToken(uintptr_t token)
+        {
+            if (token) StringPool::global().release(reinterpret_cast<StringPool::Entry*>(token));
+        }
+        static size_t tokenLength(uintptr_t token)
+        {
+            return token ? reinterpret_cast<StringPool::Entry*>(token)->length : 0;
+        }
+        static SharedString fromToken(uintptr_t token)
+        {
+            retainToken(token);
+            return SharedString(reinterpret_cast<StringPool::Entry*>(token));
+        }
+
+        friend bool operator==(const SharedString& a, const SharedString& b)
+        {
+            return a.entry == b.entry;
+        }
+        friend bool operator!=(const SharedString& a, const SharedString& b)
+        {
+            return a.entry != b.entry;
+        }
+        friend bool operator==(const SharedString& a, string_view b)
+        {
+            return a.view() == b;
+        }
+        friend bool operator!=(const SharedString& a, string_view b)
+        {
+            return a.view() != b;
+        }
+        friend ostream& operator<<(ostream& out, const SharedString& text)
+        {
+            return out << text.view();
+        }
+};
+
+#endif
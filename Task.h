@@ -0,0 +1,184 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <ctime>
+#include <fstream>
+#include "StringPool.h"
+
+using namespace std;
+
+enum TaskStatus 
+{
+    PENDING,
+    IN_PROGRESS,
+    COMPLETED
+};
+
+// Slot of a task inside TaskStore; the generation changes whenever the slot is reused.
+struct TaskHandle
+{
+    uint32_t index;
+    uint32_t generation;
+};
+
+class Task;
+
+// Links of a task inside StatusIndex's per-status list; status is -1 while unlinked.
+struct StatusLink
+{
+    Task* prev;
+    Task* next;
+    int status;
+};
+
+// Links of a task inside TimingWheel; list is -1 while the task is not scheduled.
+struct DueLink
+{
+    Task* prev;
+    Task* next;
+    int64_t tick;
+    int list;
+};
+
+class Task 
+{
+    public:
+        int taskId;
+        SharedString taskName;  // interned, so copies share the text
+        SharedString taskDescription;
+        TaskStatus taskStatus;
+        int taskPriority;
+        time_t taskDueDate;
+        time_t taskCreationDate;
+        time_t taskCompletionDate;
+        TaskHandle handle;  // set by TaskStore, not copied with the task
+        StatusLink statusLink;  // set by StatusIndex, not copied with the task
+        DueLink dueLink;  // set by TimingWheel, not copied with the task
+        Task() : taskId(-1), taskName(), taskDescription(), taskStatus(PENDING),
+            taskPriority(0), taskDueDate(0), taskCreationDate(0), taskCompletionDate(0), handle(), statusLink{ nullptr, nullptr, -1 }, dueLink{ nullptr, nullptr, 0, -1 } {}
+        Task(int id, string_view name, string_view description, TaskStatus status, int priority, time_t dueDate)
+            : taskId(id), taskName(name), taskDescription(description), taskStatus(status),
+            taskPriority(priority), taskDueDate(dueDate), taskCreationDate(time(0)), taskCompletionDate(0), handle(), statusLink{ nullptr, nullptr, -1 }, dueLink{ nullptr, nullptr, 0, -1 } {}
+        Task(const Task& other)
+            : taskId(other.taskId), taskName(other.taskName), taskDescription(other.taskDescription),
+            taskStatus(other.taskStatus), taskPriority(other.taskPriority), taskDueDate(other.taskDueDate),
+            taskCreationDate(other.taskCreationDate), taskCompletionDate(other.taskCompletionDate), handle(), statusLink{ nullptr, nullptr, -1 }, dueLink{ nullptr, nullptr, 0, -1 } {}
+        Task& operator=(const Task& other) 
+        {
+            if (this != &other) 
+            {
+                taskId = other.taskId;
+                taskName = other.taskName;
+                taskDescription = other.taskDescription;
+                taskStatus = other.taskStatus;
+                taskPriority = other.taskPriority;
+                taskDueDate = other.taskDueDate;
+                taskCreationDate = other.taskCreationDate;
+                taskCompletionDate = other.taskCompletionDate;
+            }
+            return *this;
+        }
+        Task(Task&& other) noexcept
+            : taskId(other.taskId), taskName(std::move(other.taskName)), taskDescription(std::move(other.taskDescription)),
+            taskStatus(other.taskStatus), taskPriority(other.taskPriority), taskDueDate(other.taskDueDate),
+            taskCreationDate(other.taskCreationDate), taskCompletionDate(other.taskCompletionDate), handle(), statusLink{ nullptr, nullptr, -1 }, dueLink{ nullptr, nullptr, 0, -1 } {}
+        Task& operator=(Task&& other) noexcept
+        {
+            if (this != &other) 
+            {
+                taskId = other.taskId;
+                taskName = std::move(other.taskName);
+                taskDescription = std::move(other.taskDescription);
+                taskStatus = other.taskStatus;
+                taskPriority = other.taskPriority;
+                taskDueDate = other.taskDueDate;
+                taskCreationDate = other.taskCreationDate;
+                taskCompletionDate = other.taskCompletionDate;
+            }
+            return *this;
+        }
+        void completeTask() 
+        {
+            taskStatus = COMPLETED;
+            taskCompletionDate = time(0);
+        }
+        string formatTime(time_t t) const 
+        {
+            if (t == 0) return "N/A";
+            char buffer[20];
+            strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", localtime(&t));
+            return string(buffer);
+        }
+        void displayTask() const 
+        {
+            cout << "Task ID: " << taskId << endl;
+            cout << "Task Name: " << taskName << endl;
+            cout << "Task Description: " << taskDescription << endl;
+            cout << "Task Status: " << (taskStatus == PENDING ? "Pending" : (taskStatus == IN_PROGRESS ? "In Progress" : "Completed")) << endl;
+            cout << "Task Priority: " << taskPriority << endl;
+            cout << "Task Due Date: " << formatTime(taskDueDate) << endl;
+            cout << "Task Creation Date: " << formatTime(taskCreationDate) << endl;
+            if (taskCompletionDate != 0)
+                cout << "Task Completion Date: " << formatTime(taskCompletionDate) << endl;
+            cout << "------------------------" << endl;
+        }
+        bool isValid() const 
+        {
+            return taskId != -1;
+        }
+        
+        // Added for file handling - write task to file stream
+        void writeToFile(ofstream& outFile) const 
+        {
+            outFile << taskId << endl;
+            outFile << taskName << endl;
+            outFile << taskDescription << endl;
+            outFile << taskStatus << endl;
+            outFile << taskPriority << endl;
+            outFile << taskDueDate << endl;
+            outFile << taskCreationDate << endl;
+            outFile << taskCompletionDate << endl;
+        }
+        
+        // Added for file handling - read task from file stream
+        bool readFromFile(ifstream& inFile) 
+        {
+            if (!inFile.good()) return false;
+            
+            inFile >> taskId;
+            inFile.ignore(); // Skip newline
+            
+            string line;
+            getline(inFile, line);
+            taskName = line;
+            getline(inFile, line);
+            taskDescription = line;
+            
+            int status;
+            inFile >> status;
+            taskStatus = static_cast<TaskStatus>(status);
+            
+            inFile >> taskPriority;
+            inFile >> taskDueDate;
+            inFile >> taskCreationDate;
+            inFile >> taskCompletionDate;
+            
+            inFile.ignore(); // Skip newline
+            return true;
+        }
+};
+
+// Fields of a task to be created in bulk; the scheduler assigns IDs.
+struct TaskSpec
+{
+    string name;
+    string description;
+    TaskStatus status;
+    int priority;
+    time_t dueDate;
+};
+
+#endif
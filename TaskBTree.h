@@ -0,0 +1,703 @@
+#ifndef TASKBTREE_H
+#define TASKBTREE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "BufferPool.h"
+#include "Task.h"
+
+using namespace std;
+
+// Tasks on disk in a B+tree keyed by task ID, read and written a page at a time
+// through a BufferPool, so the file can be far larger than memory and a lookup
+// touches one page per level. Leaves are chained in key order for range scans.
+//
+// Page 0 is the file header. Every other page is a leaf, an internal node, an
+// overflow page or a free page; each starts with [u32 crc][u8 type][u8 -]
+// [u16 count][u16 dataStart][u16 -][u32 next], 16 bytes.
+//   Leaf:     a slot array of [i32 key][u16 offset][u16 length] sorted by key,
+//             growing up from byte 16, and the records, growing down from the
+//             end of the page. next is the right sibling (0: none).
+//   Internal: [u32 child0] then count [i32 key][u32 child] pairs. A key lives
+//             in the child to the left of the first separator greater than it.
+//   Overflow: up to a page of a record too long to keep in its leaf; next
+//             continues the chain.
+//   Free:     next is the next free page.
+// Removals do not merge underfull pages: the tree only ever holds completed
+// tasks, which are rarely removed, and their space is reused by later inserts
+// into the same leaf.
+//
+// Every change since the last flush() becomes durable together when flush()
+// commits the pool. Until then pages may already have been written in place,
+// and freed pages reused, but the pool's rollback journal keeps their old
+// images: a crash part way through, or closing without a flush, returns the
+// file to its last flushed state on the next open(). A torn page fails its
+// checksum on read.
+class TaskBTree
+{
+    private:
+        static const uint32_t VERSION = 1;
+        static const size_t PAGE = BufferPool::PAGE_SIZE;
+        static const size_t BODY = 16;
+        static const size_t SLOT = 8;
+        static const int MAX_KEYS = (PAGE - BODY - 4) / 8;
+        // Records longer than this move to overflow pages, so any two records
+        // plus half a leaf fit in one page and a split always succeeds.
+        static const size_t MAX_INLINE = (PAGE - BODY) / 4 - SLOT;
+        enum PageType
+        {
+            PAGE_LEAF = 1,
+            PAGE_INTERNAL = 2,
+            PAGE_OVERFLOW = 3,
+            PAGE_FREE = 4
+        };
+        enum RecordForm
+        {
+            RECORD_INLINE = 0,
+            RECORD_OVERFLOW = 1     // [u32 length][u32 first overflow page]
+        };
+
+        BufferPool pool;
+        string lastError;
+        uint32_t root;
+        uint32_t pageCount;
+        uint32_t freeHead;
+        uint32_t height;        // 1 while the root is a leaf
+        uint64_t taskCount;
+
+        template <typename T>
+        static T load(const char* page, size_t offset)
+        {
+            T value;
+            memcpy(&value, page + offset, sizeof(T));
+            return value;
+        }
+        template <typename T>
+        static void store(char* page, size_t offset, T value)
+        {
+            memcpy(page + offset, &value, sizeof(T));
+        }
+        static uint8_t typeOf(const char* page) { return load<uint8_t>(page, 4); }
+        static uint16_t countOf(const char* page) { return load<uint16_t>(page, 6); }
+        static uint16_t dataStartOf(const char* page) { return load<uint16_t>(page, 8); }
+        static uint32_t nextOf(const char* page) { return load<uint32_t>(page, 12); }
+        static void setType(char* page, uint8_t type) { store<uint8_t>(page, 4, type); }
+        static void setCount(char* page, uint16_t count) { store<uint16_t>(page, 6, count); }
+        static void setDataStart(char* page, uint16_t start) { store<uint16_t>(page, 8, start); }
+        static void setNext(char* page, uint32_t next) { store<uint32_t>(page, 12, next); }
+
+        // Leaf slots
+        static int32_t slotKey(const char* page, int i) { return load<int32_t>(page, BODY + i * SLOT); }
+        static uint16_t slotOffset(const char* page, int i) { return load<uint16_t>(page, BODY + i * SLOT + 4); }
+        static uint16_t slotLength(const char* page, int i) { return load<uint16_t>(page, BODY + i * SLOT + 6); }
+        static size_t leafFree(const char* page)
+        {
+            return dataStartOf(page) - (BODY + countOf(page) * SLOT);
+        }
+        // First slot whose key is not less than key.
+        static int leafLowerBound(const char* page, int key)
+        {
+            int low = 0, high = countOf(page);
+            while (low < high)
+            {
+                int mid = (low + high) / 2;
+                if (slotKey(page, mid) < key)
+                    low = mid + 1;
+                else
+                    high = mid;
+            }
+            return low;
+        }
+        static void initLeaf(char* page, uint32_t next)
+        {
+            setType(page, PAGE_LEAF);
+            setCount(page, 0);
+            setDataStart(page, PAGE);
+            setNext(page, next);
+        }
+        // Inserts a slot at index; the caller has checked there is room.
+        static void leafInsert(char* page, int index, int key, const string& record)
+        {
+            int count = countOf(page);
+            char* slots = page + BODY;
+            memmove(slots + (index + 1) * SLOT, slots + index * SLOT, (count - index) * SLOT);
+            uint16_t start = dataStartOf(page) - record.size();
+            memcpy(page + start, record.data(), record.size());
+            store<int32_t>(page, BODY + index * SLOT, key);
+            store<uint16_t>(page, BODY + index * SLOT + 4, start);
+            store<uint16_t>(page, BODY + index * SLOT + 6, record.size());
+            setDataStart(page, start);
+            setCount(page, count + 1);
+        }
+        // Rewrites a leaf from entries, dropping the holes removals left.
+        static void fillLeaf(char* page, const vector<pair<int, string>>& entries, size_t first, size_t last, uint32_t next)
+        {
+            initLeaf(page, next);
+            for (size_t i = first; i < last; i++)
+                leafInsert(page, i - first, entries[i].first, entries[i].second);
+        }
+        static void readLeaf(const char* page, vector<pair<int, string>>& entries)
+        {
+            for (int i = 0; i < countOf(page); i++)
+                entries.emplace_back(slotKey(page, i), string(page + slotOffset(page, i), slotLength(page, i)));
+        }
+
+        // Internal nodes
+        static uint32_t childAt(const char* page, int i)
+        {
+            return i == 0 ? load<uint32_t>(page, BODY) : load<uint32_t>(page, BODY + 4 + (i - 1) * 8 + 4);
+        }
+        static int32_t separatorAt(const char* page, int i)
+        {
+            return load<int32_t>(page, BODY + 4 + i * 8);
+        }
+        // Index of the child that holds key.
+        static int childIndexFor(const char* page, int key)
+        {
+            int low = 0, high = countOf(page);
+            while (low < high)
+            {
+                int mid = (low + high) / 2;
+                if (separatorAt(page, mid) <= key)
+                    low = mid + 1;
+                else
+                    high = mid;
+            }
+            return low;
+        }
+        static void fillInternal(char* page, uint32_t child0, const vector<pair<int, uint32_t>>& entries, size_t first, size_t last)
+        {
+            setType(page, PAGE_INTERNAL);
+            setCount(page, last - first);
+            setNext(page, 0);
+            store<uint32_t>(page, BODY, child0);
+            for (size_t i = first; i < last; i++)
+            {
+                store<int32_t>(page, BODY + 4 + (i - first) * 8, entries[i].first);
+                store<uint32_t>(page, BODY + 4 + (i - first) * 8 + 4, entries[i].second);
+            }
+        }
+
+        bool fail(const string& message)
+        {
+            lastError = message;
+            return false;
+        }
+        bool failPage(uint32_t page)
+        {
+            return fail(pool.error().empty() ? "could not read page " + to_string(page) : pool.error());
+        }
+        // Pins a new zeroed page, reusing a free one if there is any.
+        PageRef allocate()
+        {
+            uint32_t page;
+            if (freeHead != 0)
+            {
+                page = freeHead;
+                PageRef freed(pool, page);
+                if (!freed) return PageRef();
+                freeHead = nextOf(freed.data());
+            }
+            else
+            {
+                page = pageCount++;
+            }
+            return PageRef(pool, page, true);
+        }
+        bool release(uint32_t page)
+        {
+            PageRef freed(pool, page, true);
+            if (!freed) return failPage(page);
+            setType(freed.data(), PAGE_FREE);
+            setNext(freed.data(), freeHead);
+            freeHead = page;
+            return true;
+        }
+        bool releaseAll(const vector<uint32_t>& pages)
+        {
+            for (uint32_t page : pages)
+            {
+                if (!release(page)) return false;
+            }
+            return true;
+        }
+        // Gives back pages allocated for a change that failed; always false, so
+        // callers can return it. The first error is the one reported.
+        bool discard(const vector<uint32_t>& pages)
+        {
+            string error = lastError;
+            releaseAll(pages);
+            lastError = error;
+            return false;
+        }
+        bool discard(vector<PageRef>& pinned, const vector<uint32_t>& pages)
+        {
+            vector<uint32_t> all = pages;
+            for (PageRef& page : pinned)
+            {
+                all.push_back(page.page());
+                page.release();
+            }
+            pinned.clear();
+            return discard(all);
+        }
+
+        static void putTask(string& out, const Task& task)
+        {
+            auto put = [&out](const void* value, size_t size) { out.append(static_cast<const char*>(value), size); };
+            uint8_t status = task.taskStatus;
+            int32_t priority = task.taskPriority;
+            int64_t dates[3] = { (int64_t)task.taskDueDate, (int64_t)task.taskCreationDate, (int64_t)task.taskCompletionDate };
+            string_view name = task.taskName.view(), description = task.taskDescription.view();
+            uint32_t nameLength = name.size(), descriptionLength = description.size();
+            put(&status, 1);
+            put(&priority, 4);
+            put(dates, sizeof(dates));
+            put(&nameLength, 4);
+            out.append(name);
+            put(&descriptionLength, 4);
+            out.append(description);
+        }
+        static bool getTask(const string& in, int taskId, Task& task)
+        {
+            const size_t fixed = 1 + 4 + 24 + 4;
+            if (in.size() < fixed) return false;
+            uint32_t nameLength = load<uint32_t>(in.data(), 29);
+            if (in.size() < fixed + nameLength + 4) return false;
+            uint32_t descriptionLength = load<uint32_t>(in.data(), fixed + nameLength);
+            if (in.size() != fixed + nameLength + 4 + descriptionLength) return false;
+            task.taskId = taskId;
+            task.taskStatus = static_cast<TaskStatus>(load<uint8_t>(in.data(), 0));
+            task.taskPriority = load<int32_t>(in.data(), 1);
+            task.taskDueDate = load<int64_t>(in.data(), 5);
+            task.taskCreationDate = load<int64_t>(in.data(), 13);
+            task.taskCompletionDate = load<int64_t>(in.data(), 21);
+            task.taskName.assign(string_view(in.data() + fixed, nameLength));
+            task.taskDescription.assign(string_view(in.data() + fixed + nameLength + 4, descriptionLength));
+            return true;
+        }
+        // The leaf record for task: the fields inline, or a pointer to a chain
+        // of overflow pages holding them, which are added to chain. On failure
+        // the pages allocated so far are freed again.
+        bool encode(const Task& task, string& record, vector<uint32_t>& chain)
+        {
+            string payload;
+            putTask(payload, task);
+            record.assign(1, (char)RECORD_INLINE);
+            if (payload.size() + 1 <= MAX_INLINE)
+            {
+                record += payload;
+                return true;
+            }
+            // Written back to front, so each page can point at the one after it.
+            size_t chunk = PAGE - BODY;
+            uint32_t next = 0;
+            for (size_t end = payload.size(); end > 0; )
+            {
+                size_t begin = (end - 1) / chunk * chunk;
+                PageRef page = allocate();
+                if (!page)
+                {
+                    failPage(0);
+                    return discard(chain);
+                }
+                chain.push_back(page.page());
+                setType(page.data(), PAGE_OVERFLOW);
+                setCount(page.data(), end - begin);
+                setNext(page.data(), next);
+                memcpy(page.data() + BODY, payload.data() + begin, end - begin);
+                next = page.page();
+                end = begin;
+            }
+            record.assign(1, (char)RECORD_OVERFLOW);
+            uint32_t length = payload.size();
+            record.append(reinterpret_cast<const char*>(&length), 4);
+            record.append(reinterpret_cast<const char*>(&next), 4);
+            return true;
+        }
+        bool decode(const char* record, size_t length, int taskId, Task& task)
+        {
+            if (length == 0) return fail("empty record for task " + to_string(taskId));
+            if (record[0] == RECORD_INLINE)
+            {
+                if (!getTask(string(record + 1, length - 1), taskId, task))
+                    return fail("corrupt record for task " + to_string(taskId));
+                return true;
+            }
+            if (length != 9) return fail("corrupt record for task " + to_string(taskId));
+            uint32_t total = load<uint32_t>(record, 1);
+            uint32_t next = load<uint32_t>(record, 5);
+            string payload;
+            payload.reserve(total);
+            while (next != 0 && payload.size() < total)
+            {
+                PageRef page(pool, next);
+                if (!page) return failPage(next);
+                if (typeOf(page.data()) != PAGE_OVERFLOW)
+                    return fail("broken overflow chain for task " + to_string(taskId));
+                payload.append(page.data() + BODY, countOf(page.data()));
+                next = nextOf(page.data());
+            }
+            if (!getTask(payload, taskId, task))
+                return fail("corrupt record for task " + to_string(taskId));
+            return true;
+        }
+        // The overflow pages of record, first to last; none if it is inline.
+        bool overflowPages(const char* record, size_t length, vector<uint32_t>& pages)
+        {
+            if (length != 9 || record[0] != RECORD_OVERFLOW) return true;
+            for (uint32_t next = load<uint32_t>(record, 5); next != 0; )
+            {
+                PageRef page(pool, next);
+                if (!page) return failPage(next);
+                if (typeOf(page.data()) != PAGE_OVERFLOW)
+                    return fail("broken overflow chain at page " + to_string(next));
+                pages.push_back(next);
+                next = nextOf(page.data());
+            }
+            return true;
+        }
+
+        // Walks from the root to the leaf that holds key, noting the internal
+        // pages passed through (root first) if path is given.
+        bool findLeaf(int key, PageRef& leaf, vector<uint32_t>* path)
+        {
+            uint32_t page = root;
+            for (uint32_t level = height; level > 1; level--)
+            {
+                PageRef node(pool, page);
+                if (!node) return failPage(page);
+                if (typeOf(node.data()) != PAGE_INTERNAL)
+                    return fail("page " + to_string(page) + " should be an internal node");
+                if (path) path->push_back(page);
+                page = childAt(node.data(), childIndexFor(node.data(), key));
+            }
+            leaf = PageRef(pool, page);
+            if (!leaf) return failPage(page);
+            if (typeOf(leaf.data()) != PAGE_LEAF)
+                return fail("page " + to_string(page) + " should be a leaf");
+            return true;
+        }
+        // Allocates the pages splitting the leaf under path will take: the new
+        // leaf, a new node for every full internal node above it, and a new root
+        // if the split reaches the top.
+        bool reserveSplitPages(const vector<uint32_t>& path, vector<PageRef>& spare)
+        {
+            size_t needed = 1;
+            size_t level = path.size();
+            for (; level > 0; level--)
+            {
+                PageRef node(pool, path[level - 1]);
+                if (!node) return failPage(path[level - 1]);
+                if (countOf(node.data()) < MAX_KEYS) break;
+                needed++;
+            }
+            if (level == 0)
+                needed++;
+            while (spare.size() < needed)
+            {
+                PageRef page = allocate();
+                if (!page)
+                {
+                    failPage(0);
+                    return discard(spare, {});
+                }
+                spare.push_back(move(page));
+            }
+            return true;
+        }
+        static PageRef takeSpare(vector<PageRef>& spare)
+        {
+            PageRef page = move(spare.back());
+            spare.pop_back();
+            return page;
+        }
+        // Adds separator and the page right of it to the parent of left,
+        // splitting parents up to the root as needed. New pages come from
+        // spare, which reserveSplitPages filled.
+        bool insertIntoParent(vector<uint32_t>& path, uint32_t left, int separator, uint32_t right, vector<PageRef>& spare)
+        {
+            if (path.empty())
+            {
+                PageRef newRoot = takeSpare(spare);
+                fillInternal(newRoot.data(), left, { { separator, right } }, 0, 1);
+                root = newRoot.page();
+                height++;
+                return true;
+            }
+            uint32_t parentPage = path.back();
+            path.pop_back();
+            PageRef parent(pool, parentPage);
+            if (!parent) return failPage(parentPage);
+            char* node = parent.data();
+            int count = countOf(node);
+            vector<pair<int, uint32_t>> entries;
+            entries.reserve(count + 1);
+            for (int i = 0; i < count; i++)
+                entries.emplace_back(separatorAt(node, i), childAt(node, i + 1));
+            int index = childIndexFor(node, separator);
+            entries.insert(entries.begin() + index, make_pair(separator, right));
+            uint32_t child0 = childAt(node, 0);
+            parent.markDirty();
+            if ((int)entries.size() <= MAX_KEYS)
+            {
+                fillInternal(node, child0, entries, 0, entries.size());
+                return true;
+            }
+            // The middle separator moves up; its child starts the new right node.
+            size_t middle = entries.size() / 2;
+            PageRef sibling = takeSpare(spare);
+            fillInternal(node, child0, entries, 0, middle);
+            fillInternal(sibling.data(), entries[middle].second, entries, middle + 1, entries.size());
+            uint32_t siblingPage = sibling.page();
+            parent.release();
+            sibling.release();
+            return insertIntoParent(path, parentPage, entries[middle].first, siblingPage, spare);
+        }
+        // Drops the slot at index; its record bytes stay behind as a hole.
+        static void removeSlot(char* page, int index)
+        {
+            int count = countOf(page);
+            memmove(page + BODY + index * SLOT, page + BODY + (index + 1) * SLOT, (count - index - 1) * SLOT);
+            setCount(page, count - 1);
+            if (count == 1)
+                setDataStart(page, PAGE);
+        }
+        void writeHeader(char* page)
+        {
+            memcpy(page + 4, "TASKTREE", 8);
+            store<uint32_t>(page, 12, VERSION);
+            store<uint32_t>(page, 16, PAGE);
+            store<uint32_t>(page, 20, root);
+            store<uint32_t>(page, 24, pageCount);
+            store<uint32_t>(page, 28, freeHead);
+            store<uint32_t>(page, 32, height);
+            store<uint64_t>(page, 36, taskCount);
+        }
+        // Lays out an empty tree: the header and one empty leaf as the root.
+        bool format()
+        {
+            root = 1;
+            pageCount = 2;
+            freeHead = 0;
+            height = 1;
+            taskCount = 0;
+            {
+                PageRef header(pool, 0, true);
+                PageRef leaf(pool, 1, true);
+                if (!header || !leaf) return failPage(0);
+                writeHeader(header.data());
+                initLeaf(leaf.data(), 0);
+            }
+            return flush();
+        }
+    public:
+        explicit TaskBTree(size_t cachePages = 256)
+            : pool(cachePages), root(0), pageCount(0), freeHead(0), height(0), taskCount(0) {}
+        TaskBTree(const TaskBTree&) = delete;
+        TaskBTree& operator=(const TaskBTree&) = delete;
+
+        // Opens the tree in path, creating an empty one if the file is new.
+        bool open(const string& path)
+        {
+            if (!pool.open(path)) return fail(pool.error());
+            if (pool.filePages() == 0) return format();
+            PageRef header(pool, 0);
+            if (!header) return fail(path + ": " + pool.error());
+            const char* page = header.data();
+            if (memcmp(page + 4, "TASKTREE", 8) != 0) return fail(path + " is not a task tree");
+            if (load<uint32_t>(page, 12) != VERSION || load<uint32_t>(page, 16) != PAGE)
+                return fail(path + " was written by an incompatible version");
+            root = load<uint32_t>(page, 20);
+            pageCount = load<uint32_t>(page, 24);
+            freeHead = load<uint32_t>(page, 28);
+            height = load<uint32_t>(page, 32);
+            taskCount = load<uint64_t>(page, 36);
+            if (root == 0 || root >= pageCount || height == 0 || pageCount > pool.filePages())
+                return fail(path + " has a corrupt header");
+            return true;
+        }
+        bool isOpen() const
+        {
+            return pool.isOpen() && height > 0;
+        }
+        // Copies taskId's stored state into task. False if it is not stored or
+        // could not be read; error() tells which.
+        bool get(int taskId, Task& task)
+        {
+            lastError.clear();
+            PageRef leaf;
+            if (!findLeaf(taskId, leaf, nullptr)) return false;
+            const char* page = leaf.data();
+            int index = leafLowerBound(page, taskId);
+            if (index == countOf(page) || slotKey(page, index) != taskId) return false;
+            return decode(page + slotOffset(page, index), slotLength(page, index), taskId, task);
+        }
+        bool contains(int taskId)
+        {
+            PageRef leaf;
+            if (!findLeaf(taskId, leaf, nullptr)) return false;
+            int index = leafLowerBound(leaf.data(), taskId);
+            return index < countOf(leaf.data()) && slotKey(leaf.data(), index) == taskId;
+        }
+        // Stores task under its ID, replacing any earlier state. Every page the
+        // change needs is allocated before the tree is touched, so a failure
+        // leaves the tree as it was; the old record's overflow pages are freed
+        // last, once nothing refers to them.
+        bool put(const Task& task)
+        {
+            lastError.clear();
+            vector<uint32_t> path;
+            PageRef leaf;
+            if (!findLeaf(task.taskId, leaf, &path)) return false;
+            string record;
+            vector<uint32_t> chain;
+            if (!encode(task, record, chain)) return false;
+            char* page = leaf.data();
+            int index = leafLowerBound(page, task.taskId);
+            bool replacing = index < countOf(page) && slotKey(page, index) == task.taskId;
+            vector<uint32_t> oldChain;
+            if (replacing && !overflowPages(page + slotOffset(page, index), slotLength(page, index), oldChain))
+                return discard(chain);
+            size_t needed = record.size() + SLOT;
+            if (leafFree(page) + (replacing ? SLOT : 0) >= needed)
+            {
+                if (replacing)
+                    removeSlot(page, index);
+                leafInsert(page, index, task.taskId, record);
+                leaf.markDirty();
+            }
+            else
+            {
+                vector<pair<int, string>> entries;
+                readLeaf(page, entries);
+                if (replacing)
+                    entries[index].second = record;
+                else
+                    entries.insert(entries.begin() + index, make_pair(task.taskId, record));
+                size_t total = 0;
+                for (const auto& entry : entries)
+                    total += entry.second.size() + SLOT;
+                if (total <= PAGE - BODY)
+                {
+                    // Fits once the holes left by removals and replacements are reclaimed.
+                    fillLeaf(page, entries, 0, entries.size(), nextOf(page));
+                    leaf.markDirty();
+                }
+                else
+                {
+                    vector<PageRef> spare;
+                    if (!reserveSplitPages(path, spare)) return discard(chain);
+                    // Split by bytes, so both halves have room whatever the record
+                    // sizes. Appending past the last key starts a fresh leaf instead,
+                    // so tasks archived in ID order leave full leaves behind them.
+                    size_t middle = 0;
+                    if (!replacing && index == countOf(page) && nextOf(page) == 0)
+                    {
+                        middle = entries.size() - 1;
+                    }
+                    else
+                    {
+                        size_t half = 0;
+                        while (middle + 1 < entries.size() && half + entries[middle].second.size() + SLOT <= total / 2)
+                            half += entries[middle++].second.size() + SLOT;
+                        middle = max<size_t>(middle, 1);
+                    }
+                    PageRef sibling = takeSpare(spare);
+                    fillLeaf(sibling.data(), entries, middle, entries.size(), nextOf(page));
+                    fillLeaf(page, entries, 0, middle, sibling.page());
+                    leaf.markDirty();
+                    uint32_t leafPage = leaf.page(), siblingPage = sibling.page();
+                    leaf.release();
+                    sibling.release();
+                    if (!insertIntoParent(path, leafPage, entries[middle].first, siblingPage, spare)) return false;
+                }
+            }
+            if (!replacing)
+                taskCount++;
+            return releaseAll(oldChain);
+        }
+        // Deletes taskId. Returns false if it was not stored or on error.
+        bool remove(int taskId)
+        {
+            lastError.clear();
+            PageRef leaf;
+            if (!findLeaf(taskId, leaf, nullptr)) return false;
+            char* page = leaf.data();
+            int index = leafLowerBound(page, taskId);
+            if (index == countOf(page) || slotKey(page, index) != taskId) return false;
+            vector<uint32_t> chain;
+            if (!overflowPages(page + slotOffset(page, index), slotLength(page, index), chain)) return false;
+            removeSlot(page, index);
+            leaf.markDirty();
+            taskCount--;
+            releaseAll(chain);  // on failure the pages are only lost to reuse
+            return true;
+        }
+        // Calls visit(task) for every stored task with an ID in [first, last],
+        // in ID order, until visit returns false. visit must not change the tree.
+        template <typename Visit>
+        bool scan(int first, int last, Visit visit)
+        {
+            PageRef leaf;
+            if (!findLeaf(first, leaf, nullptr)) return false;
+            Task task;
+            int index = leafLowerBound(leaf.data(), first);
+            while (true)
+            {
+                const char* page = leaf.data();
+                for (; index < countOf(page); index++)
+                {
+                    int key = slotKey(page, index);
+                    if (key > last) return true;
+                    if (!decode(page + slotOffset(page, index), slotLength(page, index), key, task)) return false;
+                    if (!visit(task)) return true;
+                }
+                uint32_t next = nextOf(page);
+                if (next == 0) return true;
+                leaf = PageRef(pool, next);
+                if (!leaf) return failPage(next);
+                index = 0;
+            }
+        }
+        uint64_t size() const
+        {
+            return taskCount;
+        }
+        // Writes the header and every changed page, fsyncs and commits.
+        bool flush()
+        {
+            {
+                PageRef header(pool, 0);
+                if (!header) return failPage(0);
+                writeHeader(header.data());
+                header.markDirty();
+            }
+            if (!pool.flush()) return fail(pool.error());
+            return true;
+        }
+        // Removes every task.
+        bool clear()
+        {
+            if (!pool.truncate()) return fail(pool.error());
+            return format();
+        }
+        const string& error() const
+        {
+            return lastError;
+        }
+        long long pageReads() const
+        {
+            return pool.pageReads();
+        }
+        long long pageWrites() const
+        {
+            return pool.pageWrites();
+        }
+};
+
+#endif
@@ -0,0 +1,261 @@
+#ifndef TASKHASHMAP_H
+#define TASKHASHMAP_H
+
+#include <cstdint>
+#include <utility>
+#include "Task.h"
+
+// Open-addressing map from task ID to Task*, using Robin Hood probing over a
+// power-of-two slot array. IDs live in the slots so probes never touch the
+// tasks themselves. When the load factor passes 7/8 a table twice the size is
+// allocated and the old one is drained a few slots per insert/delete, so no
+// single operation pays for a full rehash.
+class TaskHashMap
+{
+    private:
+        static const int INITIAL_CAPACITY = 16;
+        static const int MIGRATE_STEP = 8;
+        struct Slot
+        {
+            int taskId;
+            int distance;   // probe length + 1, 0 for an empty slot
+            Task* task;     // nullptr marks a tombstone in the draining table
+        };
+        struct Table
+        {
+            Slot* slots;
+            int capacity;
+            int shift;
+            int count;
+        };
+        Table current;
+        Table draining;
+        int drainCursor;
+        static Table makeTable(int capacity)
+        {
+            Table table;
+            table.slots = new Slot[capacity];
+            for (int i = 0; i < capacity; i++)
+                table.slots[i] = Slot{ -1, 0, nullptr };
+            table.capacity = capacity;
+            table.shift = 32;
+            for (int c = capacity; c > 1; c >>= 1)
+                table.shift--;
+            table.count = 0;
+            return table;
+        }
+        static Table emptyTable()
+        {
+            return Table{ nullptr, 0, 32, 0 };
+        }
+        static uint32_t hashFunction(int taskID, int shift)
+        {
+            return ((uint32_t)taskID * 2654435761u) >> shift;
+        }
+        static int findIn(const Table& table, int taskID)
+        {
+            if (table.count == 0) return -1;
+            uint32_t mask = table.capacity - 1;
+            uint32_t index = hashFunction(taskID, table.shift);
+            for (int distance = 1; ; distance++)
+            {
+                const Slot& slot = table.slots[index];
+                if (slot.distance < distance)
+                    return -1;
+                if (slot.taskId == taskID && slot.task)
+                    return index;
+                index = (index + 1) & mask;
+            }
+        }
+        static void placeIn(Table& table, int taskID, Task* task)
+        {
+            uint32_t mask = table.capacity - 1;
+            uint32_t index = hashFunction(taskID, table.shift);
+            Slot entry = { taskID, 1, task };
+            while (true)
+            {
+                Slot& slot = table.slots[index];
+                if (slot.distance == 0)
+                {
+                    slot = entry;
+                    table.count++;
+                    return;
+                }
+                if (slot.distance < entry.distance)
+                    std::swap(slot, entry);
+                index = (index + 1) & mask;
+                entry.distance++;
+            }
+        }
+        // Backward-shift deletion keeps probe sequences tombstone-free.
+        static void eraseAt(Table& table, uint32_t index)
+        {
+            uint32_t mask = table.capacity - 1;
+            uint32_t next = (index + 1) & mask;
+            while (table.slots[next].distance > 1)
+            {
+                table.slots[index] = table.slots[next];
+                table.slots[index].distance--;
+                index = next;
+                next = (next + 1) & mask;
+            }
+            table.slots[index] = Slot{ -1, 0, nullptr };
+            table.count--;
+        }
+        // Entries leaving the draining table become tombstones rather than being
+        // shifted, so the migration cursor never has to revisit a slot.
+        void migrate(int slots)
+        {
+            while (draining.slots && slots-- > 0)
+            {
+                Slot& slot = draining.slots[drainCursor++];
+                if (slot.task)
+                {
+                    placeIn(current, slot.taskId, slot.task);
+                    slot.task = nullptr;
+                    slot.taskId = -1;
+                    draining.count--;
+                }
+                if (drainCursor == draining.capacity)
+                {
+                    delete[] draining.slots;
+                    draining = emptyTable();
+                }
+            }
+        }
+        void grow()
+        {
+            if (draining.slots)
+                migrate(draining.capacity - drainCursor);
+            draining = current;
+            drainCursor = 0;
+            current = makeTable(draining.capacity * 2);
+        }
+    public:
+        TaskHashMap() : current(makeTable(INITIAL_CAPACITY)), draining(emptyTable()), drainCursor(0) {}
+        ~TaskHashMap()
+        {
+            delete[] current.slots;
+            delete[] draining.slots;
+        }
+        TaskHashMap(const TaskHashMap&) = delete;
+        TaskHashMap& operator=(const TaskHashMap&) = delete;
+        void insertTask(Task* task)
+        {
+            int index = findIn(current, task->taskId);
+            if (index != -1)
+            {
+                current.slots[index].task = task;
+                return;
+            }
+            index = findIn(draining, task->taskId);
+            if (index != -1)
+            {
+                draining.slots[index].task = task;
+                return;
+            }
+            migrate(MIGRATE_STEP);
+            if ((long long)(current.count + draining.count + 1) * 8 > (long long)current.capacity * 7)
+                grow();
+            placeIn(current, task->taskId, task);
+        }
+        // Sizes the table for taskCount entries so a bulk load never grows it
+        // incrementally. Existing entries are rehashed right away.
+        void reserve(int taskCount)
+        {
+            long long needed = (long long)taskCount * 8 / 7 + 1;
+            if (needed <= current.capacity) return;
+            int capacity = current.capacity;
+            while (capacity < needed)
+                capacity *= 2;
+            Table table = makeTable(capacity);
+            const Table* tables[] = { &draining, &current };
+            for (const Table* old : tables)
+            {
+                for (int i = 0; i < old->capacity; i++)
+                {
+                    if (old->slots[i].task)
+                        placeIn(table, old->slots[i].taskId, old->slots[i].task);
+                }
+            }
+            delete[] current.slots;
+            delete[] draining.slots;
+            current = table;
+            draining = emptyTable();
+            drainCursor = 0;
+        }
+        Task* getTaskByID(int taskID) const
+        {
+            int index = findIn(current, taskID);
+            if (index != -1)
+                return current.slots[index].task;
+            index = findIn(draining, taskID);
+            if (index != -1)
+                return draining.slots[index].task;
+            return nullptr;
+        }
+        bool deleteTask(int taskID)
+        {
+            bool found = false;
+            int index = findIn(current, taskID);
+            if (index != -1)
+            {
+                eraseAt(current, index);
+                found = true;
+            }
+            else
+            {
+                index = findIn(draining, taskID);
+                if (index != -1)
+                {
+                    draining.slots[index].task = nullptr;
+                    draining.slots[index].taskId = -1;
+                    draining.count--;
+                    found = true;
+                }
+            }
+            migrate(MIGRATE_STEP);
+            return found;
+        }
+        int getSize() const
+        {
+            return current.count + draining.count;
+        }
+        void displayTasks() const
+        {
+            cout << "\n--- Task HashMap ---\n";
+            if (getSize() == 0)
+            {
+                cout << "No tasks in the hash map.\n";
+                return;
+            }
+            cout << "Slots: " << current.capacity << ", Tasks: " << getSize();
+            if (draining.slots)
+                cout << " (resizing from " << draining.capacity << " slots)";
+            cout << "\n";
+            const Table* tables[] = { &draining, &current };
+            for (const Table* table : tables)
+            {
+                for (int i = 0; i < table->capacity; i++)
+                {
+                    const Slot& slot = table->slots[i];
+                    if (!slot.task) continue;
+                    cout << "Slot " << i << ": [ID: " << slot.taskId << ", Name: " << slot.task->taskName
+                        << ", Priority: " << slot.task->taskPriority << "] probe " << slot.distance - 1 << "\n";
+                }
+            }
+        }
+
+        // Added for file handling - clear all entries
+        void clear()
+        {
+            delete[] draining.slots;
+            draining = emptyTable();
+            drainCursor = 0;
+            for (int i = 0; i < current.capacity; i++)
+                current.slots[i] = Slot{ -1, 0, nullptr };
+            current.count = 0;
+        }
+};
+
+#endif
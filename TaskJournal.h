@@ -0,0 +1,353 @@
+#ifndef TASKJOURNAL_H
+#define TASKJOURNAL_H
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Checksum.h"
+#include "Metrics.h"
+#include "Task.h"
+
+// Append-only write-ahead log of task mutations. Every record carries the full
+// state of one task (or its removal), so replaying a record twice is harmless
+// and recovery is "load the snapshot, then replay the journal".
+//
+// On disk each record is [u32 length][u32 crc32][payload]. Records are buffered
+// and written with a single write()+fsync() once groupCommitRecords have queued
+// up or the oldest has waited groupCommitMillis; commit() forces the batch out.
+// A torn record at the tail (crash mid-append) is dropped during replay.
+class TaskJournal
+{
+    public:
+        enum RecordType
+        {
+            RECORD_UPSERT = 1,
+            RECORD_REMOVE = 2,
+            RECORD_BATCH = 3    // many upserts and removals applied as one record
+        };
+    private:
+        string path;
+        int fd;
+        string pending;
+        int pendingRecords;
+        long long committedBytes;
+        int groupCommitRecords;
+        int groupCommitMillis;
+        chrono::steady_clock::time_point firstPending;
+        template <typename T>
+        static void put(string& out, T value)
+        {
+            out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+        static void putString(string& out, string_view value)
+        {
+            put<uint32_t>(out, value.size());
+            out.append(value);
+        }
+        template <typename T>
+        static bool get(const char*& cursor, const char* end, T& value)
+        {
+            if (end - cursor < (long)sizeof(value)) return false;
+            memcpy(&value, cursor, sizeof(value));
+            cursor += sizeof(value);
+            return true;
+        }
+        static bool getString(const char*& cursor, const char* end, SharedString& value)
+        {
+            uint32_t length;
+            if (!get(cursor, end, length) || end - cursor < (long)length) return false;
+            value.assign(string_view(cursor, length));
+            cursor += length;
+            return true;
+        }
+        bool openForAppend()
+        {
+            if (fd != -1) return true;
+            fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+            if (fd == -1)
+            {
+                cerr << "Error: Could not open journal " << path << ": " << strerror(errno) << endl;
+                return false;
+            }
+            return true;
+        }
+        void append(const string& payload)
+        {
+            put<uint32_t>(pending, payload.size());
+            put<uint32_t>(pending, crc32(payload.data(), payload.size()));
+            pending += payload;
+            chrono::steady_clock::time_point now = chrono::steady_clock::now();
+            if (pendingRecords++ == 0)
+                firstPending = now;
+            if (pendingRecords >= groupCommitRecords ||
+                now - firstPending >= chrono::milliseconds(groupCommitMillis))
+                commit();
+        }
+        static void putTask(string& out, const Task& task)
+        {
+            put<uint8_t>(out, task.taskStatus);
+            put<int32_t>(out, task.taskPriority);
+            put<int64_t>(out, task.taskDueDate);
+            put<int64_t>(out, task.taskCreationDate);
+            put<int64_t>(out, task.taskCompletionDate);
+            putString(out, task.taskName);
+            putString(out, task.taskDescription);
+        }
+        // Reads the fields putTask wrote; the ID is stored separately.
+        static bool getTask(const char*& cursor, const char* end, int taskId, Task& task)
+        {
+            uint8_t status = 0;
+            int32_t priority = 0;
+            int64_t dueDate = 0, creationDate = 0, completionDate = 0;
+            if (!(get(cursor, end, status) && get(cursor, end, priority) &&
+                get(cursor, end, dueDate) && get(cursor, end, creationDate) &&
+                get(cursor, end, completionDate) && getString(cursor, end, task.taskName) &&
+                getString(cursor, end, task.taskDescription)))
+                return false;
+            task.taskId = taskId;
+            task.taskStatus = static_cast<TaskStatus>(status);
+            task.taskPriority = priority;
+            task.taskDueDate = dueDate;
+            task.taskCreationDate = creationDate;
+            task.taskCompletionDate = completionDate;
+            return true;
+        }
+        static string header(RecordType type, int taskId, int nextTaskId)
+        {
+            string payload;
+            put<uint8_t>(payload, type);
+            put<int32_t>(payload, nextTaskId);
+            put<int32_t>(payload, taskId);
+            return payload;
+        }
+    public:
+        TaskJournal(const string& journalPath, int groupRecords = 64, int groupMillis = 20)
+            : path(journalPath), fd(-1), pendingRecords(0), committedBytes(0),
+            groupCommitRecords(groupRecords), groupCommitMillis(groupMillis) {}
+        ~TaskJournal()
+        {
+            commit();
+            if (fd != -1)
+                ::close(fd);
+        }
+        TaskJournal(const TaskJournal&) = delete;
+        TaskJournal& operator=(const TaskJournal&) = delete;
+
+        void logUpsert(const Task& task, int nextTaskId)
+        {
+            string payload = header(RECORD_UPSERT, task.taskId, nextTaskId);
+            putTask(payload, task);
+            append(payload);
+        }
+        void logRemove(int taskId, int nextTaskId)
+        {
+            append(header(RECORD_REMOVE, taskId, nextTaskId));
+        }
+        // One record for a whole batch, so a crash replays all of it or none.
+        // Layout after the header: [u32 upserts]([i32 id][task])* [u32 removals][i32 id]*
+        void logBatch(const vector<const Task*>& upserts, const vector<int>& removals, int nextTaskId)
+        {
+            string payload = header(RECORD_BATCH, -1, nextTaskId);
+            put<uint32_t>(payload, upserts.size());
+            for (const Task* task : upserts)
+            {
+                put<int32_t>(payload, task->taskId);
+                putTask(payload, *task);
+            }
+            put<uint32_t>(payload, removals.size());
+            for (int taskId : removals)
+                put<int32_t>(payload, taskId);
+            append(payload);
+        }
+        // Writes every queued record and fsyncs once for the whole group.
+        bool commit()
+        {
+            if (pending.empty()) return true;
+            OperationTimer timer(OP_JOURNAL_COMMIT);
+            if (!openForAppend())
+            {
+                timer.fail();
+                return false;
+            }
+            const char* data = pending.data();
+            size_t remaining = pending.size();
+            while (remaining > 0)
+            {
+                ssize_t written = ::write(fd, data, remaining);
+                if (written < 0)
+                {
+                    if (errno == EINTR) continue;
+                    cerr << "Error: Journal write failed: " << strerror(errno) << endl;
+                    timer.fail();
+                    return false;
+                }
+                data += written;
+                remaining -= written;
+            }
+            if (::fsync(fd) != 0)
+            {
+                cerr << "Error: Journal fsync failed: " << strerror(errno) << endl;
+                timer.fail();
+                return false;
+            }
+            committedBytes += pending.size();
+            pending.clear();
+            pendingRecords = 0;
+            return true;
+        }
+        // Called after a checkpoint has made every journaled change durable in the snapshot.
+        bool truncate()
+        {
+            pending.clear();
+            pendingRecords = 0;
+            if (!openForAppend()) return false;
+            if (::ftruncate(fd, 0) != 0 || ::fsync(fd) != 0)
+            {
+                cerr << "Error: Could not truncate journal: " << strerror(errno) << endl;
+                return false;
+            }
+            committedBytes = 0;
+            return true;
+        }
+        // Moves every record to segmentPath, appending if an earlier segment is
+        // still there, and starts an empty journal. Recovery replays the segment
+        // before this journal; whoever rotated deletes it once a snapshot covers it.
+        bool rotate(const string& segmentPath)
+        {
+            if (!commit()) return false;
+            if (fd != -1)
+                ::close(fd);
+            fd = -1;
+            committedBytes = 0;
+            if (::access(segmentPath.c_str(), F_OK) != 0)
+            {
+                if (::rename(path.c_str(), segmentPath.c_str()) == 0 || errno == ENOENT) return true;
+                cerr << "Error: Could not rotate journal: " << strerror(errno) << endl;
+                return false;
+            }
+            int input = ::open(path.c_str(), O_RDONLY);
+            if (input == -1) return errno == ENOENT;
+            int output = ::open(segmentPath.c_str(), O_WRONLY | O_APPEND);
+            bool ok = output != -1;
+            char chunk[1 << 16];
+            ssize_t got = 0;
+            while (ok && (got = ::read(input, chunk, sizeof(chunk))) > 0)
+                ok = ::write(output, chunk, got) == got;
+            ok = ok && got == 0 && ::fsync(output) == 0;
+            if (!ok)
+                cerr << "Error: Could not rotate journal: " << strerror(errno) << endl;
+            ::close(input);
+            if (output != -1)
+                ::close(output);
+            return ok && ::truncate(path.c_str(), 0) == 0;
+        }
+        long long size() const
+        {
+            return committedBytes + pending.size();
+        }
+        // Replays every intact record in order. nextTaskId is raised to the largest
+        // value seen. Returns the number of records applied.
+        int replay(const function<void(const Task&)>& onUpsert, const function<void(int)>& onRemove, int& nextTaskId)
+        {
+            int input = ::open(path.c_str(), O_RDONLY);
+            if (input == -1) return 0;
+            vector<char> data;
+            char chunk[1 << 16];
+            ssize_t got;
+            while ((got = ::read(input, chunk, sizeof(chunk))) > 0)
+                data.insert(data.end(), chunk, chunk + got);
+            ::close(input);
+
+            const char* cursor = data.data();
+            const char* end = cursor + data.size();
+            int applied = 0;
+            while (cursor < end)
+            {
+                const char* recordStart = cursor;
+                uint32_t length, checksum;
+                if (!get(cursor, end, length) || !get(cursor, end, checksum) ||
+                    end - cursor < (long)length || crc32(cursor, length) != checksum)
+                {
+                    cursor = recordStart;
+                    break;
+                }
+                const char* payloadEnd = cursor + length;
+                uint8_t type = 0;
+                int32_t recordNextId = 0, taskId = 0;
+                bool valid = get(cursor, payloadEnd, type) && get(cursor, payloadEnd, recordNextId) &&
+                    get(cursor, payloadEnd, taskId);
+                if (valid && type == RECORD_UPSERT)
+                {
+                    Task task;
+                    valid = getTask(cursor, payloadEnd, taskId, task);
+                    if (valid)
+                        onUpsert(task);
+                }
+                else if (valid && type == RECORD_REMOVE)
+                {
+                    onRemove(taskId);
+                }
+                else if (valid && type == RECORD_BATCH)
+                {
+                    // Decoded in full before anything is applied, so a malformed
+                    // batch is dropped whole rather than half-applied.
+                    vector<Task> upserts;
+                    vector<int> removals;
+                    uint32_t count = 0;
+                    valid = get(cursor, payloadEnd, count);
+                    for (uint32_t i = 0; valid && i < count; i++)
+                    {
+                        int32_t id = 0;
+                        upserts.emplace_back();
+                        valid = get(cursor, payloadEnd, id) && getTask(cursor, payloadEnd, id, upserts.back());
+                    }
+                    valid = valid && get(cursor, payloadEnd, count);
+                    for (uint32_t i = 0; valid && i < count; i++)
+                    {
+                        int32_t id = 0;
+                        valid = get(cursor, payloadEnd, id);
+                        removals.push_back(id);
+                    }
+                    valid = valid && cursor == payloadEnd;
+                    if (valid)
+                    {
+                        for (const Task& task : upserts)
+                            onUpsert(task);
+                        for (int id : removals)
+                            onRemove(id);
+                    }
+                }
+                else
+                {
+                    valid = false;
+                }
+                if (!valid)
+                {
+                    cursor = recordStart;
+                    break;
+                }
+                if (recordNextId > nextTaskId)
+                    nextTaskId = recordNextId;
+                cursor = payloadEnd;
+                applied++;
+            }
+
+            committedBytes = cursor - data.data();
+            if (cursor < end)
+            {
+                cerr << "Warning: Dropped " << (end - cursor) << " bytes of incomplete journal data." << endl;
+                if (::truncate(path.c_str(), committedBytes) != 0)
+                    cerr << "Error: Could not trim journal: " << strerror(errno) << endl;
+            }
+            return applied;
+        }
+};
+
+#endif
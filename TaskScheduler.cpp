@@ -1,15 +1,116 @@
 #include "TaskScheduler.h"
+#include "WorkStealingPool.h"
+#include <atomic>
+#include <exception>
+#include <mutex>
 
-void TaskScheduler::addTask(string task, int priority) {
-    taskQueue.insert(task, priority);
-    taskSearch.insert(task);
+int TaskScheduler::addTask(const string& task, int priority) {
+    return addTask(task, priority, function<void()>());
+}
+
+int TaskScheduler::addTask(const string& task, int priority, function<void()> work) {
+    int id = taskNames.size();
+    taskNames.push_back(SharedString(task));
+    taskPriorities.push_back(priority);
+    taskWork.push_back(std::move(work));
+    queued.push_back(0);
+    taskDependencies.addTask(id);
+    enqueue(id);
+    taskSearch.insert(task, id);
+    return id;
+}
+
+bool TaskScheduler::addDependency(int taskId, int prerequisiteId) {
+    if (taskId >= (int)taskNames.size() || prerequisiteId >= (int)taskNames.size())
+        return false;
+    // A queued task that becomes blocked is dropped lazily by skipBlocked().
+    return taskDependencies.addDependency(prerequisiteId, taskId);
+}
+
+void TaskScheduler::enqueue(int id) {
+    if (queued[id])
+        return;
+    queued[id] = 1;
+    taskQueue.insert(taskNames[id], taskPriorities[id], id);
+}
+
+void TaskScheduler::skipBlocked() {
+    while (!taskQueue.isEmpty() && !taskDependencies.isReady(taskQueue.getTopId())) {
+        queued[taskQueue.getTopId()] = 0;
+        taskQueue.extractTop();
+    }
+}
+
+vector<int> TaskScheduler::findTasks(const string& prefix, size_t limit) const {
+    return taskSearch.startsWith(prefix, limit);
 }
 
 string TaskScheduler::getNextTask() {
-    return taskQueue.getTop();
+    skipBlocked();
+    return taskQueue.getTop().str();
 }
 
 void TaskScheduler::completeTask() {
-    string task = taskQueue.extractTop();
-    taskHistory.insert(task);
+    skipBlocked();
+    if (taskQueue.isEmpty())
+        return;
+    int id = taskQueue.getTopId();
+    queued[id] = 0;
+    taskHistory.insert(taskQueue.extractTop());
+    vector<int> newlyReady;
+    taskDependencies.complete(id, newlyReady);
+    for (int dependent : newlyReady)
+        enqueue(dependent);
+}
+
+void TaskScheduler::runAll(int threads) {
+    int taskCount = taskNames.size();
+    vector<atomic<int>> remaining(taskCount);
+    vector<pair<int, int>> initial;
+    for (int id = 0; id < taskCount; id++) {
+        if (taskDependencies.isCompleted(id))
+            continue;
+        remaining[id] = taskDependencies.pendingDependencies(id);
+        if (remaining[id] == 0)
+            initial.push_back(make_pair(id, taskPriorities[id]));
+    }
+
+    mutex resultLock;
+    vector<int> finished;
+    exception_ptr failure;
+    WorkStealingPool pool(threads);
+    pool.run(initial, [&](int id, int worker) {
+        try {
+            if (taskWork[id])
+                taskWork[id]();
+        } catch (...) {
+            lock_guard<mutex> guard(resultLock);
+            if (!failure)
+                failure = current_exception();
+            return;
+        }
+        {
+            lock_guard<mutex> guard(resultLock);
+            finished.push_back(id);
+        }
+        taskDependencies.forEachDependent(id, [&](int dependent) {
+            if (remaining[dependent].fetch_sub(1) == 1 && !taskDependencies.isCompleted(dependent))
+                pool.spawn(worker, dependent, taskPriorities[dependent]);
+        });
+    });
+
+    // finished is in a valid topological order, so replaying it keeps the
+    // graph's counters exact. Anything left ready (dependents of a failed
+    // task's siblings, or the failed task itself) goes back on the queue.
+    vector<int> newlyReady;
+    for (int id : finished) {
+        taskHistory.insert(taskNames[id]);
+        taskDependencies.complete(id, newlyReady);
+    }
+    for (int id : newlyReady) {
+        if (!taskDependencies.isCompleted(id))
+            enqueue(id);
+    }
+    if (failure)
+        rethrow_exception(failure);
 }
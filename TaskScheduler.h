@@ -5,18 +5,40 @@
 #include "LinkedList.h"
 #include "Trie.h"
 #include "Graph.h"
+#include <functional>
 
+// Tasks are identified by the ID addTask returns. Only tasks whose
+// prerequisites are all complete are handed out by getNextTask.
+//
+// Tasks may also carry a callable; runAll() then executes every incomplete
+// task on a WorkStealingPool, starting dependents as soon as their last
+// prerequisite finishes.
 class TaskScheduler {
 private:
     Heap taskQueue;
     LinkedList taskHistory;
     Trie taskSearch;
     Graph taskDependencies;
+    vector<SharedString> taskNames;
+    vector<int> taskPriorities;
+    vector<char> queued;
+    vector<function<void()>> taskWork;
+
+    void enqueue(int id);
+    void skipBlocked();
 
 public:
-    void addTask(string task, int priority);
+    int addTask(const string& task, int priority);
+    int addTask(const string& task, int priority, function<void()> work);
+    // taskId will not be handed out until prerequisiteId has been completed.
+    bool addDependency(int taskId, int prerequisiteId);
+    // IDs of tasks whose name starts with prefix, in name order.
+    vector<int> findTasks(const string& prefix, size_t limit = 0) const;
     string getNextTask();
     void completeTask();
+    // Tasks without a callable complete as no-ops. If a callable throws, its
+    // dependents stay blocked and the first exception is rethrown after the run.
+    void runAll(int threads = 0);
 };
 
 #endif
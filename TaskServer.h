@@ -0,0 +1,850 @@
+#ifndef TASKSERVER_H
+#define TASKSERVER_H
+
+#include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "BatchMode.h"
+
+struct HttpRequest
+{
+    string method;
+    string path;                    // without the query string
+    map<string, string> query;      // decoded
+    map<string, string> headers;    // names in lower case
+    string body;
+};
+
+struct HttpResponse
+{
+    int status = 200;
+    string contentType = "application/json";
+    string body;
+};
+
+// Single-threaded HTTP/1.1 server on 127.0.0.1, driven by epoll. Connections
+// are kept alive and requests on one connection may be pipelined. Nothing
+// blocks: sockets are non-blocking, and output that does not fit in the
+// socket buffer waits for EPOLLOUT.
+//
+// Each wakeup handles every ready request first, then calls commit() once,
+// then sends the responses. A handler's changes are therefore durable before
+// any client hears about them, and a burst of requests shares one commit.
+class HttpServer
+{
+    private:
+        static const size_t MAX_HEADER_BYTES = 64 << 10;
+        static const size_t MAX_BODY_BYTES = 1 << 20;
+        static const int IDLE_SECONDS = 60;
+        static const int MAX_EVENTS = 64;
+        struct Connection
+        {
+            string input;
+            string output;
+            size_t sent = 0;
+            bool closing = false;       // close once output is sent
+            bool waitingToWrite = false;
+            time_t lastActive = 0;
+        };
+        int listenFd;
+        int epollFd;
+        unordered_map<int, Connection> connections;
+        vector<int> unsent;             // connections with responses queued this wakeup
+
+        static const char* reason(int status)
+        {
+            switch (status)
+            {
+                case 200: return "OK";
+                case 201: return "Created";
+                case 400: return "Bad Request";
+                case 403: return "Forbidden";
+                case 404: return "Not Found";
+                case 405: return "Method Not Allowed";
+                case 409: return "Conflict";
+                case 413: return "Payload Too Large";
+                case 431: return "Request Header Fields Too Large";
+                case 501: return "Not Implemented";
+                default: return "Internal Server Error";
+            }
+        }
+        static void appendResponse(Connection& connection, const HttpResponse& response, bool keepAlive)
+        {
+            string& out = connection.output;
+            out += "HTTP/1.1 " + to_string(response.status) + " " + reason(response.status) + "\r\n";
+            out += "Content-Type: " + response.contentType + "\r\n";
+            out += "Content-Length: " + to_string(response.body.size()) + "\r\n";
+            out += "Cache-Control: no-store\r\n";
+            out += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+            out += response.body;
+            if (!keepAlive)
+                connection.closing = true;
+        }
+        static string decode(const string& text)
+        {
+            string decoded;
+            for (size_t i = 0; i < text.size(); i++)
+            {
+                if (text[i] == '+')
+                    decoded += ' ';
+                else if (text[i] == '%' && i + 2 < text.size() && isxdigit((unsigned char)text[i + 1]) && isxdigit((unsigned char)text[i + 2]))
+                {
+                    decoded += (char)stoi(text.substr(i + 1, 2), nullptr, 16);
+                    i += 2;
+                }
+                else
+                    decoded += text[i];
+            }
+            return decoded;
+        }
+        // 1: a request was taken off the front of input; 0: more input is
+        // needed; -1: the request is malformed and errorStatus says why.
+        static int parseRequest(string& input, HttpRequest& request, bool& keepAlive, int& errorStatus)
+        {
+            size_t headerEnd = input.find("\r\n\r\n");
+            if (headerEnd == string::npos)
+            {
+                errorStatus = 431;
+                return input.size() > MAX_HEADER_BYTES ? -1 : 0;
+            }
+            errorStatus = 400;
+            istringstream head(input.substr(0, headerEnd));
+            string line, target, version;
+            getline(head, line);
+            istringstream requestLine(line);
+            if (!(requestLine >> request.method >> target >> version) || version.compare(0, 7, "HTTP/1.") != 0 || target[0] != '/')
+                return -1;
+            request.headers.clear();
+            while (getline(head, line))
+            {
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+                size_t colon = line.find(':');
+                if (colon == string::npos)
+                    return -1;
+                string name = line.substr(0, colon);
+                for (char& c : name)
+                    c = tolower((unsigned char)c);
+                size_t valueStart = line.find_first_not_of(" \t", colon + 1);
+                request.headers[name] = valueStart == string::npos ? "" : line.substr(valueStart);
+            }
+            if (request.headers.count("transfer-encoding"))
+            {
+                errorStatus = 501;
+                return -1;
+            }
+            size_t bodyLength = 0;
+            auto length = request.headers.find("content-length");
+            if (length != request.headers.end())
+            {
+                int parsed;
+                if (!parseNumber(length->second, parsed) || parsed < 0)
+                    return -1;
+                bodyLength = parsed;
+                if (bodyLength > MAX_BODY_BYTES)
+                {
+                    errorStatus = 413;
+                    return -1;
+                }
+            }
+            size_t bodyStart = headerEnd + 4;
+            if (input.size() < bodyStart + bodyLength)
+                return 0;
+            request.body.assign(input, bodyStart, bodyLength);
+            input.erase(0, bodyStart + bodyLength);
+
+            size_t question = target.find('?');
+            request.path = decode(target.substr(0, question));
+            request.query.clear();
+            if (question != string::npos)
+            {
+                istringstream query(target.substr(question + 1));
+                string pair;
+                while (getline(query, pair, '&'))
+                {
+                    size_t equals = pair.find('=');
+                    request.query[decode(pair.substr(0, equals))] = equals == string::npos ? "" : decode(pair.substr(equals + 1));
+                }
+            }
+            auto connection = request.headers.find("connection");
+            string connectionValue = connection == request.headers.end() ? "" : connection->second;
+            for (char& c : connectionValue)
+                c = tolower((unsigned char)c);
+            keepAlive = version == "HTTP/1.1" ? connectionValue != "close" : connectionValue == "keep-alive";
+            return 1;
+        }
+        // Only the loopback names are accepted, so a page on another origin cannot
+        // reach the server through a DNS name that resolves to 127.0.0.1.
+        static bool localHost(const HttpRequest& request)
+        {
+            auto host = request.headers.find("host");
+            if (host == request.headers.end())
+                return true;
+            string name = host->second.substr(0, host->second.rfind(':'));
+            return name == "localhost" || name == "127.0.0.1";
+        }
+        // Browsers send Origin with cross-site requests, including the "simple"
+        // POSTs they make without a preflight; anything but the page this
+        // server served is refused.
+        static bool sameOrigin(const HttpRequest& request)
+        {
+            auto origin = request.headers.find("origin");
+            if (origin == request.headers.end())
+                return true;
+            auto host = request.headers.find("host");
+            return host != request.headers.end() && origin->second == "http://" + host->second;
+        }
+        void closeConnection(int fd)
+        {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+            ::close(fd);
+            connections.erase(fd);
+        }
+        void acceptConnections()
+        {
+            while (true)
+            {
+                int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd == -1)
+                    return;
+                int on = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                epoll_event event = {};
+                event.events = EPOLLIN | EPOLLRDHUP;
+                event.data.fd = fd;
+                epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+                connections[fd].lastActive = time(0);
+            }
+        }
+        template <typename Handler>
+        void readRequests(int fd, Handler& handle)
+        {
+            auto found = connections.find(fd);
+            if (found == connections.end())
+                return;
+            Connection& connection = found->second;
+            char buffer[16 << 10];
+            bool peerClosed = false;
+            while (true)
+            {
+                ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+                if (received > 0)
+                    connection.input.append(buffer, received);
+                else if (received == 0)
+                {
+                    peerClosed = true;
+                    break;
+                }
+                else if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    break;
+                else if (errno != EINTR)
+                {
+                    closeConnection(fd);
+                    return;
+                }
+            }
+            connection.lastActive = time(0);
+            bool answered = false;
+            while (!connection.closing)
+            {
+                HttpRequest request;
+                HttpResponse response;
+                bool keepAlive = false;
+                int errorStatus;
+                int parsed = parseRequest(connection.input, request, keepAlive, errorStatus);
+                if (parsed == 0)
+                    break;
+                if (parsed < 0)
+                {
+                    response.status = errorStatus;
+                    response.body = "{\"ok\":false,\"error\":\"malformed request\"}";
+                    connection.input.clear();
+                }
+                else if (!localHost(request))
+                {
+                    response.status = 403;
+                    response.body = "{\"ok\":false,\"error\":\"only localhost may connect\"}";
+                }
+                else if (!sameOrigin(request))
+                {
+                    response.status = 403;
+                    response.body = "{\"ok\":false,\"error\":\"cross-origin requests are not allowed\"}";
+                }
+                else
+                {
+                    handle(request, response);
+                }
+                appendResponse(connection, response, parsed > 0 && keepAlive);
+                answered = true;
+            }
+            if (peerClosed)
+            {
+                // Answer what was sent before the half-close, then close.
+                if (connection.output.empty())
+                {
+                    closeConnection(fd);
+                    return;
+                }
+                connection.closing = true;
+                epoll_event event = {};
+                event.events = EPOLLOUT;
+                event.data.fd = fd;
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+                connection.waitingToWrite = true;
+            }
+            if (answered)
+                unsent.push_back(fd);
+        }
+        void sendResponses(int fd)
+        {
+            auto found = connections.find(fd);
+            if (found == connections.end())
+                return;
+            Connection& connection = found->second;
+            while (connection.sent < connection.output.size())
+            {
+                ssize_t written = send(fd, connection.output.data() + connection.sent, connection.output.size() - connection.sent, MSG_NOSIGNAL);
+                if (written > 0)
+                {
+                    connection.sent += written;
+                    continue;
+                }
+                if (written < 0 && errno == EINTR)
+                    continue;
+                if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                {
+                    if (!connection.waitingToWrite)
+                    {
+                        epoll_event event = {};
+                        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP;
+                        event.data.fd = fd;
+                        epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+                        connection.waitingToWrite = true;
+                    }
+                    return;
+                }
+                closeConnection(fd);
+                return;
+            }
+            connection.output.clear();
+            connection.sent = 0;
+            if (connection.closing)
+            {
+                closeConnection(fd);
+                return;
+            }
+            if (connection.waitingToWrite)
+            {
+                epoll_event event = {};
+                event.events = EPOLLIN | EPOLLRDHUP;
+                event.data.fd = fd;
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+                connection.waitingToWrite = false;
+            }
+        }
+        void closeIdleConnections(time_t now)
+        {
+            vector<int> idle;
+            for (const auto& entry : connections)
+            {
+                if (entry.second.output.empty() && now - entry.second.lastActive > IDLE_SECONDS)
+                    idle.push_back(entry.first);
+            }
+            for (int fd : idle)
+                closeConnection(fd);
+        }
+    public:
+        HttpServer() : listenFd(-1), epollFd(-1) {}
+        ~HttpServer()
+        {
+            for (const auto& entry : connections)
+                ::close(entry.first);
+            if (listenFd != -1)
+                ::close(listenFd);
+            if (epollFd != -1)
+                ::close(epollFd);
+        }
+        HttpServer(const HttpServer&) = delete;
+        HttpServer& operator=(const HttpServer&) = delete;
+
+        // Binds 127.0.0.1:port (0 picks a free port).
+        bool listen(int port, string& error)
+        {
+            listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            epollFd = epoll_create1(EPOLL_CLOEXEC);
+            if (listenFd == -1 || epollFd == -1)
+            {
+                error = strerror(errno);
+                return false;
+            }
+            int on = 1;
+            setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            sockaddr_in address = {};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(port);
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (bind(listenFd, (sockaddr*)&address, sizeof(address)) != 0 || ::listen(listenFd, SOMAXCONN) != 0)
+            {
+                error = "127.0.0.1:" + to_string(port) + ": " + strerror(errno);
+                return false;
+            }
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.fd = listenFd;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+            return true;
+        }
+        int port() const
+        {
+            sockaddr_in address = {};
+            socklen_t length = sizeof(address);
+            getsockname(listenFd, (sockaddr*)&address, &length);
+            return ntohs(address.sin_port);
+        }
+        // Serves until stop becomes nonzero. handle(request, response) answers
+        // one request; commit() runs before the responses of a wakeup are sent;
+        // tick() runs about once a second.
+        template <typename Handler, typename Commit, typename Tick>
+        void run(Handler handle, Commit commit, Tick tick, const volatile sig_atomic_t& stop)
+        {
+            epoll_event events[MAX_EVENTS];
+            time_t lastTick = 0;
+            while (!stop)
+            {
+                int ready = epoll_wait(epollFd, events, MAX_EVENTS, 1000);
+                if (ready < 0 && errno != EINTR)
+                    return;
+                for (int i = 0; i < ready; i++)
+                {
+                    int fd = events[i].data.fd;
+                    if (fd == listenFd)
+                        acceptConnections();
+                    else if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+                        readRequests(fd, handle);
+                    if (fd != listenFd && (events[i].events & EPOLLOUT))
+                        sendResponses(fd);
+                }
+                if (!unsent.empty())
+                {
+                    commit();
+                    for (int fd : unsent)
+                        sendResponses(fd);
+                    unsent.clear();
+                }
+                time_t now = time(0);
+                if (now != lastTick)
+                {
+                    lastTick = now;
+                    tick();
+                    closeIdleConnections(now);
+                }
+            }
+        }
+};
+
+// Reads a flat JSON object of string, number, boolean and null members into
+// fields. Strings are unescaped; other values are kept as their source text.
+inline bool parseJsonObject(const string& text, map<string, string>& fields)
+{
+    size_t i = 0;
+    auto skipSpace = [&]() {
+        while (i < text.size() && isspace((unsigned char)text[i]))
+            i++;
+    };
+    auto readString = [&](string& out) {
+        if (i >= text.size() || text[i] != '"')
+            return false;
+        for (i++; i < text.size() && text[i] != '"'; i++)
+        {
+            if (text[i] != '\\')
+            {
+                out += text[i];
+                continue;
+            }
+            if (++i >= text.size())
+                return false;
+            char c = text[i];
+            if (c == 'n') out += '\n';
+            else if (c == 't') out += '\t';
+            else if (c == 'r') out += '\r';
+            else if (c == 'b') out += '\b';
+            else if (c == 'f') out += '\f';
+            else if (c == 'u')
+            {
+                string hex = text.substr(i + 1, 4);
+                if (hex.size() != 4 || hex.find_first_not_of("0123456789abcdefABCDEF") != string::npos)
+                    return false;
+                unsigned code = stoul(hex, nullptr, 16);
+                i += 4;
+                if (code < 0x80)
+                    out += (char)code;
+                else if (code < 0x800)
+                {
+                    out += (char)(0xC0 | (code >> 6));
+                    out += (char)(0x80 | (code & 0x3F));
+                }
+                else
+                {
+                    out += (char)(0xE0 | (code >> 12));
+                    out += (char)(0x80 | ((code >> 6) & 0x3F));
+                    out += (char)(0x80 | (code & 0x3F));
+                }
+            }
+            else out += c;
+        }
+        if (i >= text.size())
+            return false;
+        i++;
+        return true;
+    };
+    fields.clear();
+    skipSpace();
+    if (i >= text.size() || text[i++] != '{')
+        return false;
+    skipSpace();
+    if (i < text.size() && text[i] == '}')
+        return true;
+    while (true)
+    {
+        string name, value;
+        skipSpace();
+        if (!readString(name))
+            return false;
+        skipSpace();
+        if (i >= text.size() || text[i++] != ':')
+            return false;
+        skipSpace();
+        if (i < text.size() && text[i] == '"')
+        {
+            if (!readString(value))
+                return false;
+        }
+        else
+        {
+            size_t start = i;
+            while (i < text.size() && (isalnum((unsigned char)text[i]) || text[i] == '-' || text[i] == '+' || text[i] == '.'))
+                i++;
+            if (i == start)
+                return false;
+            value = text.substr(start, i - start);
+        }
+        fields[name] = value;
+        skipSpace();
+        if (i < text.size() && text[i] == ',')
+        {
+            i++;
+            continue;
+        }
+        return i < text.size() && text[i] == '}';
+    }
+}
+
+// JSON API over a TaskScheduler, plus the web UI files:
+//
+//   GET    /, /index.html, /script.js
+//   GET    /api/changes?since=N    tasks changed and IDs removed after version N
+//   POST   /api/tasks              {name, description, priority, status, due}
+//   PUT    /api/tasks/ID           same fields
+//   PUT    /api/tasks/ID/status    {status}
+//   DELETE /api/tasks/ID
+//   POST   /api/undo, /api/redo
+//   POST   /api/claim              {lease}: lease the next queued task for lease seconds
+//   POST   /api/tasks/ID/heartbeat {lease, token}: extend the lease to lease seconds from now
+//   POST   /api/tasks/ID/complete, /api/tasks/ID/release    {token}
+//   GET    /metrics                operation latencies, Prometheus text format
+//
+// status is 0-2 and due is seconds since the epoch (0: none). Every reply
+// carries the scheduler's version. /api/changes answers with "reset": true
+// and every task when since is 0 or older than the change log covers.
+template <typename Scheduler>
+class TaskApi
+{
+    private:
+        Scheduler& scheduler;
+        string root;
+
+        static void reply(HttpResponse& response, int status, const string& body)
+        {
+            response.status = status;
+            response.body = body;
+        }
+        void fail(HttpResponse& response, int status, const string& error)
+        {
+            ostringstream out;
+            out << "{\"ok\":false,\"error\":";
+            writeJsonString(out, error);
+            out << ",\"version\":" << scheduler.getVersion() << '}';
+            reply(response, status, out.str());
+        }
+        void succeed(HttpResponse& response, int id = -1)
+        {
+            ostringstream out;
+            out << "{\"ok\":true";
+            if (id != -1)
+                out << ",\"id\":" << id;
+            out << ",\"version\":" << scheduler.getVersion() << '}';
+            reply(response, id != -1 ? 201 : 200, out.str());
+        }
+        void serveFile(const string& name, const char* contentType, HttpResponse& response)
+        {
+            ifstream file(root + "/" + name, ios::binary);
+            if (!file)
+            {
+                fail(response, 404, name + " not found in " + root);
+                return;
+            }
+            ostringstream contents;
+            contents << file.rdbuf();
+            response.contentType = contentType;
+            response.body = contents.str();
+        }
+        void changes(const HttpRequest& request, HttpResponse& response)
+        {
+            uint64_t since = 0;
+            auto param = request.query.find("since");
+            if (param != request.query.end())
+                since = strtoull(param->second.c_str(), nullptr, 10);
+            vector<int> changed;
+            bool reset = !scheduler.getChangesSince(since, changed);
+            ostringstream out;
+            out << "{\"ok\":true,\"version\":" << scheduler.getVersion() << ",\"reset\":" << (reset ? "true" : "false") << ",\"tasks\":[";
+            bool first = true;
+            vector<int> removed;
+            if (reset)
+            {
+                for (int i = 0; i < scheduler.getTaskCount(); i++)
+                {
+                    if (!first) out << ',';
+                    writeTaskJson(out, *scheduler.getTaskByIndex(i));
+                    first = false;
+                }
+            }
+            for (int taskId : changed)
+            {
+                const Task* task = scheduler.getTaskByID(taskId);
+                if (!task)
+                {
+                    removed.push_back(taskId);
+                    continue;
+                }
+                if (!first) out << ',';
+                writeTaskJson(out, *task);
+                first = false;
+            }
+            out << "],\"removed\":[";
+            for (size_t i = 0; i < removed.size(); i++)
+                out << (i ? "," : "") << removed[i];
+            out << "]}";
+            reply(response, 200, out.str());
+        }
+        static bool jsonRequest(const HttpRequest& request)
+        {
+            auto type = request.headers.find("content-type");
+            if (type == request.headers.end())
+                return false;
+            string media = type->second.substr(0, type->second.find(';'));
+            media.erase(media.find_last_not_of(" \t") + 1);
+            for (char& c : media)
+                c = tolower((unsigned char)c);
+            return media == "application/json";
+        }
+        // name, description, priority, status and due from a request body.
+        bool readTask(const HttpRequest& request, HttpResponse& response, string& name, string& description, int& priority, TaskStatus& status, time_t& due)
+        {
+            map<string, string> fields;
+            long long dueSeconds;
+            if (!parseJsonObject(request.body, fields) || !fields.count("name") || !fields.count("description")
+                || !parseNumber(fields["priority"], priority) || !parseStatus(fields["status"], status))
+            {
+                fail(response, 400, "expected {name, description, priority, status, due}");
+                return false;
+            }
+            const string& dueText = fields["due"];
+            char* end;
+            dueSeconds = strtoll(dueText.c_str(), &end, 10);
+            if (dueText.empty() || *end != '\0')
+            {
+                fail(response, 400, "due must be seconds since the epoch");
+                return false;
+            }
+            name = fields["name"];
+            description = fields["description"];
+            due = dueSeconds;
+            return true;
+        }
+        // POST /api/claim
+        void claim(const HttpRequest& request, HttpResponse& response)
+        {
+            map<string, string> fields;
+            int seconds;
+            if (!parseJsonObject(request.body, fields) || !parseNumber(fields["lease"], seconds) || seconds <= 0)
+            {
+                fail(response, 400, "expected {lease} in seconds");
+                return;
+            }
+            uint64_t token;
+            int id = scheduler.claimNextTask(seconds, token);
+            if (id == -1)
+            {
+                fail(response, 409, "no tasks to claim");
+                return;
+            }
+            ostringstream out;
+            out << "{\"ok\":true,\"id\":" << id << ",\"token\":" << token << ",\"version\":" << scheduler.getVersion() << '}';
+            reply(response, 200, out.str());
+        }
+        // POST /api/tasks/ID/{heartbeat,complete,release}. A token that no longer
+        // holds the lease gets 409.
+        void leaseRequest(const HttpRequest& request, HttpResponse& response, int id, const string& action)
+        {
+            map<string, string> fields;
+            uint64_t token;
+            int seconds = 0;
+            if (request.method != "POST")
+            {
+                fail(response, 405, "method not allowed");
+                return;
+            }
+            if (!parseJsonObject(request.body, fields) || !parseNumber(fields["token"], token) ||
+                (action == "/heartbeat" && (!parseNumber(fields["lease"], seconds) || seconds <= 0)))
+            {
+                fail(response, 400, action == "/heartbeat" ? "expected {token, lease}" : "expected {token}");
+                return;
+            }
+            bool held = action == "/heartbeat" ? scheduler.heartbeatTask(id, token, seconds)
+                : scheduler.finishLeasedTask(id, token, action == "/complete");
+            if (held)
+                succeed(response);
+            else
+                fail(response, 409, "lease not held");
+        }
+        void taskRequest(const HttpRequest& request, HttpResponse& response)
+        {
+            string rest = request.path.substr(strlen("/api/tasks/"));
+            size_t slash = rest.find('/');
+            string suffix = slash == string::npos ? "" : rest.substr(slash);
+            int id;
+            if (!parseNumber(rest.substr(0, slash), id) || (suffix != "" && suffix != "/status" &&
+                suffix != "/heartbeat" && suffix != "/complete" && suffix != "/release"))
+            {
+                fail(response, 404, "no such resource");
+                return;
+            }
+            if (suffix != "" && suffix != "/status")
+            {
+                leaseRequest(request, response, id, suffix);
+                return;
+            }
+            string name, description;
+            int priority;
+            TaskStatus status;
+            time_t due;
+            bool found;
+            if (suffix == "/status" && request.method == "PUT")
+            {
+                map<string, string> fields;
+                if (!parseJsonObject(request.body, fields) || !parseStatus(fields["status"], status))
+                {
+                    fail(response, 400, "expected {status}");
+                    return;
+                }
+                found = scheduler.changeTaskStatus(id, status);
+            }
+            else if (suffix == "" && request.method == "PUT")
+            {
+                if (!readTask(request, response, name, description, priority, status, due))
+                    return;
+                found = scheduler.modifyTask(id, name, description, status, priority, due);
+            }
+            else if (suffix == "" && request.method == "DELETE")
+            {
+                found = scheduler.removeTask(id);
+            }
+            else
+            {
+                fail(response, 405, "method not allowed");
+                return;
+            }
+            if (found)
+                succeed(response);
+            else
+                fail(response, 404, "task not found");
+        }
+    public:
+        // Serves index.html and script.js from directory root.
+        TaskApi(Scheduler& target, const string& fileRoot) : scheduler(target), root(fileRoot) {}
+
+        // Handles the common routes; extra(request, response) gets the rest and
+        // returns false for paths it does not know either.
+        template <typename Extra>
+        void handle(const HttpRequest& request, HttpResponse& response, Extra extra)
+        {
+            const string& path = request.path;
+            bool get = request.method == "GET";
+            bool post = request.method == "POST";
+            // A page on another origin can only send JSON after a CORS preflight,
+            // which this server never answers, so every change must be JSON.
+            if (!get && !jsonRequest(request))
+                fail(response, 415, "changes must be sent as application/json");
+            else if (get && (path == "/" || path == "/index.html"))
+                serveFile("index.html", "text/html; charset=utf-8", response);
+            else if (get && path == "/script.js")
+                serveFile("script.js", "application/javascript; charset=utf-8", response);
+            else if (get && path == "/api/changes")
+                changes(request, response);
+            else if (get && path == "/metrics")
+            {
+                ostringstream out;
+                writeMetricsPrometheus(out);
+                response.contentType = "text/plain; version=0.0.4; charset=utf-8";
+                response.body = out.str();
+            }
+            else if (post && path == "/api/tasks")
+            {
+                string name, description;
+                int priority;
+                TaskStatus status;
+                time_t due;
+                if (readTask(request, response, name, description, priority, status, due))
+                    succeed(response, scheduler.addTask(name, description, status, priority, due));
+            }
+            else if (post && path == "/api/claim")
+                claim(request, response);
+            else if (path.compare(0, 11, "/api/tasks/") == 0)
+                taskRequest(request, response);
+            else if (post && (path == "/api/undo" || path == "/api/redo"))
+            {
+                if (path == "/api/undo" ? scheduler.undo() : scheduler.redo())
+                    succeed(response);
+                else
+                    fail(response, 409, path == "/api/undo" ? "nothing to undo" : "nothing to redo");
+            }
+            else if (!extra(request, response))
+                fail(response, 404, "no such resource");
+        }
+        // Reply helpers for extra handlers.
+        void ok(HttpResponse& response)
+        {
+            succeed(response);
+        }
+        void error(HttpResponse& response, int status, const string& message)
+        {
+            fail(response, status, message);
+        }
+};
+
+#endif
@@ -0,0 +1,297 @@
+#ifndef TASKSNAPSHOT_H
+#define TASKSNAPSHOT_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Checksum.h"
+#include "Task.h"
+
+// Binary snapshot layout (host byte order):
+//
+//   SnapshotHeader
+//   SnapshotRecord[taskCount]    fixed width, 8-byte aligned
+//   string data                  name then description of each task, unterminated
+//
+// Each record points at its strings through stringOffset, so a reader can map
+// the file and reach any task without parsing the ones before it. The header
+// has its own CRC; records and strings are covered by separate CRCs.
+const char SNAPSHOT_MAGIC[8] = { 'T', 'S', 'K', 'S', 'N', 'A', 'P', '\0' };
+const uint32_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    int32_t nextTaskId;
+    uint32_t taskCount;
+    uint64_t recordsOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+    uint32_t recordsCrc;
+    uint32_t stringsCrc;
+    uint32_t headerCrc;     // computed with this field zeroed
+    uint32_t reserved;
+};
+
+struct SnapshotRecord
+{
+    int64_t dueDate;
+    int64_t creationDate;
+    int64_t completionDate;
+    uint64_t stringOffset;
+    int32_t taskId;
+    int32_t priority;
+    uint32_t nameLength;
+    uint32_t descriptionLength;
+    uint8_t status;
+    uint8_t reserved[7];
+};
+
+static_assert(sizeof(SnapshotHeader) == 64, "snapshot header layout changed");
+static_assert(sizeof(SnapshotRecord) == 56, "snapshot record layout changed");
+
+class TaskSnapshotWriter
+{
+    private:
+        vector<SnapshotRecord> records;
+        string strings;
+        static bool writeAll(int fd, const void* data, size_t length)
+        {
+            const char* cursor = static_cast<const char*>(data);
+            while (length > 0)
+            {
+                ssize_t written = ::write(fd, cursor, length);
+                if (written < 0)
+                {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                cursor += written;
+                length -= written;
+            }
+            return true;
+        }
+    public:
+        void reserve(size_t taskCount)
+        {
+            records.reserve(taskCount);
+        }
+        void add(const Task& task)
+        {
+            SnapshotRecord record;
+            memset(&record, 0, sizeof(record));
+            record.dueDate = task.taskDueDate;
+            record.creationDate = task.taskCreationDate;
+            record.completionDate = task.taskCompletionDate;
+            record.stringOffset = strings.size();
+            record.taskId = task.taskId;
+            record.priority = task.taskPriority;
+            record.nameLength = task.taskName.size();
+            record.descriptionLength = task.taskDescription.size();
+            record.status = task.taskStatus;
+            strings += task.taskName;
+            strings += task.taskDescription;
+            records.push_back(record);
+        }
+        // Writes to path + ".tmp", fsyncs, then renames over path.
+        bool write(const string& path, int nextTaskId, string& error) const
+        {
+            SnapshotHeader header;
+            memset(&header, 0, sizeof(header));
+            memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+            header.version = SNAPSHOT_VERSION;
+            header.headerSize = sizeof(header);
+            header.nextTaskId = nextTaskId;
+            header.taskCount = records.size();
+            header.recordsOffset = sizeof(header);
+            header.stringsOffset = header.recordsOffset + records.size() * sizeof(SnapshotRecord);
+            header.stringsSize = strings.size();
+            header.recordsCrc = crc32(records.data(), records.size() * sizeof(SnapshotRecord));
+            header.stringsCrc = crc32(strings.data(), strings.size());
+            header.headerCrc = crc32(&header, sizeof(header));
+
+            string tempPath = path + ".tmp";
+            int fd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd == -1)
+            {
+                error = tempPath + ": " + strerror(errno);
+                return false;
+            }
+            bool ok = writeAll(fd, &header, sizeof(header)) &&
+                writeAll(fd, records.data(), records.size() * sizeof(SnapshotRecord)) &&
+                writeAll(fd, strings.data(), strings.size()) &&
+                ::fsync(fd) == 0;
+            if (!ok)
+                error = tempPath + ": " + strerror(errno);
+            ::close(fd);
+            if (ok && rename(tempPath.c_str(), path.c_str()) != 0)
+            {
+                error = path + ": " + strerror(errno);
+                ok = false;
+            }
+            if (!ok)
+                unlink(tempPath.c_str());
+            return ok;
+        }
+};
+
+// Read-only view of a snapshot mapped into memory. Pages are only faulted in
+// as records and strings are touched.
+class TaskSnapshotReader
+{
+    private:
+        const char* base;
+        size_t length;
+        const SnapshotHeader* header;
+        const SnapshotRecord* records;
+        const char* strings;
+    public:
+        TaskSnapshotReader() : base(nullptr), length(0), header(nullptr), records(nullptr), strings(nullptr) {}
+        ~TaskSnapshotReader()
+        {
+            close();
+        }
+        TaskSnapshotReader(const TaskSnapshotReader&) = delete;
+        TaskSnapshotReader& operator=(const TaskSnapshotReader&) = delete;
+
+        // Maps the file and validates the header. Returns false with error set if the
+        // file is missing, truncated or from an unknown version.
+        bool open(const string& path, string& error)
+        {
+            close();
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd == -1)
+            {
+                error = path + ": " + strerror(errno);
+                return false;
+            }
+            struct stat info;
+            if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(SnapshotHeader))
+            {
+                error = path + ": file too small for a snapshot";
+                ::close(fd);
+                return false;
+            }
+            length = info.st_size;
+            void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (mapping == MAP_FAILED)
+            {
+                error = path + ": " + strerror(errno);
+                length = 0;
+                return false;
+            }
+            base = static_cast<const char*>(mapping);
+            header = reinterpret_cast<const SnapshotHeader*>(base);
+
+            SnapshotHeader copy = *header;
+            copy.headerCrc = 0;
+            if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0)
+                error = path + ": not a task snapshot";
+            else if (header->version != SNAPSHOT_VERSION || header->headerSize != sizeof(SnapshotHeader))
+                error = path + ": unsupported snapshot version " + to_string(header->version);
+            else if (crc32(&copy, sizeof(copy)) != header->headerCrc)
+                error = path + ": header checksum mismatch";
+            else if (header->recordsOffset + (uint64_t)header->taskCount * sizeof(SnapshotRecord) != header->stringsOffset ||
+                header->stringsOffset + header->stringsSize != length)
+                error = path + ": truncated snapshot";
+            else
+            {
+                records = reinterpret_cast<const SnapshotRecord*>(base + header->recordsOffset);
+                strings = base + header->stringsOffset;
+                return true;
+            }
+            close();
+            return false;
+        }
+        void close()
+        {
+            if (base)
+                munmap(const_cast<char*>(base), length);
+            base = nullptr;
+            length = 0;
+            header = nullptr;
+            records = nullptr;
+            strings = nullptr;
+        }
+        // Checks the record and string CRCs; this reads every page of the file.
+        bool verify(string& error) const
+        {
+            if (crc32(records, header->taskCount * sizeof(SnapshotRecord)) != header->recordsCrc)
+                error = "snapshot record checksum mismatch";
+            else if (crc32(strings, header->stringsSize) != header->stringsCrc)
+                error = "snapshot string checksum mismatch";
+            else
+            {
+                for (uint32_t i = 0; i < header->taskCount; i++)
+                {
+                    if (!stringsInRange(i))
+                    {
+                        error = "snapshot string offset out of range";
+                        return false;
+                    }
+                }
+                return true;
+            }
+            return false;
+        }
+        bool stringsInRange(uint32_t index) const
+        {
+            const SnapshotRecord& r = records[index];
+            return r.stringOffset <= header->stringsSize &&
+                (uint64_t)r.nameLength + r.descriptionLength <= header->stringsSize - r.stringOffset;
+        }
+        // Whether a record can be loaded at all: its strings lie inside the file
+        // and its ID and status are possible. Once verify() has failed, this
+        // picks out the records still worth recovering.
+        bool recordValid(uint32_t index) const
+        {
+            const SnapshotRecord& r = records[index];
+            return stringsInRange(index) && r.taskId > 0 && r.status <= COMPLETED;
+        }
+        uint32_t taskCount() const
+        {
+            return header->taskCount;
+        }
+        int nextTaskId() const
+        {
+            return header->nextTaskId;
+        }
+        const SnapshotRecord& record(uint32_t index) const
+        {
+            return records[index];
+        }
+        string_view name(uint32_t index) const
+        {
+            return string_view(strings + records[index].stringOffset, records[index].nameLength);
+        }
+        string_view description(uint32_t index) const
+        {
+            const SnapshotRecord& r = records[index];
+            return string_view(strings + r.stringOffset + r.nameLength, r.descriptionLength);
+        }
+        void readTask(uint32_t index, Task& task) const
+        {
+            const SnapshotRecord& r = records[index];
+            task.taskId = r.taskId;
+            task.taskName.assign(name(index));
+            task.taskDescription.assign(description(index));
+            task.taskStatus = static_cast<TaskStatus>(r.status);
+            task.taskPriority = r.priority;
+            task.taskDueDate = r.dueDate;
+            task.taskCreationDate = r.creationDate;
+            task.taskCompletionDate = r.completionDate;
+        }
+};
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef TASKSTORE_H
+#define TASKSTORE_H
+
+#include <cstdint>
+#include <vector>
+#include "Task.h"
+
+// Owns every Task. Tasks live in fixed-size slabs that are never moved or freed
+// until the store is destroyed, so Task* stays valid for the life of the task
+// and adding a task never calls malloc once its slab exists. Freed slots are
+// recycled through a free list; bumping the slot generation on release makes
+// stale handles fail to resolve instead of aliasing the slot's next occupant.
+//
+// A dense array of live slot indices gives O(1) swap-removal and contiguous
+// iteration order (at(i) for 0 <= i < size()).
+class TaskStore
+{
+    private:
+        static const uint32_t SLAB_SHIFT = 10;
+        static const uint32_t SLAB_SIZE = 1u << SLAB_SHIFT;
+        static const uint32_t NO_SLOT = 0xFFFFFFFFu;
+        struct Slot
+        {
+            Task task;
+            uint32_t generation;
+            uint32_t denseIndex;    // position in dense, or next free slot when not live
+            bool live;
+        };
+        vector<Slot*> slabs;
+        vector<uint32_t> dense;
+        uint32_t freeHead;
+        uint32_t slotCount;
+        Slot& slot(uint32_t index) const
+        {
+            return slabs[index >> SLAB_SHIFT][index & (SLAB_SIZE - 1)];
+        }
+        uint32_t acquireSlot()
+        {
+            if (freeHead != NO_SLOT)
+            {
+                uint32_t index = freeHead;
+                freeHead = slot(index).denseIndex;
+                return index;
+            }
+            if (slotCount == slabs.size() * SLAB_SIZE)
+                slabs.push_back(new Slot[SLAB_SIZE]());
+            return slotCount++;
+        }
+    public:
+        TaskStore() : freeHead(NO_SLOT), slotCount(0) {}
+        ~TaskStore()
+        {
+            for (Slot* slab : slabs)
+                delete[] slab;
+        }
+        TaskStore(const TaskStore&) = delete;
+        TaskStore& operator=(const TaskStore&) = delete;
+
+        // Copies (or moves) task into a free slot and returns the stored Task, whose
+        // handle field identifies the slot.
+        Task* add(const Task& task)
+        {
+            return add(Task(task));
+        }
+        Task* add(Task&& task)
+        {
+            uint32_t index = acquireSlot();
+            Slot& s = slot(index);
+            s.task = std::move(task);
+            s.task.handle = TaskHandle{ index, s.generation };
+            s.denseIndex = dense.size();
+            s.live = true;
+            dense.push_back(index);
+            return &s.task;
+        }
+        // Claims count empty slots at once and appends their Tasks to out, so a bulk
+        // load can fill them in place, from several threads if it likes.
+        void addEmpty(int count, vector<Task*>& out)
+        {
+            reserve(dense.size() + count);
+            out.reserve(out.size() + count);
+            for (int i = 0; i < count; i++)
+            {
+                uint32_t index = acquireSlot();
+                Slot& s = slot(index);
+                s.task.handle = TaskHandle{ index, s.generation };
+                s.denseIndex = dense.size();
+                s.live = true;
+                dense.push_back(index);
+                out.push_back(&s.task);
+            }
+        }
+        Task* get(TaskHandle handle) const
+        {
+            if (handle.index >= slotCount) return nullptr;
+            Slot& s = slot(handle.index);
+            if (!s.live || s.generation != handle.generation) return nullptr;
+            return &s.task;
+        }
+        bool remove(TaskHandle handle)
+        {
+            if (!get(handle)) return false;
+            Slot& s = slot(handle.index);
+            uint32_t moved = dense.back();
+            dense[s.denseIndex] = moved;
+            slot(moved).denseIndex = s.denseIndex;
+            dense.pop_back();
+            s.task = Task();    // release the strings now rather than on reuse
+            s.live = false;
+            s.generation++;
+            s.denseIndex = freeHead;
+            freeHead = handle.index;
+            return true;
+        }
+        int size() const
+        {
+            return dense.size();
+        }
+        Task* at(int index) const
+        {
+            if (index < 0 || index >= (int)dense.size()) return nullptr;
+            return &slot(dense[index]).task;
+        }
+        void reserve(int taskCount)
+        {
+            dense.reserve(taskCount);
+            while (slabs.size() * SLAB_SIZE < (size_t)taskCount)
+                slabs.push_back(new Slot[SLAB_SIZE]());
+        }
+        // Releases every task but keeps the slabs for reuse.
+        void clear()
+        {
+            while (!dense.empty())
+                remove(slot(dense.back()).task.handle);
+        }
+};
+
+#endif
@@ -0,0 +1,320 @@
+#ifndef TASKTEXTREADER_H
+#define TASKTEXTREADER_H
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <emmintrin.h>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Task.h"
+
+// One record of a text export. name and description point into the mapped
+// file and are only valid while the reader that produced them is open.
+struct TaskRecordView
+{
+    int taskId;
+    string_view name;
+    string_view description;
+    TaskStatus status;
+    int priority;
+    time_t dueDate;
+    time_t creationDate;
+    time_t completionDate;
+};
+
+// Runs fn(begin, end) over [0, count) split into one contiguous range per
+// thread. Small inputs stay on the calling thread.
+template <typename Fn>
+void parallelRanges(size_t count, unsigned threads, size_t minPerThread, Fn fn)
+{
+    if (threads == 0)
+        threads = max(1u, thread::hardware_concurrency());
+    threads = (unsigned)max<size_t>(1, min<size_t>(threads, count / max<size_t>(1, minPerThread)));
+    if (threads == 1)
+    {
+        fn((size_t)0, count);
+        return;
+    }
+    vector<thread> workers;
+    for (unsigned t = 1; t < threads; t++)
+        workers.emplace_back(fn, count * t / threads, count * (t + 1) / threads);
+    fn((size_t)0, count / threads);
+    for (thread& worker : workers)
+        worker.join();
+}
+
+// Parser for the tasks.txt export written by Task::writeToFile: a header of
+// nextTaskId and task count, then eight lines per task (ID, name, description,
+// status, priority, due, creation and completion dates).
+//
+// The file is mapped rather than read. Names may contain anything but a
+// newline, so a record boundary can only be found by counting lines: each
+// thread counts the newlines in its byte range, a prefix sum gives the line
+// number at every range start, and each thread then parses the records that
+// begin in its range straight into their slot in tasks(). Numbers go through
+// from_chars, which does not depend on the locale.
+class TaskTextReader
+{
+    private:
+        static const int LINES_PER_TASK = 8;
+        static const size_t MIN_CHUNK_BYTES = 1 << 20;
+        const char* base;
+        size_t length;
+        const char* body;       // first byte after the header
+        int nextId;
+        int declaredCount;
+        vector<TaskRecordView> records;
+
+        // Bit i is set when p[i] is a newline, for the (up to) 64 bytes before end.
+        static uint64_t newlineMask(const char* p, const char* end)
+        {
+            if (end - p >= 64)
+            {
+                const __m128i newline = _mm_set1_epi8('\n');
+                uint64_t mask = 0;
+                for (int i = 0; i < 4; i++)
+                {
+                    __m128i bytes = _mm_loadu_si128((const __m128i*)(p + 16 * i));
+                    mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)) << (16 * i);
+                }
+                return mask;
+            }
+            uint64_t mask = 0;
+            for (int i = 0; p + i < end; i++)
+            {
+                if (p[i] == '\n')
+                    mask |= (uint64_t)1 << i;
+            }
+            return mask;
+        }
+        static size_t countNewlines(const char* p, const char* end)
+        {
+            size_t count = 0;
+            for (; p < end; p += 64)
+                count += __builtin_popcountll(newlineMask(p, end));
+            return count;
+        }
+        // Walks a buffer line by line, finding newlines 64 bytes at a time.
+        class LineCursor
+        {
+            private:
+                const char* block;
+                const char* end;
+                uint64_t pending;   // newlines in block not yet consumed
+            public:
+                const char* position;   // start of the next line
+                LineCursor(const char* from, const char* last)
+                    : block(from), end(last), pending(newlineMask(from, last)), position(from) {}
+                // The next line, without its newline (or "\r\n").
+                string_view next()
+                {
+                    const char* start = position;
+                    while (pending == 0)
+                    {
+                        block += 64;
+                        if (block >= end)
+                        {
+                            position = end;
+                            return trim(start, end);
+                        }
+                        pending = newlineMask(block, end);
+                    }
+                    const char* newline = block + __builtin_ctzll(pending);
+                    pending &= pending - 1;
+                    position = newline + 1;
+                    return trim(start, newline);
+                }
+                static string_view trim(const char* start, const char* stop)
+                {
+                    if (stop > start && stop[-1] == '\r')
+                        stop--;
+                    return string_view(start, stop - start);
+                }
+        };
+        template <typename T>
+        static bool number(string_view line, T& value)
+        {
+            const char* first = line.data();
+            const char* last = first + line.size();
+            while (first < last && (*first == ' ' || *first == '\t'))
+                first++;
+            from_chars_result result = from_chars(first, last, value);
+            return result.ec == errc() && result.ptr == last;
+        }
+        static bool parseRecord(LineCursor& lines, TaskRecordView& record)
+        {
+            int status = 0;
+            int64_t due = 0, created = 0, completed = 0;
+            bool ok = number(lines.next(), record.taskId);
+            record.name = lines.next();
+            record.description = lines.next();
+            ok = number(lines.next(), status) && ok && status >= PENDING && status <= COMPLETED;
+            ok = number(lines.next(), record.priority) && ok;
+            ok = number(lines.next(), due) && ok;
+            ok = number(lines.next(), created) && ok;
+            ok = number(lines.next(), completed) && ok;
+            if (!ok) return false;
+            record.status = (TaskStatus)status;
+            record.dueDate = due;
+            record.creationDate = created;
+            record.completionDate = completed;
+            return true;
+        }
+    public:
+        TaskTextReader() : base(nullptr), length(0), body(nullptr), nextId(1), declaredCount(0) {}
+        ~TaskTextReader()
+        {
+            close();
+        }
+        TaskTextReader(const TaskTextReader&) = delete;
+        TaskTextReader& operator=(const TaskTextReader&) = delete;
+
+        // Maps path and reads the header.
+        bool open(const string& path, string& error)
+        {
+            close();
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd == -1)
+            {
+                error = path + ": " + strerror(errno);
+                return false;
+            }
+            struct stat info;
+            if (fstat(fd, &info) != 0)
+            {
+                error = path + ": " + strerror(errno);
+                ::close(fd);
+                return false;
+            }
+            length = info.st_size;
+            if (length > 0)
+            {
+                void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping == MAP_FAILED)
+                {
+                    error = path + ": " + strerror(errno);
+                    ::close(fd);
+                    return false;
+                }
+                base = (const char*)mapping;
+                madvise(mapping, length, MADV_SEQUENTIAL);
+            }
+            ::close(fd);
+            if (length == 0)
+            {
+                error = "Invalid task count in file.";
+                return false;
+            }
+
+            LineCursor lines(base, base + length);
+            if (!number(lines.next(), nextId) || !number(lines.next(), declaredCount) || declaredCount < 0)
+            {
+                error = "Invalid task count in file.";
+                close();
+                return false;
+            }
+            body = lines.position;
+            return true;
+        }
+        // Parses every record using up to threads threads (0: one per core). On
+        // a malformed record, returns false; tasks() then holds the records
+        // before it.
+        bool parse(string& error, unsigned threads = 0)
+        {
+            records.clear();
+            const char* end = base + length;
+            size_t bodyLength = end - body;
+
+            vector<size_t> chunkStarts;
+            vector<size_t> chunkLines;
+            unsigned chunks = (unsigned)max<size_t>(1, min<size_t>(threads ? threads : max(1u, thread::hardware_concurrency()),
+                bodyLength / MIN_CHUNK_BYTES));
+            for (unsigned c = 0; c <= chunks; c++)
+                chunkStarts.push_back(bodyLength * c / chunks);
+            chunkLines.assign(chunks + 1, 0);
+            parallelRanges(chunks, chunks, 1, [&](size_t first, size_t last) {
+                for (size_t c = first; c < last; c++)
+                    chunkLines[c + 1] = countNewlines(body + chunkStarts[c], body + chunkStarts[c + 1]);
+            });
+            for (unsigned c = 0; c < chunks; c++)
+                chunkLines[c + 1] += chunkLines[c];
+            size_t lines = chunkLines[chunks] + (bodyLength > 0 && end[-1] != '\n' ? 1 : 0);
+            size_t available = lines / LINES_PER_TASK;
+            size_t wanted = min<size_t>(available, declaredCount);
+            records.resize(wanted);
+
+            // Each chunk parses the records whose first line starts inside it.
+            vector<size_t> firstBad(chunks, SIZE_MAX);
+            parallelRanges(chunks, chunks, 1, [&](size_t first, size_t last) {
+                for (size_t c = first; c < last; c++)
+                {
+                    const char* chunkStart = body + chunkStarts[c];
+                    const char* chunkEnd = body + chunkStarts[c + 1];
+                    LineCursor lines(chunkStart, end);
+                    size_t line = chunkLines[c];
+                    if (chunkStart > body && chunkStart[-1] != '\n')
+                    {
+                        lines.next();   // tail of a line that began in the previous chunk
+                        line++;
+                    }
+                    while (line % LINES_PER_TASK != 0 && lines.position < chunkEnd)
+                    {
+                        lines.next();
+                        line++;
+                    }
+                    while (lines.position < chunkEnd && line / LINES_PER_TASK < wanted)
+                    {
+                        size_t index = line / LINES_PER_TASK;
+                        if (!parseRecord(lines, records[index]))
+                        {
+                            firstBad[c] = index;
+                            break;
+                        }
+                        line += LINES_PER_TASK;
+                    }
+                }
+            });
+
+            size_t bad = *min_element(firstBad.begin(), firstBad.end());
+            if (bad != SIZE_MAX)
+            {
+                records.resize(bad);
+                error = "Failed to read task " + to_string(bad + 1) + " from file.";
+                return false;
+            }
+            if (wanted < (size_t)declaredCount)
+            {
+                error = "Failed to read task " + to_string(wanted + 1) + " from file.";
+                return false;
+            }
+            return true;
+        }
+        const vector<TaskRecordView>& tasks() const
+        {
+            return records;
+        }
+        int nextTaskId() const
+        {
+            return nextId;
+        }
+        void close()
+        {
+            if (base)
+                munmap((void*)base, length);
+            base = nullptr;
+            body = nullptr;
+            length = 0;
+            records.clear();
+        }
+};
+
+#endif
@@ -0,0 +1,272 @@
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include <cstdint>
+#include <ctime>
+#include "Task.h"
+
+// Hierarchical timing wheel over task due dates, at one-minute resolution.
+//
+// Level L has 64 slots, each covering 64^L minutes, so five levels reach about
+// 2000 years ahead; anything later waits on an overflow list. A task sits in
+// the slot of the coarsest level that still separates it from the current
+// minute, and is re-filed into a finer level ("cascaded") when time reaches
+// its slot. Tasks are linked intrusively through Task::dueLink, which makes
+// insert and cancel O(1).
+//
+// advance() moves the wheel to the present and reports each task whose due
+// date has passed exactly once; those tasks then stay on an overdue list until
+// they are completed, removed or given a new due date. A per-level occupancy
+// bitmap lets advance() jump straight to the next minute where anything
+// happens instead of stepping through empty ones.
+//
+// Completed tasks and tasks without a due date (0) are not tracked.
+class TimingWheel
+{
+    private:
+        static const int SLOT_BITS = 6;
+        static const int SLOTS = 1 << SLOT_BITS;
+        static const int LEVELS = 5;
+        static const int OVERFLOW_LIST = LEVELS * SLOTS;
+        static const int DUE_LIST = OVERFLOW_LIST + 1;      // past due, not yet reported
+        static const int OVERDUE_LIST = OVERFLOW_LIST + 2;  // past due and reported
+        static const int LIST_COUNT = OVERFLOW_LIST + 3;
+        static const time_t TICK_SECONDS = 60;
+        Task* lists[LIST_COUNT];
+        uint64_t occupied[LEVELS];
+        int counts[LIST_COUNT];
+        int64_t current;    // last minute processed
+        int tracked;
+
+        // First minute at or after the due date, so a task is never reported early.
+        static int64_t tickOf(time_t dueDate)
+        {
+            return ((int64_t)dueDate + TICK_SECONDS - 1) / TICK_SECONDS;
+        }
+        static int64_t levelSpan(int level)
+        {
+            return (int64_t)1 << (SLOT_BITS * level);
+        }
+        static bool wanted(const Task* task)
+        {
+            return task->taskStatus != COMPLETED && task->taskDueDate > 0;
+        }
+        void link(Task* task, int list)
+        {
+            DueLink& links = task->dueLink;
+            links.prev = nullptr;
+            links.next = lists[list];
+            links.list = list;
+            if (lists[list])
+                lists[list]->dueLink.prev = task;
+            lists[list] = task;
+            counts[list]++;
+            if (list < OVERFLOW_LIST)
+                occupied[list / SLOTS] |= (uint64_t)1 << (list % SLOTS);
+        }
+        void unlink(Task* task)
+        {
+            DueLink& links = task->dueLink;
+            if (links.prev)
+                links.prev->dueLink.next = links.next;
+            else
+                lists[links.list] = links.next;
+            if (links.next)
+                links.next->dueLink.prev = links.prev;
+            counts[links.list]--;
+            if (links.list < OVERFLOW_LIST && !lists[links.list])
+                occupied[links.list / SLOTS] &= ~((uint64_t)1 << (links.list % SLOTS));
+            links.prev = links.next = nullptr;
+            links.list = -1;
+        }
+        // Files a task by how far its due minute is from the current one.
+        void place(Task* task)
+        {
+            int64_t tick = task->dueLink.tick;
+            if (tick <= current)
+            {
+                link(task, DUE_LIST);
+                return;
+            }
+            int64_t distance = tick - current;
+            int level = 0;
+            while (level < LEVELS && distance >= levelSpan(level + 1))
+                level++;
+            if (level == LEVELS)
+                link(task, OVERFLOW_LIST);
+            else
+                link(task, level * SLOTS + (int)((tick >> (SLOT_BITS * level)) & (SLOTS - 1)));
+        }
+        // Re-files every task in a list relative to the current minute.
+        void refile(int list)
+        {
+            Task* task = lists[list];
+            while (task)
+            {
+                Task* next = task->dueLink.next;
+                unlink(task);
+                place(task);
+                task = next;
+            }
+        }
+        // The next minute after current at which a slot expires or a level cascades.
+        int64_t nextEvent() const
+        {
+            int64_t next = INT64_MAX;
+            if (occupied[0])
+            {
+                int from = (int)((current + 1) & (SLOTS - 1));
+                uint64_t ahead = (occupied[0] >> from) | (from ? occupied[0] << (SLOTS - from) : 0);
+                next = current + 1 + __builtin_ctzll(ahead);
+            }
+            for (int level = 1; level <= LEVELS; level++)
+            {
+                bool busy = level < LEVELS ? occupied[level] != 0 : counts[OVERFLOW_LIST] > 0;
+                if (busy)
+                {
+                    int64_t boundary = ((current >> (SLOT_BITS * level)) + 1) << (SLOT_BITS * level);
+                    return next < boundary ? next : boundary;
+                }
+            }
+            return next;
+        }
+        template <typename Report>
+        void reportDue(Report& report)
+        {
+            while (lists[DUE_LIST])
+            {
+                Task* task = lists[DUE_LIST];
+                unlink(task);
+                link(task, OVERDUE_LIST);
+                report(task);
+            }
+        }
+    public:
+        explicit TimingWheel(time_t now = time(0))
+        {
+            current = now / TICK_SECONDS;
+            tracked = 0;
+            for (int i = 0; i < LIST_COUNT; i++)
+            {
+                lists[i] = nullptr;
+                counts[i] = 0;
+            }
+            for (int i = 0; i < LEVELS; i++)
+                occupied[i] = 0;
+        }
+        // Starts tracking a task that is not in the wheel yet (its link fields are ignored).
+        void insert(Task* task)
+        {
+            task->dueLink.list = -1;
+            update(task);
+        }
+        // Re-files a tracked task after its due date or status changed. A task
+        // already reported overdue keeps that state unless its due date moved.
+        void update(Task* task)
+        {
+            bool track = wanted(task);
+            int64_t tick = track ? tickOf(task->taskDueDate) : 0;
+            if (task->dueLink.list != -1)
+            {
+                if (track && task->dueLink.tick == tick) return;
+                unlink(task);
+                tracked--;
+            }
+            if (!track) return;
+            task->dueLink.tick = tick;
+            place(task);
+            tracked++;
+        }
+        void remove(Task* task)
+        {
+            if (task->dueLink.list == -1) return;
+            unlink(task);
+            tracked--;
+        }
+        // Moves the wheel to now and calls report(Task*) for every task that has
+        // become overdue since the last call.
+        template <typename Report>
+        void advance(time_t now, Report report)
+        {
+            int64_t target = now / TICK_SECONDS;
+            reportDue(report);
+            while (current < target)
+            {
+                int64_t next = nextEvent();
+                if (next > target)
+                {
+                    current = target;
+                    break;
+                }
+                current = next;
+                if (current % levelSpan(LEVELS) == 0)
+                    refile(OVERFLOW_LIST);
+                for (int level = LEVELS - 1; level >= 1; level--)
+                {
+                    if (current % levelSpan(level) == 0)
+                        refile(level * SLOTS + (int)((current >> (SLOT_BITS * level)) & (SLOTS - 1)));
+                }
+                refile((int)(current & (SLOTS - 1)));
+                reportDue(report);
+            }
+        }
+        // Calls visit(Task*) for each tracked task that is not yet overdue and is
+        // due no later than horizon. Only the slots overlapping the window are
+        // walked, so the cost follows the window, not the number of tasks.
+        template <typename Visit>
+        void forEachDueBefore(time_t horizon, Visit visit) const
+        {
+            int64_t last = tickOf(horizon);
+            if (last <= current) return;
+            for (int level = 0; level < LEVELS; level++)
+            {
+                int shift = SLOT_BITS * level;
+                int64_t firstBlock = (current >> shift) + (level == 0 ? 1 : 0);
+                int64_t lastBlock = last >> shift;
+                if (lastBlock - firstBlock >= SLOTS)
+                    lastBlock = firstBlock + SLOTS - 1;
+                for (int64_t block = firstBlock; block <= lastBlock; block++)
+                {
+                    for (Task* task = lists[level * SLOTS + (int)(block & (SLOTS - 1))]; task; task = task->dueLink.next)
+                    {
+                        if (task->taskDueDate <= horizon)
+                            visit(task);
+                    }
+                }
+            }
+            if (last - current >= levelSpan(LEVELS))
+            {
+                for (Task* task = lists[OVERFLOW_LIST]; task; task = task->dueLink.next)
+                {
+                    if (task->taskDueDate <= horizon)
+                        visit(task);
+                }
+            }
+        }
+        // Tasks already reported overdue and still open.
+        template <typename Visit>
+        void forEachOverdue(Visit visit) const
+        {
+            for (Task* task = lists[OVERDUE_LIST]; task; task = task->dueLink.next)
+                visit(task);
+        }
+        int overdueCount() const
+        {
+            return counts[OVERDUE_LIST];
+        }
+        int size() const
+        {
+            return tracked;
+        }
+        void clear()
+        {
+            for (int i = 0; i < LIST_COUNT; i++)
+            {
+                while (lists[i])
+                    unlink(lists[i]);
+            }
+            tracked = 0;
+        }
+};
+
+#endif
@@ -1,25 +1,658 @@
 #include "Trie.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+template <typename Node>
+Node* newInner(TrieNodeType type) {
+    Node* node = new Node();
+    node->type = type;
+    return node;
+}
+
+// Copies the shared header of a node that is being resized.
+template <typename Node>
+Node* resized(const TrieInner* from, TrieNodeType type) {
+    Node* node = new Node();
+    *(TrieInner*)node = *from;
+    node->type = type;
+    return node;
+}
+
+template <typename Node>
+void insertSorted(Node* node, unsigned char byte, TrieNode* child) {
+    int i = 0;
+    while (i < node->childCount && node->keys[i] < byte)
+        i++;
+    memmove(node->keys + i + 1, node->keys + i, node->childCount - i);
+    memmove(node->children + i + 1, node->children + i, (node->childCount - i) * sizeof(TrieNode*));
+    node->keys[i] = byte;
+    node->children[i] = child;
+    node->childCount++;
+}
+
+template <typename Node>
+void removeSorted(Node* node, unsigned char byte) {
+    int i = 0;
+    while (i < node->childCount && node->keys[i] != byte)
+        i++;
+    if (i == node->childCount)
+        return;
+    memmove(node->keys + i, node->keys + i + 1, node->childCount - i - 1);
+    memmove(node->children + i, node->children + i + 1, (node->childCount - i - 1) * sizeof(TrieNode*));
+    node->childCount--;
+}
+
+}
+
+TrieLeaf* Trie::newLeaf(const string& key, int id) {
+    TrieLeaf* leaf = new (::operator new(sizeof(TrieLeaf) + key.size())) TrieLeaf();
+    leaf->type = TRIE_LEAF;
+    leaf->keyLength = key.size();
+    leaf->id = id;
+    leaf->idCount = 1;
+    leaf->moreIds = nullptr;
+    memcpy((char*)(leaf + 1), key.data(), key.size());
+    return leaf;
+}
+
+void Trie::freeLeaf(TrieLeaf* leaf) {
+    if (!leaf)
+        return;
+    delete leaf->moreIds;
+    ::operator delete(leaf);
+}
+
+bool Trie::leafMatches(const TrieLeaf* leaf, const string& key, bool prefixOnly) {
+    if (prefixOnly ? leaf->keyLength < key.size() : leaf->keyLength != key.size())
+        return false;
+    return memcmp(leaf->key(), key.data(), key.size()) == 0;
+}
+
+void Trie::addId(TrieLeaf* leaf, int id) {
+    if (!leaf->moreIds)
+        leaf->moreIds = new vector<int>();
+    leaf->moreIds->push_back(id);
+    leaf->idCount++;
+}
+
+// Removes id, keeping the remaining IDs in insertion order.
+bool Trie::removeId(TrieLeaf* leaf, int id) {
+    if (leaf->id == id) {
+        if (leaf->moreIds && !leaf->moreIds->empty()) {
+            leaf->id = leaf->moreIds->front();
+            leaf->moreIds->erase(leaf->moreIds->begin());
+        }
+        leaf->idCount--;
+        return true;
+    }
+    if (!leaf->moreIds)
+        return false;
+    vector<int>::iterator it = std::find(leaf->moreIds->begin(), leaf->moreIds->end(), id);
+    if (it == leaf->moreIds->end())
+        return false;
+    leaf->moreIds->erase(it);
+    leaf->idCount--;
+    return true;
+}
 
 Trie::Trie() {
-    root = new TrieNode();
+    root = nullptr;
+    keyCount = 0;
+}
+
+Trie::~Trie() {
+    destroy(root);
+}
+
+void Trie::destroy(TrieNode* node) {
+    if (!node)
+        return;
+    switch (node->type) {
+    case TRIE_LEAF:
+        freeLeaf((TrieLeaf*)node);
+        return;
+    case TRIE_NODE4: {
+        TrieNode4* inner = (TrieNode4*)node;
+        for (int i = 0; i < inner->childCount; i++)
+            destroy(inner->children[i]);
+        freeLeaf(inner->terminal);
+        delete inner;
+        return;
+    }
+    case TRIE_NODE16: {
+        TrieNode16* inner = (TrieNode16*)node;
+        for (int i = 0; i < inner->childCount; i++)
+            destroy(inner->children[i]);
+        freeLeaf(inner->terminal);
+        delete inner;
+        return;
+    }
+    case TRIE_NODE48: {
+        TrieNode48* inner = (TrieNode48*)node;
+        for (int i = 0; i < 48; i++)
+            destroy(inner->children[i]);
+        freeLeaf(inner->terminal);
+        delete inner;
+        return;
+    }
+    case TRIE_NODE256: {
+        TrieNode256* inner = (TrieNode256*)node;
+        for (int i = 0; i < 256; i++)
+            destroy(inner->children[i]);
+        freeLeaf(inner->terminal);
+        delete inner;
+        return;
+    }
+    }
+}
+
+TrieNode** Trie::findChild(TrieNode* node, unsigned char byte) {
+    switch (node->type) {
+    case TRIE_NODE4: {
+        TrieNode4* inner = (TrieNode4*)node;
+        for (int i = 0; i < inner->childCount; i++) {
+            if (inner->keys[i] == byte)
+                return &inner->children[i];
+        }
+        return nullptr;
+    }
+    case TRIE_NODE16: {
+        TrieNode16* inner = (TrieNode16*)node;
+#ifdef __SSE2__
+        __m128i matches = _mm_cmpeq_epi8(_mm_set1_epi8((char)byte), _mm_loadu_si128((const __m128i*)inner->keys));
+        int mask = _mm_movemask_epi8(matches) & ((1 << inner->childCount) - 1);
+        return mask ? &inner->children[__builtin_ctz(mask)] : nullptr;
+#else
+        for (int i = 0; i < inner->childCount; i++) {
+            if (inner->keys[i] == byte)
+                return &inner->children[i];
+        }
+        return nullptr;
+#endif
+    }
+    case TRIE_NODE48: {
+        TrieNode48* inner = (TrieNode48*)node;
+        int slot = inner->childIndex[byte];
+        return slot ? &inner->children[slot - 1] : nullptr;
+    }
+    case TRIE_NODE256: {
+        TrieNode256* inner = (TrieNode256*)node;
+        return inner->children[byte] ? &inner->children[byte] : nullptr;
+    }
+    default:
+        return nullptr;
+    }
+}
+
+// Adds a child under a byte not yet present, growing the node if it is full.
+void Trie::addChild(TrieNode*& ref, unsigned char byte, TrieNode* child) {
+    switch (ref->type) {
+    case TRIE_NODE4: {
+        TrieNode4* node = (TrieNode4*)ref;
+        if (node->childCount < 4) {
+            insertSorted(node, byte, child);
+            return;
+        }
+        TrieNode16* grown = resized<TrieNode16>(node, TRIE_NODE16);
+        memcpy(grown->keys, node->keys, 4);
+        memcpy(grown->children, node->children, 4 * sizeof(TrieNode*));
+        delete node;
+        ref = grown;
+        insertSorted(grown, byte, child);
+        return;
+    }
+    case TRIE_NODE16: {
+        TrieNode16* node = (TrieNode16*)ref;
+        if (node->childCount < 16) {
+            insertSorted(node, byte, child);
+            return;
+        }
+        TrieNode48* grown = resized<TrieNode48>(node, TRIE_NODE48);
+        for (int i = 0; i < 16; i++) {
+            grown->childIndex[node->keys[i]] = i + 1;
+            grown->children[i] = node->children[i];
+        }
+        delete node;
+        ref = grown;
+        addChild(ref, byte, child);
+        return;
+    }
+    case TRIE_NODE48: {
+        TrieNode48* node = (TrieNode48*)ref;
+        if (node->childCount < 48) {
+            int slot = 0;
+            while (node->children[slot])
+                slot++;
+            node->children[slot] = child;
+            node->childIndex[byte] = slot + 1;
+            node->childCount++;
+            return;
+        }
+        TrieNode256* grown = resized<TrieNode256>(node, TRIE_NODE256);
+        for (int b = 0; b < 256; b++) {
+            if (node->childIndex[b])
+                grown->children[b] = node->children[node->childIndex[b] - 1];
+        }
+        delete node;
+        ref = grown;
+        addChild(ref, byte, child);
+        return;
+    }
+    case TRIE_NODE256: {
+        TrieNode256* node = (TrieNode256*)ref;
+        node->children[byte] = child;
+        node->childCount++;
+        return;
+    }
+    default:
+        return;
+    }
+}
+
+// Drops the child under byte, shrinking the node once it falls well below
+// its capacity (with some slack so alternating add/remove does not thrash).
+void Trie::removeChild(TrieNode*& ref, unsigned char byte) {
+    switch (ref->type) {
+    case TRIE_NODE4:
+        removeSorted((TrieNode4*)ref, byte);
+        collapse(ref);
+        return;
+    case TRIE_NODE16: {
+        TrieNode16* node = (TrieNode16*)ref;
+        removeSorted(node, byte);
+        if (node->childCount > 3)
+            return;
+        TrieNode4* shrunk = resized<TrieNode4>(node, TRIE_NODE4);
+        memcpy(shrunk->keys, node->keys, node->childCount);
+        memcpy(shrunk->children, node->children, node->childCount * sizeof(TrieNode*));
+        delete node;
+        ref = shrunk;
+        return;
+    }
+    case TRIE_NODE48: {
+        TrieNode48* node = (TrieNode48*)ref;
+        node->children[node->childIndex[byte] - 1] = nullptr;
+        node->childIndex[byte] = 0;
+        node->childCount--;
+        if (node->childCount > 12)
+            return;
+        TrieNode16* shrunk = resized<TrieNode16>(node, TRIE_NODE16);
+        shrunk->childCount = 0;
+        for (int b = 0; b < 256; b++) {
+            if (node->childIndex[b]) {
+                shrunk->keys[shrunk->childCount] = b;
+                shrunk->children[shrunk->childCount++] = node->children[node->childIndex[b] - 1];
+            }
+        }
+        delete node;
+        ref = shrunk;
+        return;
+    }
+    case TRIE_NODE256: {
+        TrieNode256* node = (TrieNode256*)ref;
+        node->children[byte] = nullptr;
+        node->childCount--;
+        if (node->childCount > 37)
+            return;
+        TrieNode48* shrunk = resized<TrieNode48>(node, TRIE_NODE48);
+        shrunk->childCount = 0;
+        for (int b = 0; b < 256; b++) {
+            if (node->children[b]) {
+                shrunk->children[shrunk->childCount] = node->children[b];
+                shrunk->childIndex[b] = ++shrunk->childCount;
+            }
+        }
+        delete node;
+        ref = shrunk;
+        return;
+    }
+    default:
+        return;
+    }
 }
 
-void Trie::insert(string word) {
+// A Node4 left with one path and no terminal is merged into its child; one
+// left with only a terminal is replaced by that leaf.
+void Trie::collapse(TrieNode*& ref) {
+    TrieNode4* node = (TrieNode4*)ref;
+    if (node->childCount == 0) {
+        ref = node->terminal;
+        delete node;
+        return;
+    }
+    if (node->childCount > 1 || node->terminal)
+        return;
+    TrieNode* child = node->children[0];
+    if (child->type != TRIE_LEAF) {
+        TrieInner* inner = (TrieInner*)child;
+        unsigned char merged[TRIE_MAX_PREFIX];
+        uint32_t length = min(node->prefixLength, TRIE_MAX_PREFIX);
+        memcpy(merged, node->prefix, length);
+        if (length < TRIE_MAX_PREFIX)
+            merged[length++] = node->keys[0];
+        for (uint32_t i = 0; i < inner->prefixLength && length < TRIE_MAX_PREFIX; i++)
+            merged[length++] = inner->prefix[i];
+        memcpy(inner->prefix, merged, length);
+        inner->prefixLength += node->prefixLength + 1;
+    }
+    ref = child;
+    delete node;
+}
+
+// Hangs leaf off the inner node at ref, whose path ends at depth.
+void Trie::attach(TrieNode*& ref, TrieLeaf* leaf, size_t depth) {
+    if (leaf->keyLength == depth)
+        ((TrieInner*)ref)->terminal = leaf;
+    else
+        addChild(ref, leaf->key()[depth], leaf);
+}
+
+const TrieLeaf* Trie::minimumLeaf(const TrieNode* node) {
+    while (node && node->type != TRIE_LEAF) {
+        const TrieInner* inner = (const TrieInner*)node;
+        if (inner->terminal)
+            return inner->terminal;
+        switch (node->type) {
+        case TRIE_NODE4:
+            node = ((const TrieNode4*)node)->children[0];
+            break;
+        case TRIE_NODE16:
+            node = ((const TrieNode16*)node)->children[0];
+            break;
+        case TRIE_NODE48: {
+            const TrieNode48* wide = (const TrieNode48*)node;
+            int b = 0;
+            while (!wide->childIndex[b])
+                b++;
+            node = wide->children[wide->childIndex[b] - 1];
+            break;
+        }
+        default: {
+            const TrieNode256* wide = (const TrieNode256*)node;
+            int b = 0;
+            while (!wide->children[b])
+                b++;
+            node = wide->children[b];
+            break;
+        }
+        }
+    }
+    return (const TrieLeaf*)node;
+}
+
+// Optimistic check of the stored prefix bytes only; the leaf comparison at the
+// end of a lookup catches any mismatch in the bytes that were not stored.
+bool Trie::storedPrefixMatches(const TrieInner* node, const string& key, size_t depth) {
+    if (depth + node->prefixLength > key.size())
+        return false;
+    uint32_t stored = min(node->prefixLength, TRIE_MAX_PREFIX);
+    for (uint32_t i = 0; i < stored; i++) {
+        if (node->prefix[i] != (unsigned char)key[depth + i])
+            return false;
+    }
+    return true;
+}
+
+// Number of leading bytes of node's full prefix that match key from depth on,
+// stopping early if key runs out.
+size_t Trie::prefixMismatch(const TrieInner* node, const string& key, size_t depth) {
+    size_t limit = min((size_t)node->prefixLength, key.size() - depth);
+    size_t stored = min(limit, (size_t)TRIE_MAX_PREFIX);
+    size_t i = 0;
+    for (; i < stored; i++) {
+        if (node->prefix[i] != (unsigned char)key[depth + i])
+            return i;
+    }
+    if (limit > TRIE_MAX_PREFIX) {
+        const TrieLeaf* leaf = minimumLeaf(node);
+        for (; i < limit; i++) {
+            if (leaf->key()[depth + i] != key[depth + i])
+                return i;
+        }
+    }
+    return i;
+}
+
+bool Trie::insertAt(TrieNode*& ref, const string& key, size_t depth, int id) {
+    TrieNode* node = ref;
+    if (!node) {
+        ref = newLeaf(key, id);
+        return true;
+    }
+    if (node->type == TRIE_LEAF) {
+        TrieLeaf* leaf = (TrieLeaf*)node;
+        if (leafMatches(leaf, key)) {
+            addId(leaf, id);
+            return false;
+        }
+        // Two keys now share this path: split at their first differing byte.
+        size_t limit = min((size_t)leaf->keyLength, key.size()) - depth;
+        size_t common = 0;
+        while (common < limit && leaf->key()[depth + common] == key[depth + common])
+            common++;
+        TrieNode4* split = newInner<TrieNode4>(TRIE_NODE4);
+        split->prefixLength = common;
+        memcpy(split->prefix, key.data() + depth, min(common, (size_t)TRIE_MAX_PREFIX));
+        TrieNode* splitRef = split;
+        attach(splitRef, leaf, depth + common);
+        attach(splitRef, newLeaf(key, id), depth + common);
+        ref = splitRef;
+        return true;
+    }
+
+    TrieInner* inner = (TrieInner*)node;
+    if (inner->prefixLength) {
+        size_t match = prefixMismatch(inner, key, depth);
+        if (match < inner->prefixLength) {
+            // The key leaves the compressed path part-way: split the prefix.
+            TrieNode4* split = newInner<TrieNode4>(TRIE_NODE4);
+            split->prefixLength = match;
+            memcpy(split->prefix, inner->prefix, min(match, (size_t)TRIE_MAX_PREFIX));
+            unsigned char byte;
+            if (inner->prefixLength <= TRIE_MAX_PREFIX) {
+                byte = inner->prefix[match];
+                inner->prefixLength -= match + 1;
+                memmove(inner->prefix, inner->prefix + match + 1, inner->prefixLength);
+            } else {
+                const TrieLeaf* leaf = minimumLeaf(inner);
+                byte = leaf->key()[depth + match];
+                inner->prefixLength -= match + 1;
+                memcpy(inner->prefix, leaf->key() + depth + match + 1, min(inner->prefixLength, TRIE_MAX_PREFIX));
+            }
+            TrieNode* splitRef = split;
+            addChild(splitRef, byte, inner);
+            attach(splitRef, newLeaf(key, id), depth + match);
+            ref = splitRef;
+            return true;
+        }
+        depth += inner->prefixLength;
+    }
+    if (depth == key.size()) {
+        if (inner->terminal) {
+            addId(inner->terminal, id);
+            return false;
+        }
+        inner->terminal = newLeaf(key, id);
+        return true;
+    }
+    TrieNode** child = findChild(node, key[depth]);
+    if (child)
+        return insertAt(*child, key, depth + 1, id);
+    addChild(ref, key[depth], newLeaf(key, id));
+    return true;
+}
+
+void Trie::insert(const string& word, int id) {
+    if (insertAt(root, word, 0, id))
+        keyCount++;
+}
+
+bool Trie::eraseAt(TrieNode*& ref, const string& key, size_t depth, int id) {
+    TrieNode* node = ref;
+    if (!node)
+        return false;
+    if (node->type == TRIE_LEAF) {
+        TrieLeaf* leaf = (TrieLeaf*)node;
+        if (!leafMatches(leaf, key) || !removeId(leaf, id))
+            return false;
+        if (leaf->idCount == 0) {
+            freeLeaf(leaf);
+            ref = nullptr;
+            keyCount--;
+        }
+        return true;
+    }
+    TrieInner* inner = (TrieInner*)node;
+    if (!storedPrefixMatches(inner, key, depth))
+        return false;
+    depth += inner->prefixLength;
+    if (depth == key.size()) {
+        TrieLeaf* leaf = inner->terminal;
+        if (!leaf || !leafMatches(leaf, key) || !removeId(leaf, id))
+            return false;
+        if (leaf->idCount == 0) {
+            freeLeaf(leaf);
+            inner->terminal = nullptr;
+            keyCount--;
+            if (inner->type == TRIE_NODE4)
+                collapse(ref);
+        }
+        return true;
+    }
+    unsigned char byte = key[depth];
+    TrieNode** child = findChild(node, byte);
+    if (!child || !eraseAt(*child, key, depth + 1, id))
+        return false;
+    if (!*child)
+        removeChild(ref, byte);
+    return true;
+}
+
+bool Trie::erase(const string& word, int id) {
+    return eraseAt(root, word, 0, id);
+}
+
+const TrieLeaf* Trie::findLeaf(const string& key) const {
     TrieNode* node = root;
-    for (char c : word) {
-        if (!node->children[c - 'a'])
-            node->children[c - 'a'] = new TrieNode();
-        node = node->children[c - 'a'];
+    size_t depth = 0;
+    while (node) {
+        if (node->type == TRIE_LEAF) {
+            const TrieLeaf* leaf = (const TrieLeaf*)node;
+            return leafMatches(leaf, key) ? leaf : nullptr;
+        }
+        TrieInner* inner = (TrieInner*)node;
+        if (!storedPrefixMatches(inner, key, depth))
+            return nullptr;
+        depth += inner->prefixLength;
+        if (depth == key.size())
+            return inner->terminal && leafMatches(inner->terminal, key) ? inner->terminal : nullptr;
+        TrieNode** child = findChild(node, key[depth]);
+        node = child ? *child : nullptr;
+        depth++;
     }
-    node->isEnd = true;
+    return nullptr;
 }
 
-bool Trie::search(string word) {
+bool Trie::search(const string& word) const {
+    return findLeaf(word) != nullptr;
+}
+
+vector<int> Trie::find(const string& word) const {
+    vector<int> ids;
+    const TrieLeaf* leaf = findLeaf(word);
+    if (leaf)
+        collect(leaf, ids, 0);
+    return ids;
+}
+
+// Appends the IDs under node in key order; returns false once limit is hit.
+bool Trie::collect(const TrieNode* node, vector<int>& ids, size_t limit) {
+    if (node->type == TRIE_LEAF) {
+        const TrieLeaf* leaf = (const TrieLeaf*)node;
+        for (uint32_t i = 0; i < leaf->idCount; i++) {
+            if (limit && ids.size() >= limit)
+                return false;
+            ids.push_back(i == 0 ? leaf->id : (*leaf->moreIds)[i - 1]);
+        }
+        return true;
+    }
+    const TrieInner* inner = (const TrieInner*)node;
+    if (inner->terminal && !collect(inner->terminal, ids, limit))
+        return false;
+    switch (node->type) {
+    case TRIE_NODE4: {
+        const TrieNode4* small = (const TrieNode4*)node;
+        for (int i = 0; i < small->childCount; i++) {
+            if (!collect(small->children[i], ids, limit))
+                return false;
+        }
+        return true;
+    }
+    case TRIE_NODE16: {
+        const TrieNode16* small = (const TrieNode16*)node;
+        for (int i = 0; i < small->childCount; i++) {
+            if (!collect(small->children[i], ids, limit))
+                return false;
+        }
+        return true;
+    }
+    case TRIE_NODE48: {
+        const TrieNode48* wide = (const TrieNode48*)node;
+        for (int b = 0; b < 256; b++) {
+            if (wide->childIndex[b] && !collect(wide->children[wide->childIndex[b] - 1], ids, limit))
+                return false;
+        }
+        return true;
+    }
+    default: {
+        const TrieNode256* wide = (const TrieNode256*)node;
+        for (int b = 0; b < 256; b++) {
+            if (wide->children[b] && !collect(wide->children[b], ids, limit))
+                return false;
+        }
+        return true;
+    }
+    }
+}
+
+vector<int> Trie::startsWith(const string& prefix, size_t limit) const {
+    vector<int> ids;
     TrieNode* node = root;
-    for (char c : word) {
-        if (!node->children[c - 'a'])
-            return false;
-        node = node->children[c - 'a'];
+    size_t depth = 0;
+    while (node) {
+        if (node->type == TRIE_LEAF) {
+            if (leafMatches((const TrieLeaf*)node, prefix, true))
+                collect(node, ids, limit);
+            break;
+        }
+        const TrieInner* inner = (const TrieInner*)node;
+        if (inner->prefixLength) {
+            size_t match = prefixMismatch(inner, prefix, depth);
+            if (depth + match == prefix.size()) {
+                collect(node, ids, limit);
+                break;
+            }
+            if (match < inner->prefixLength)
+                break;
+            depth += inner->prefixLength;
+        }
+        if (depth == prefix.size()) {
+            collect(node, ids, limit);
+            break;
+        }
+        TrieNode** child = findChild(node, prefix[depth]);
+        node = child ? *child : nullptr;
+        depth++;
     }
-    return node->isEnd;
+    return ids;
+}
+
+int Trie::size() const {
+    return keyCount;
 }
@@ -1,18 +1,110 @@
 #ifndef TRIE_H
 #define TRIE_H
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Adaptive radix tree (ART) over arbitrary byte strings.
+//
+// Inner nodes come in four sizes (4, 16, 48 and 256 children) and grow or
+// shrink as children come and go. Single-child chains are compressed into the
+// node's prefix; only the first TRIE_MAX_PREFIX bytes are stored, the rest are
+// checked against a leaf, which always holds the full key. A key that ends at
+// an inner node hangs off that node's terminal leaf.
+enum TrieNodeType : uint8_t {
+    TRIE_LEAF,
+    TRIE_NODE4,
+    TRIE_NODE16,
+    TRIE_NODE48,
+    TRIE_NODE256
+};
+
+const uint32_t TRIE_MAX_PREFIX = 8;
+
 struct TrieNode {
-    TrieNode* children[26];
-    bool isEnd;
+    TrieNodeType type;
 };
 
+// A leaf is allocated with its key bytes stored directly after the struct.
+struct TrieLeaf : TrieNode {
+    uint32_t keyLength;
+    int id;
+    uint32_t idCount;
+    vector<int>* moreIds;  // IDs after the first, allocated only for shared names
+
+    const char* key() const { return (const char*)(this + 1); }
+};
+
+struct TrieInner : TrieNode {
+    uint16_t childCount;
+    uint32_t prefixLength;
+    unsigned char prefix[TRIE_MAX_PREFIX];
+    TrieLeaf* terminal;
+};
+
+// Node4/Node16 keep their key bytes sorted; Node48 maps a byte to slot + 1.
+struct TrieNode4 : TrieInner {
+    unsigned char keys[4];
+    TrieNode* children[4];
+};
+
+struct TrieNode16 : TrieInner {
+    unsigned char keys[16];
+    TrieNode* children[16];
+};
+
+struct TrieNode48 : TrieInner {
+    unsigned char childIndex[256];
+    TrieNode* children[48];
+};
+
+struct TrieNode256 : TrieInner {
+    TrieNode* children[256];
+};
+
+// Maps task names to task IDs. Several tasks may share a name.
 class Trie {
 private:
     TrieNode* root;
+    int keyCount;
+
+    static TrieLeaf* newLeaf(const string& key, int id);
+    static void freeLeaf(TrieLeaf* leaf);
+    static bool leafMatches(const TrieLeaf* leaf, const string& key, bool prefixOnly = false);
+    static void addId(TrieLeaf* leaf, int id);
+    static bool removeId(TrieLeaf* leaf, int id);
+    static void destroy(TrieNode* node);
+    static TrieNode** findChild(TrieNode* node, unsigned char byte);
+    static void addChild(TrieNode*& ref, unsigned char byte, TrieNode* child);
+    static void removeChild(TrieNode*& ref, unsigned char byte);
+    static void collapse(TrieNode*& ref);
+    static void attach(TrieNode*& ref, TrieLeaf* leaf, size_t depth);
+    static const TrieLeaf* minimumLeaf(const TrieNode* node);
+    static bool storedPrefixMatches(const TrieInner* node, const string& key, size_t depth);
+    static size_t prefixMismatch(const TrieInner* node, const string& key, size_t depth);
+    static bool collect(const TrieNode* node, vector<int>& ids, size_t limit);
+    bool insertAt(TrieNode*& ref, const string& key, size_t depth, int id);
+    bool eraseAt(TrieNode*& ref, const string& key, size_t depth, int id);
+    const TrieLeaf* findLeaf(const string& key) const;
+
 public:
     Trie();
-    void insert(string word);
-    bool search(string word);
+    ~Trie();
+    Trie(const Trie&) = delete;
+    Trie& operator=(const Trie&) = delete;
+
+    void insert(const string& word, int id);
+    // Removes one ID from word; returns false if it was not indexed under it.
+    bool erase(const string& word, int id);
+    bool search(const string& word) const;
+    vector<int> find(const string& word) const;
+    // IDs of every name starting with prefix, in name order; limit 0 means all.
+    vector<int> startsWith(const string& prefix, size_t limit = 0) const;
+    // Number of distinct names.
+    int size() const;
 };
 
 #endif
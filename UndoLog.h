@@ -0,0 +1,345 @@
+#ifndef UNDOLOG_H
+#define UNDOLOG_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "Task.h"
+#include "StringPool.h"
+
+enum UndoAction : uint8_t
+{
+    UNDO_CREATED,   // the task was added; reverting deletes it
+    UNDO_REMOVED,   // the task was deleted; the record holds its full state
+    UNDO_MODIFIED   // the record holds the old values of the changed fields
+};
+
+enum UndoField : uint8_t
+{
+    FIELD_NAME = 1,
+    FIELD_DESCRIPTION = 2,
+    FIELD_STATUS = 4,
+    FIELD_PRIORITY = 8,
+    FIELD_DUE_DATE = 16,
+    FIELD_CREATION_DATE = 32,
+    FIELD_COMPLETION_DATE = 64,
+    FIELD_ALL = 127,
+    FIELD_COUNT = 128   // batch record, see UndoLog::pushBatch
+};
+
+// Decoded entry. Only the fields named in `fields` are meaningful; name and
+// description are SharedString tokens.
+struct UndoRecord
+{
+    UndoAction action;
+    uint8_t fields;
+    int taskId;
+    uintptr_t name;
+    uintptr_t description;
+    TaskStatus status;
+    int priority;
+    time_t dueDate;
+    time_t creationDate;
+    time_t completionDate;
+    int count;
+};
+
+// Fields an edit to (name, description, status, priority, dueDate) would change.
+inline uint8_t changedFields(const Task& task, string_view name, string_view description, TaskStatus status, int priority, time_t dueDate)
+{
+    uint8_t fields = 0;
+    if (task.taskName != name) fields |= FIELD_NAME;
+    if (task.taskDescription != description) fields |= FIELD_DESCRIPTION;
+    if (task.taskStatus != status) fields |= FIELD_STATUS | FIELD_COMPLETION_DATE;
+    if (task.taskPriority != priority) fields |= FIELD_PRIORITY;
+    if (task.taskDueDate != dueDate) fields |= FIELD_DUE_DATE;
+    return fields;
+}
+
+// Undo and redo history as two stacks of delta-encoded records, each in its own
+// contiguous byte ring:
+//   [u16 length][u8 action][u8 fields][i32 taskId][changed fields...][u16 length]
+// The leading length lets the oldest record be evicted from the tail, the
+// trailing one lets the newest be popped from the head. Strings are stored as
+// SharedString tokens holding a reference, so an edit that leaves the name
+// alone stores nothing for it and a stored name shares the task's text.
+//
+// The rings, plus the text the records reference, are held under a byte budget: the
+// oldest undo records (then the oldest redo records) are evicted to make
+// room. Rings grow by doubling up to the budget, so pushes and pops do not
+// allocate per record.
+class UndoLog
+{
+    public:
+        enum Side
+        {
+            UNDO,
+            REDO
+        };
+    private:
+        static const size_t MAX_RECORD = 2 + 2 + 4 + 2 * sizeof(uintptr_t) + 1 + 4 + 3 * 8 + 4 + 2;
+        struct Ring
+        {
+            vector<unsigned char> bytes;
+            size_t head;    // one past the newest record
+            size_t tail;    // start of the oldest record
+            size_t used;
+            int count;
+        };
+        Ring rings[2];
+        size_t stringBytes; // text referenced by records, counted per reference
+        size_t budget;
+        uintptr_t held[2];  // string references of the last popped record
+        int heldCount;
+
+        static void copyIn(Ring& ring, size_t at, const void* data, size_t length)
+        {
+            size_t capacity = ring.bytes.size();
+            at %= capacity;
+            size_t first = min(length, capacity - at);
+            memcpy(&ring.bytes[at], data, first);
+            memcpy(&ring.bytes[0], (const unsigned char*)data + first, length - first);
+        }
+        static void copyOut(const Ring& ring, size_t at, void* data, size_t length)
+        {
+            size_t capacity = ring.bytes.size();
+            at %= capacity;
+            size_t first = min(length, capacity - at);
+            memcpy(data, &ring.bytes[at], first);
+            memcpy((unsigned char*)data + first, &ring.bytes[0], length - first);
+        }
+        template <typename T>
+        static void put(unsigned char*& out, T value)
+        {
+            memcpy(out, &value, sizeof(T));
+            out += sizeof(T);
+        }
+        template <typename T>
+        static T take(const unsigned char*& in)
+        {
+            T value;
+            memcpy(&value, in, sizeof(T));
+            in += sizeof(T);
+            return value;
+        }
+        // Fields the record does not carry are left zero.
+        static void decode(const unsigned char* in, UndoRecord& record)
+        {
+            record = UndoRecord{};
+            in += 2;
+            record.action = (UndoAction)take<uint8_t>(in);
+            record.fields = take<uint8_t>(in);
+            record.taskId = take<int32_t>(in);
+            if (record.fields & FIELD_NAME) record.name = take<uintptr_t>(in);
+            if (record.fields & FIELD_DESCRIPTION) record.description = take<uintptr_t>(in);
+            if (record.fields & FIELD_STATUS) record.status = (TaskStatus)take<uint8_t>(in);
+            if (record.fields & FIELD_PRIORITY) record.priority = take<int32_t>(in);
+            if (record.fields & FIELD_DUE_DATE) record.dueDate = take<int64_t>(in);
+            if (record.fields & FIELD_CREATION_DATE) record.creationDate = take<int64_t>(in);
+            if (record.fields & FIELD_COMPLETION_DATE) record.completionDate = take<int64_t>(in);
+            if (record.fields & FIELD_COUNT) record.count = take<int32_t>(in);
+        }
+        uintptr_t retain(const SharedString& text)
+        {
+            SharedString::retainToken(text.token());
+            stringBytes += text.size();
+            return text.token();
+        }
+        void release(uintptr_t token)
+        {
+            stringBytes -= SharedString::tokenLength(token);
+            SharedString::releaseToken(token);
+        }
+        void releaseStrings(const UndoRecord& record)
+        {
+            if (record.fields & FIELD_NAME) release(record.name);
+            if (record.fields & FIELD_DESCRIPTION) release(record.description);
+        }
+        void releaseHeld()
+        {
+            for (int i = 0; i < heldCount; i++)
+                release(held[i]);
+            heldCount = 0;
+        }
+        void evictOldest(Ring& ring)
+        {
+            unsigned char buffer[MAX_RECORD];
+            uint16_t length;
+            copyOut(ring, ring.tail, &length, 2);
+            copyOut(ring, ring.tail, buffer, length);
+            UndoRecord record;
+            decode(buffer, record);
+            releaseStrings(record);
+            ring.tail = (ring.tail + length) % ring.bytes.size();
+            ring.used -= length;
+            ring.count--;
+        }
+        size_t footprint() const
+        {
+            return rings[UNDO].bytes.size() + rings[REDO].bytes.size() + stringBytes;
+        }
+        // Makes room for length more bytes in ring, growing it while the budget
+        // allows and evicting its oldest records otherwise.
+        void reserve(Ring& ring, size_t length)
+        {
+            while (ring.used + length > ring.bytes.size())
+            {
+                size_t capacity = ring.bytes.size();
+                size_t grown = capacity ? capacity * 2 : 256;
+                if (capacity == 0 || footprint() + grown - capacity <= budget)
+                {
+                    vector<unsigned char> bytes(grown);
+                    if (ring.used)
+                        copyOut(ring, ring.tail, bytes.data(), ring.used);
+                    ring.bytes.swap(bytes);
+                    ring.tail = 0;
+                    ring.head = ring.used;
+                }
+                else
+                {
+                    evictOldest(ring);
+                }
+            }
+        }
+        // Frames the body written between buffer + 2 and out and pushes it onto a side.
+        void store(Side side, unsigned char* buffer, unsigned char* out)
+        {
+            uint16_t length = out - buffer + 2;
+            memcpy(buffer, &length, 2);
+            put<uint16_t>(out, length);
+
+            Ring& ring = rings[side];
+            reserve(ring, length);
+            copyIn(ring, ring.head, buffer, length);
+            ring.head = (ring.head + length) % ring.bytes.size();
+            ring.used += length;
+            ring.count++;
+            enforceBudget();
+        }
+        void enforceBudget()
+        {
+            while (footprint() > budget && (rings[UNDO].count > 1 || rings[REDO].count > 0))
+                evictOldest(rings[UNDO].count > 1 ? rings[UNDO] : rings[REDO]);
+        }
+    public:
+        explicit UndoLog(size_t budgetBytes = 1 << 20) : stringBytes(0), budget(budgetBytes), heldCount(0)
+        {
+            for (Ring& ring : rings)
+            {
+                ring.head = 0;
+                ring.tail = 0;
+                ring.used = 0;
+                ring.count = 0;
+            }
+        }
+        ~UndoLog()
+        {
+            clear();
+        }
+        UndoLog(const UndoLog&) = delete;
+        UndoLog& operator=(const UndoLog&) = delete;
+
+        // A new user edit: records how to revert it and drops the redo history.
+        void record(UndoAction action, const Task& task, uint8_t fields)
+        {
+            clearSide(REDO);
+            push(UNDO, action, task, fields);
+        }
+        // Encodes the given fields of task onto one side.
+        void push(Side side, UndoAction action, const Task& task, uint8_t fields)
+        {
+            unsigned char buffer[MAX_RECORD];
+            unsigned char* out = buffer + 2;
+            put<uint8_t>(out, action);
+            put<uint8_t>(out, fields);
+            put<int32_t>(out, task.taskId);
+            if (fields & FIELD_NAME) put<uintptr_t>(out, retain(task.taskName));
+            if (fields & FIELD_DESCRIPTION) put<uintptr_t>(out, retain(task.taskDescription));
+            if (fields & FIELD_STATUS) put<uint8_t>(out, task.taskStatus);
+            if (fields & FIELD_PRIORITY) put<int32_t>(out, task.taskPriority);
+            if (fields & FIELD_DUE_DATE) put<int64_t>(out, task.taskDueDate);
+            if (fields & FIELD_CREATION_DATE) put<int64_t>(out, task.taskCreationDate);
+            if (fields & FIELD_COMPLETION_DATE) put<int64_t>(out, task.taskCompletionDate);
+            store(side, buffer, out);
+        }
+        // A new batch edit covering count tasks from firstTaskId on; drops the redo history.
+        void recordBatch(UndoAction action, int firstTaskId, int count)
+        {
+            clearSide(REDO);
+            pushBatch(UNDO, action, firstTaskId, count);
+        }
+        // Batch records undo a whole addTasks() call as one step:
+        //   UNDO_CREATED: tasks firstTaskId .. firstTaskId + count - 1 were added.
+        //   UNDO_REMOVED: the count records beneath this one (FIELD_ALL removals)
+        //                 belong to the same step. Eviction may have dropped the
+        //                 oldest of them, so callers pop until the side runs out.
+        void pushBatch(Side side, UndoAction action, int firstTaskId, int count)
+        {
+            unsigned char buffer[MAX_RECORD];
+            unsigned char* out = buffer + 2;
+            put<uint8_t>(out, action);
+            put<uint8_t>(out, FIELD_COUNT);
+            put<int32_t>(out, firstTaskId);
+            put<int32_t>(out, count);
+            store(side, buffer, out);
+        }
+        // Takes the newest record off a side. Its strings stay valid until the
+        // next pop or clear.
+        bool pop(Side side, UndoRecord& record)
+        {
+            releaseHeld();
+            Ring& ring = rings[side];
+            if (ring.count == 0) return false;
+            size_t capacity = ring.bytes.size();
+            uint16_t length;
+            copyOut(ring, ring.head + capacity - 2, &length, 2);
+            size_t start = (ring.head + capacity - length) % capacity;
+            unsigned char buffer[MAX_RECORD];
+            copyOut(ring, start, buffer, length);
+            decode(buffer, record);
+            if (record.fields & FIELD_NAME) held[heldCount++] = record.name;
+            if (record.fields & FIELD_DESCRIPTION) held[heldCount++] = record.description;
+            ring.head = start;
+            ring.used -= length;
+            ring.count--;
+            return true;
+        }
+        // Copies the record's fields onto task.
+        void apply(const UndoRecord& record, Task& task) const
+        {
+            if (record.fields & FIELD_NAME) task.taskName = SharedString::fromToken(record.name);
+            if (record.fields & FIELD_DESCRIPTION) task.taskDescription = SharedString::fromToken(record.description);
+            if (record.fields & FIELD_STATUS) task.taskStatus = record.status;
+            if (record.fields & FIELD_PRIORITY) task.taskPriority = record.priority;
+            if (record.fields & FIELD_DUE_DATE) task.taskDueDate = record.dueDate;
+            if (record.fields & FIELD_CREATION_DATE) task.taskCreationDate = record.creationDate;
+            if (record.fields & FIELD_COMPLETION_DATE) task.taskCompletionDate = record.completionDate;
+        }
+        bool isEmpty(Side side) const
+        {
+            return rings[side].count == 0;
+        }
+        int size(Side side) const
+        {
+            return rings[side].count;
+        }
+        size_t memoryUsage() const
+        {
+            return footprint();
+        }
+        void clearSide(Side side)
+        {
+            while (rings[side].count > 0)
+                evictOldest(rings[side]);
+            rings[side].head = rings[side].tail = 0;
+        }
+        void clear()
+        {
+            releaseHeld();
+            clearSide(UNDO);
+            clearSide(REDO);
+        }
+};
+
+#endif
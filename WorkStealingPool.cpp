@@ -0,0 +1,100 @@
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+WorkStealingPool::WorkStealingPool(int threadCount) {
+    threads = threadCount > 0 ? threadCount : (int)thread::hardware_concurrency();
+    if (threads < 1)
+        threads = 1;
+    for (int i = 0; i < threads; i++)
+        queues.push_back(unique_ptr<RunQueue>(new RunQueue()));
+    active = 0;
+    queuedJobs = 0;
+    sequence = 0;
+}
+
+int WorkStealingPool::threadCount() const {
+    return threads;
+}
+
+// Heap comparator: true when a should run after b.
+bool WorkStealingPool::runsAfter(const Job& a, const Job& b) {
+    if (a.priority != b.priority)
+        return a.priority > b.priority;
+    return a.sequence > b.sequence;
+}
+
+void WorkStealingPool::push(int worker, int jobId, int priority) {
+    RunQueue& queue = *queues[worker];
+    {
+        lock_guard<mutex> guard(queue.lock);
+        queue.heap.push_back(Job{priority, sequence++, jobId});
+        push_heap(queue.heap.begin(), queue.heap.end(), runsAfter);
+    }
+    queuedJobs++;
+    idle.notify_one();
+}
+
+bool WorkStealingPool::pop(int worker, Job& job) {
+    RunQueue& queue = *queues[worker];
+    lock_guard<mutex> guard(queue.lock);
+    if (queue.heap.empty())
+        return false;
+    pop_heap(queue.heap.begin(), queue.heap.end(), runsAfter);
+    job = queue.heap.back();
+    queue.heap.pop_back();
+    queuedJobs--;
+    return true;
+}
+
+bool WorkStealingPool::steal(int thief, Job& job) {
+    for (int offset = 1; offset < threads; offset++) {
+        if (pop((thief + offset) % threads, job))
+            return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::spawn(int worker, int jobId, int priority) {
+    active++;
+    push(worker, jobId, priority);
+}
+
+void WorkStealingPool::workerLoop(int worker, const Handler& handler) {
+    while (true) {
+        Job job;
+        if (pop(worker, job) || steal(worker, job)) {
+            handler(job.id, worker);
+            // Spawned jobs were counted before this one is released, so active
+            // only reaches zero once the whole batch is done.
+            if (--active == 0)
+                idle.notify_all();
+            continue;
+        }
+        if (active == 0)
+            return;
+        unique_lock<mutex> guard(idleLock);
+        idle.wait_for(guard, chrono::milliseconds(1), [this] { return active == 0 || queuedJobs > 0; });
+    }
+}
+
+void WorkStealingPool::run(const vector<pair<int, int>>& initial, const Handler& handler) {
+    if (initial.empty())
+        return;
+    // Deal the most urgent jobs out first so every worker starts near the top.
+    vector<pair<int, int>> ordered(initial);
+    stable_sort(ordered.begin(), ordered.end(), [](const pair<int, int>& a, const pair<int, int>& b) {
+        return a.second < b.second;
+    });
+    active = ordered.size();
+    for (size_t i = 0; i < ordered.size(); i++)
+        push(i % threads, ordered[i].first, ordered[i].second);
+
+    vector<thread> workers;
+    for (int i = 1; i < threads; i++)
+        workers.push_back(thread(&WorkStealingPool::workerLoop, this, i, cref(handler)));
+    workerLoop(0, handler);
+    for (thread& worker : workers)
+        worker.join();
+}
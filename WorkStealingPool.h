@@ -0,0 +1,55 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+// Runs a batch of jobs on a fixed set of worker threads. Each worker owns a run
+// queue ordered like Heap (lowest priority value first, FIFO among equals);
+// follow-up jobs spawned by a handler go to the calling worker's queue, and an
+// idle worker steals the most urgent job from another worker's queue.
+class WorkStealingPool {
+public:
+    // handler(jobId, worker) runs one job and must not throw; it may call
+    // spawn(worker, ...) to queue more.
+    typedef function<void(int, int)> Handler;
+
+    explicit WorkStealingPool(int threads = 0);
+    int threadCount() const;
+    // Runs the initial (jobId, priority) jobs and everything they spawn, returning
+    // once no job is queued or running.
+    void run(const vector<pair<int, int>>& initial, const Handler& handler);
+    void spawn(int worker, int jobId, int priority);
+
+private:
+    struct Job {
+        int priority;
+        long long sequence;
+        int id;
+    };
+    struct RunQueue {
+        mutex lock;
+        vector<Job> heap;
+    };
+    int threads;
+    vector<unique_ptr<RunQueue>> queues;
+    atomic<long long> active;
+    atomic<long long> queuedJobs;
+    atomic<long long> sequence;
+    mutex idleLock;
+    condition_variable idle;
+
+    static bool runsAfter(const Job& a, const Job& b);
+    void push(int worker, int jobId, int priority);
+    bool pop(int worker, Job& job);
+    bool steal(int thief, Job& job);
+    void workerLoop(int worker, const Handler& handler);
+};
+
+#endif
@@ -0,0 +1,120 @@
+// Throughput of ConcurrentScheduler (strict and relaxed queues) against one
+// TaskScheduler-style structure behind a single global mutex, for 1..N threads.
+// Every thread alternates addTask and pop, so half the operations are producers
+// and half consumers. The last column repeats the relaxed run with one more
+// thread iterating snapshots of every task the whole time, to show that
+// listings do not hold writers up.
+//
+//   g++ -std=c++17 -O2 -pthread -I. bench/ConcurrentSchedulerBench.cpp -o concurrent_bench
+//   ./concurrent_bench [max-threads] [ops-per-thread]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ConcurrentScheduler.h"
+#include "PriorityQueue.h"
+#include "TaskHashMap.h"
+#include "TaskStore.h"
+
+// Baseline: the single-threaded containers with one lock around every call.
+class GlobalLockScheduler
+{
+    private:
+        mutex lock;
+        TaskStore taskStore;
+        TaskHashMap taskLookup;
+        PriorityQueue priorityQueue;
+        int nextTaskId;
+    public:
+        GlobalLockScheduler() : nextTaskId(1) {}
+        int addTask(const string& name, const string& description, TaskStatus status, int priority, time_t dueDate)
+        {
+            lock_guard<mutex> guard(lock);
+            int id = nextTaskId++;
+            Task* task = taskStore.add(Task(id, name, description, status, priority, dueDate));
+            taskLookup.insertTask(task);
+            if (status == PENDING)
+                priorityQueue.insert(task);
+            return id;
+        }
+        bool pop(Task& out)
+        {
+            lock_guard<mutex> guard(lock);
+            if (priorityQueue.isEmpty()) return false;
+            Task* task = priorityQueue.pop();
+            task->taskStatus = IN_PROGRESS;
+            out = *task;
+            return true;
+        }
+};
+
+// Iterates snapshots of scheduler until stop is set. Returns the sum of the
+// priorities seen, so the scans cannot be optimized away.
+long long scanSnapshots(const ConcurrentScheduler& scheduler, const atomic<bool>& stop)
+{
+    long long seen = 0;
+    while (!stop.load(memory_order_relaxed))
+    {
+        ConcurrentScheduler::Snapshot snapshot = scheduler.snapshot();
+        snapshot.forEach([&](const Task& task) { seen += task.taskPriority; });
+    }
+    return seen;
+}
+
+template <typename Scheduler>
+double runBench(Scheduler& scheduler, int threads, int opsPerThread)
+{
+    typedef chrono::steady_clock Clock;
+    // Preload so early pops have something to take.
+    for (int i = 0; i < 1000; i++)
+        scheduler.addTask("task", "", PENDING, i % 5 + 1, 0);
+
+    vector<thread> workers;
+    Clock::time_point start = Clock::now();
+    for (int t = 0; t < threads; t++)
+    {
+        workers.push_back(thread([&scheduler, opsPerThread, t]() {
+            Task task;
+            for (int i = 0; i < opsPerThread; i += 2)
+            {
+                scheduler.addTask("task", "", PENDING, (i + t) % 5 + 1, 0);
+                scheduler.pop(task);
+            }
+        }));
+    }
+    for (thread& worker : workers)
+        worker.join();
+    Clock::time_point end = Clock::now();
+    return threads * (double)opsPerThread / chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+    int maxThreads = argc > 1 ? atoi(argv[1]) : (int)max(1u, thread::hardware_concurrency());
+    int ops = argc > 2 ? atoi(argv[2]) : 200000;
+
+    printf("%-8s %16s %16s %16s %18s\n", "threads", "global ops/s", "strict ops/s", "relaxed ops/s", "relaxed+scan ops/s");
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        GlobalLockScheduler global;
+        ConcurrentScheduler strict(ConcurrentScheduler::STRICT);
+        ConcurrentScheduler relaxed(ConcurrentScheduler::RELAXED);
+        double globalRate = runBench(global, threads, ops);
+        double strictRate = runBench(strict, threads, ops);
+        double relaxedRate = runBench(relaxed, threads, ops);
+        ConcurrentScheduler scanned(ConcurrentScheduler::RELAXED);
+        atomic<bool> stop(false);
+        long long checksum = 0;
+        thread scanner([&]() { checksum = scanSnapshots(scanned, stop); });
+        double scannedRate = runBench(scanned, threads, ops);
+        stop.store(true);
+        scanner.join();
+        printf("%-8d %16.0f %16.0f %16.0f %18.0f\n", threads, globalRate, strictRate, relaxedRate, scannedRate);
+        if (threads < maxThreads && threads * 2 > maxThreads)
+            threads = maxThreads / 2;
+    }
+    return 0;
+}
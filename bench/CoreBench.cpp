@@ -0,0 +1,302 @@
+// Per-operation cost of the core data structures at 1e2 - 1e7 elements:
+// Heap, PriorityQueue, TaskHashMap, Trie and the snapshot save/load path used
+// by main2's saveTasks/loadTasks. Results are written to stdout as JSON, one
+// entry per (benchmark, size), with ns/op and heap allocations/op, so runs of
+// different versions can be diffed.
+//
+//   cmake --build build --target core_bench
+//   ./core_bench [max-size] [filter] > results.json
+//
+// filter keeps the benchmarks whose name contains it, e.g. "trie/".
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include "Heap.h"
+#include "PriorityQueue.h"
+#include "TaskHashMap.h"
+#include "TaskSnapshot.h"
+#include "Trie.h"
+
+// Every global operator new and delete goes through these two so allocations
+// can be counted. countedFree stays out of line: inlined into the replaced
+// operator delete[], GCC's -Wuse-after-free misfires on it.
+static atomic<long long> allocationCount(0);
+
+static void* countedAllocate(size_t size)
+{
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
+__attribute__((noinline)) static void countedFree(void* p) noexcept
+{
+    free(p);
+}
+
+void* operator new(size_t size)
+{
+    return countedAllocate(size);
+}
+void* operator new[](size_t size)
+{
+    return countedAllocate(size);
+}
+void operator delete(void* p) noexcept
+{
+    countedFree(p);
+}
+void operator delete[](void* p) noexcept
+{
+    countedFree(p);
+}
+void operator delete(void* p, size_t) noexcept
+{
+    countedFree(p);
+}
+void operator delete[](void* p, size_t) noexcept
+{
+    countedFree(p);
+}
+
+// Keeps results alive so the optimizer cannot drop the measured loops.
+static volatile long long sink;
+
+// Accumulates time and allocations over the measured parts of each repetition;
+// setup and teardown happen outside start()/stop().
+class Timer
+{
+    private:
+        chrono::steady_clock::time_point started;
+        long long allocationsAtStart;
+    public:
+        double nanoseconds = 0;
+        long long allocations = 0;
+        void start()
+        {
+            allocationsAtStart = allocationCount.load(memory_order_relaxed);
+            started = chrono::steady_clock::now();
+        }
+        void stop()
+        {
+            nanoseconds += chrono::duration<double, nano>(chrono::steady_clock::now() - started).count();
+            allocations += allocationCount.load(memory_order_relaxed) - allocationsAtStart;
+        }
+};
+
+// Input shared by every benchmark at one size.
+struct Workload
+{
+    vector<Task> tasks;
+    vector<int> shuffledIds;
+    vector<string> names;
+    vector<int> newPriorities;
+
+    explicit Workload(int n)
+    {
+        mt19937 rng(n);
+        time_t now = time(0);
+        tasks.reserve(n);
+        names.reserve(n);
+        for (int i = 0; i < n; i++)
+        {
+            string name = "task " + to_string(rng() % 100000000);
+            tasks.push_back(Task(i + 1, name, "benchmark task", PENDING, rng() % 10 + 1, now + rng() % (30 * 86400)));
+            names.push_back(name);
+            shuffledIds.push_back(i + 1);
+            newPriorities.push_back(rng() % 10 + 1);
+        }
+        shuffle(shuffledIds.begin(), shuffledIds.end(), rng);
+    }
+};
+
+static bool firstResult = true;
+
+// Repeats body until about 200 ms have been measured (at least once) and prints
+// one JSON entry. body(timer) returns the number of operations it timed.
+template <typename Body>
+void run(const char* name, const char* filter, int n, Body body)
+{
+    if (filter && !strstr(name, filter)) return;
+    Timer timer;
+    long long ops = 0;
+    int iterations = 0;
+    do
+    {
+        ops += body(timer);
+        iterations++;
+    } while (timer.nanoseconds < 2e8 && iterations < 1000);
+    printf("%s\n    {\"name\": \"%s\", \"size\": %d, \"iterations\": %d, \"ops\": %lld, \"ns_per_op\": %.2f, \"allocs_per_op\": %.3f}",
+        firstResult ? "" : ",", name, n, iterations, ops, timer.nanoseconds / ops, (double)timer.allocations / ops);
+    firstResult = false;
+    fflush(stdout);
+}
+
+void benchSize(int n, const char* filter, const string& snapshotPath)
+{
+    Workload work(n);
+    vector<Task>& tasks = work.tasks;
+
+    run("heap/insert", filter, n, [&](Timer& timer) {
+        Heap heap;
+        timer.start();
+        for (int i = 0; i < n; i++)
+            heap.insert(work.names[i], tasks[i].taskPriority, tasks[i].taskId);
+        timer.stop();
+        return (long long)n;
+    });
+    run("heap/extractTop", filter, n, [&](Timer& timer) {
+        Heap heap;
+        for (int i = 0; i < n; i++)
+            heap.insert(work.names[i], tasks[i].taskPriority, tasks[i].taskId);
+        timer.start();
+        while (!heap.isEmpty())
+            sink += heap.extractTop().size();
+        timer.stop();
+        return (long long)n;
+    });
+
+    run("priority_queue/insert", filter, n, [&](Timer& timer) {
+        PriorityQueue queue(n);
+        timer.start();
+        for (Task& task : tasks)
+            queue.insert(&task);
+        timer.stop();
+        return (long long)n;
+    });
+    // What addTasks() does to the queue: one bottom-up (Floyd) heap build.
+    run("priority_queue/insertAll", filter, n, [&](Timer& timer) {
+        vector<Task*> batch;
+        for (Task& task : tasks)
+            batch.push_back(&task);
+        PriorityQueue queue(n);
+        timer.start();
+        queue.insertAll(batch.data(), batch.size());
+        timer.stop();
+        return (long long)n;
+    });
+    run("priority_queue/pop", filter, n, [&](Timer& timer) {
+        PriorityQueue queue(n);
+        for (Task& task : tasks)
+            queue.insert(&task);
+        timer.start();
+        while (Task* task = queue.pop())
+            sink += task->taskId;
+        timer.stop();
+        return (long long)n;
+    });
+    run("priority_queue/remove", filter, n, [&](Timer& timer) {
+        PriorityQueue queue(n);
+        for (Task& task : tasks)
+            queue.insert(&task);
+        timer.start();
+        for (int id : work.shuffledIds)
+            sink += queue.removeTask(id);
+        timer.stop();
+        return (long long)n;
+    });
+    run("priority_queue/update", filter, n, [&](Timer& timer) {
+        PriorityQueue queue(n);
+        for (Task& task : tasks)
+            queue.insert(&task);
+        timer.start();
+        for (int i = 0; i < n; i++)
+        {
+            Task& task = tasks[work.shuffledIds[i] - 1];
+            task.taskPriority = work.newPriorities[i];
+            queue.updateTask(&task);
+        }
+        timer.stop();
+        return (long long)n;
+    });
+
+    run("task_hash_map/lookup", filter, n, [&](Timer& timer) {
+        TaskHashMap lookup;
+        for (Task& task : tasks)
+            lookup.insertTask(&task);
+        timer.start();
+        for (int id : work.shuffledIds)
+            sink += lookup.getTaskByID(id)->taskPriority;
+        timer.stop();
+        return (long long)n;
+    });
+
+    run("trie/insert", filter, n, [&](Timer& timer) {
+        Trie trie;
+        timer.start();
+        for (int i = 0; i < n; i++)
+            trie.insert(work.names[i], tasks[i].taskId);
+        timer.stop();
+        return (long long)n;
+    });
+    run("trie/search", filter, n, [&](Timer& timer) {
+        Trie trie;
+        for (int i = 0; i < n; i++)
+            trie.insert(work.names[i], tasks[i].taskId);
+        timer.start();
+        for (int id : work.shuffledIds)
+            sink += trie.search(work.names[id - 1]);
+        timer.stop();
+        return (long long)n;
+    });
+
+    // The work saveTasks() and loadSnapshot() do, minus the scheduler indexes.
+    run("snapshot/save", filter, n, [&](Timer& timer) {
+        string error;
+        timer.start();
+        TaskSnapshotWriter writer;
+        writer.reserve(n);
+        for (Task& task : tasks)
+            writer.add(task);
+        bool ok = writer.write(snapshotPath, n + 1, error);
+        timer.stop();
+        if (!ok)
+        {
+            fprintf(stderr, "snapshot/save: %s\n", error.c_str());
+            exit(1);
+        }
+        return (long long)n;
+    });
+    run("snapshot/load", filter, n, [&](Timer& timer) {
+        string error;
+        Task task;
+        timer.start();
+        TaskSnapshotReader reader;
+        bool ok = reader.open(snapshotPath, error) && reader.verify(error);
+        for (uint32_t i = 0; ok && i < reader.taskCount(); i++)
+        {
+            reader.readTask(i, task);
+            sink += task.taskPriority;
+        }
+        timer.stop();
+        if (!ok)
+        {
+            fprintf(stderr, "snapshot/load: %s\n", error.c_str());
+            exit(1);
+        }
+        return (long long)n;
+    });
+    remove(snapshotPath.c_str());
+}
+
+int main(int argc, char* argv[])
+{
+    long long maxSize = argc > 1 ? atof(argv[1]) : 1e7;
+    const char* filter = argc > 2 ? argv[2] : nullptr;
+    const char* tmp = getenv("TMPDIR");
+    string snapshotPath = string(tmp ? tmp : "/tmp") + "/core_bench.snapshot";
+
+    printf("{\n  \"benchmarks\": [");
+    for (long long n = 100; n <= maxSize; n *= 10)
+        benchSize((int)n, filter, snapshotPath);
+    printf("\n  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,162 @@
+// Compares the original scan + buildHeap PriorityQueue against the indexed one
+// for updateTask/removeTask at 10k - 1M queued tasks.
+//
+//   g++ -std=c++17 -O2 -I. bench/PriorityQueueBench.cpp -o pq_bench
+//   ./pq_bench [ops-per-size]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "PriorityQueue.h"
+
+// The PriorityQueue as it was before the position index: linear scan to find
+// the task, then a full buildHeap() on every update/remove.
+class ScanPriorityQueue
+{
+    private:
+        Task** heap;
+        int size;
+        int capacity;
+        void heapify(int i)
+        {
+            int largest = i;
+            int left = 2 * i + 1;
+            int right = 2 * i + 2;
+            if (left < size && heap[left]->taskPriority > heap[largest]->taskPriority)
+                largest = left;
+            if (right < size && heap[right]->taskPriority > heap[largest]->taskPriority)
+                largest = right;
+            if (largest != i)
+            {
+                Task* temp = heap[i];
+                heap[i] = heap[largest];
+                heap[largest] = temp;
+                heapify(largest);
+            }
+        }
+        void buildHeap()
+        {
+            for (int i = size / 2 - 1; i >= 0; i--)
+                heapify(i);
+        }
+    public:
+        ScanPriorityQueue(int cap) : size(0), capacity(cap)
+        {
+            heap = new Task*[capacity];
+        }
+        ~ScanPriorityQueue()
+        {
+            delete[] heap;
+        }
+        void insert(Task* task)
+        {
+            if (size >= capacity) return;
+            heap[size] = task;
+            int current = size++;
+            while (current > 0 && heap[(current - 1) / 2]->taskPriority < heap[current]->taskPriority)
+            {
+                Task* temp = heap[current];
+                heap[current] = heap[(current - 1) / 2];
+                heap[(current - 1) / 2] = temp;
+                current = (current - 1) / 2;
+            }
+        }
+        bool removeTask(int taskId)
+        {
+            int index = -1;
+            for (int i = 0; i < size; i++)
+            {
+                if (heap[i]->taskId == taskId)
+                {
+                    index = i;
+                    break;
+                }
+            }
+            if (index == -1) return false;
+            heap[index] = heap[size - 1];
+            size--;
+            buildHeap();
+            return true;
+        }
+        void updateTask(Task* task)
+        {
+            bool found = false;
+            for (int i = 0; i < size; i++)
+            {
+                if (heap[i]->taskId == task->taskId)
+                {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found)
+                insert(task);
+            else
+                buildHeap();
+        }
+};
+
+struct BenchResult
+{
+    double updateNs;
+    double removeNs;
+};
+
+// Fills the queue with n tasks, then times `ops` random priority changes
+// followed by `ops` removals of distinct tasks.
+template <typename Queue>
+BenchResult runBench(vector<Task>& tasks, int ops, unsigned seed)
+{
+    typedef chrono::steady_clock Clock;
+    int n = tasks.size();
+    Queue queue(n);
+    for (int i = 0; i < n; i++)
+        queue.insert(&tasks[i]);
+
+    mt19937 rng(seed);
+    vector<int> picks(ops);
+    for (int i = 0; i < ops; i++)
+        picks[i] = rng() % n;
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < ops; i++)
+    {
+        Task& task = tasks[picks[i]];
+        task.taskPriority = rng() % 1000;
+        queue.updateTask(&task);
+    }
+    Clock::time_point mid = Clock::now();
+    for (int i = 0; i < ops; i++)
+        queue.removeTask(tasks[(i * 7919LL) % n].taskId);
+    Clock::time_point end = Clock::now();
+
+    BenchResult result;
+    result.updateNs = chrono::duration<double, nano>(mid - start).count() / ops;
+    result.removeNs = chrono::duration<double, nano>(end - mid).count() / ops;
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    int ops = argc > 1 ? atoi(argv[1]) : 200;
+    const int sizes[] = { 10000, 100000, 1000000 };
+
+    printf("%-10s %-8s %14s %14s\n", "tasks", "queue", "update ns/op", "remove ns/op");
+    for (int n : sizes)
+    {
+        vector<Task> tasks;
+        tasks.reserve(n);
+        mt19937 rng(n);
+        for (int i = 0; i < n; i++)
+            tasks.push_back(Task(i + 1, "task", "", PENDING, rng() % 1000, 0));
+        vector<Task> copy = tasks;
+
+        BenchResult scan = runBench<ScanPriorityQueue>(tasks, ops, 42);
+        BenchResult indexed = runBench<PriorityQueue>(copy, ops, 42);
+        printf("%-10d %-8s %14.0f %14.0f\n", n, "scan", scan.updateNs, scan.removeNs);
+        printf("%-10d %-8s %14.0f %14.0f\n", n, "indexed", indexed.updateNs, indexed.removeNs);
+    }
+    return 0;
+}
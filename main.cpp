@@ -1,463 +1,243 @@
 #include <iostream>
 #include <string>
 #include <ctime>
+#include <algorithm>
+#include <vector>
+#include <fstream>
+#include "Task.h"
+#include "PriorityQueue.h"
+#include "TaskHashMap.h"
+#include "TaskStore.h"
+#include "StatusIndex.h"
+#include "TimingWheel.h"
+#include "UndoLog.h"
+#include "Metrics.h"
+#include "RecurrenceRules.h"
+#include "LeaseTable.h"
+#include "BatchMode.h"
 
 using namespace std;
 
-const int TABLE_SIZE = 10; 
-const int MAX_TASKS = 100; 
-
-enum TaskStatus 
-{
-    PENDING,
-    IN_PROGRESS,
-    COMPLETED
-};
-
-class Task 
-{
-    public:
-        int taskId;
-        string taskName;
-        string taskDescription;
-        TaskStatus taskStatus;
-        int taskPriority;
-        time_t taskDueDate;
-        time_t taskCreationDate;
-        time_t taskCompletionDate;
-        Task* next;  
-        Task() : taskId(-1), taskName(""), taskDescription(""), taskStatus(PENDING),
-            taskPriority(0), taskDueDate(0), taskCreationDate(0), taskCompletionDate(0), next(nullptr) {}
-        Task(int id, string name, string description, TaskStatus status, int priority, time_t dueDate)
-            : taskId(id), taskName(name), taskDescription(description), taskStatus(status),
-            taskPriority(priority), taskDueDate(dueDate), taskCreationDate(time(0)), taskCompletionDate(0), next(nullptr) {}
-        Task(const Task& other)
-            : taskId(other.taskId), taskName(other.taskName), taskDescription(other.taskDescription),
-            taskStatus(other.taskStatus), taskPriority(other.taskPriority), taskDueDate(other.taskDueDate),
-            taskCreationDate(other.taskCreationDate), taskCompletionDate(other.taskCompletionDate), next(nullptr) {}
-        Task& operator=(const Task& other) 
-        {
-            if (this != &other) 
-            {
-                taskId = other.taskId;
-                taskName = other.taskName;
-                taskDescription = other.taskDescription;
-                taskStatus = other.taskStatus;
-                taskPriority = other.taskPriority;
-                taskDueDate = other.taskDueDate;
-                taskCreationDate = other.taskCreationDate;
-                taskCompletionDate = other.taskCompletionDate;
-            }
-            return *this;
-        }
-        void completeTask() 
-        {
-            taskStatus = COMPLETED;
-            taskCompletionDate = time(0);
-        }
-        string formatTime(time_t t) const 
-        {
-            if (t == 0) return "N/A";
-            char buffer[20];
-            strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", localtime(&t));
-            return string(buffer);
-        }
-        void displayTask() const 
-        {
-            cout << "Task ID: " << taskId << endl;
-            cout << "Task Name: " << taskName << endl;
-            cout << "Task Description: " << taskDescription << endl;
-            cout << "Task Status: " << (taskStatus == PENDING ? "Pending" : (taskStatus == IN_PROGRESS ? "In Progress" : "Completed")) << endl;
-            cout << "Task Priority: " << taskPriority << endl;
-            cout << "Task Due Date: " << formatTime(taskDueDate) << endl;
-            cout << "Task Creation Date: " << formatTime(taskCreationDate) << endl;
-            if (taskCompletionDate != 0)
-                cout << "Task Completion Date: " << formatTime(taskCompletionDate) << endl;
-            cout << "------------------------" << endl;
-        }
-        bool isValid() const 
-        {
-            return taskId != -1;
-        }
-};
-
-class PriorityQueue 
+class TaskScheduler 
 {
     private:
-        Task** heap;
-        int size;
-        int capacity;
-        void heapify(int i) 
+        TaskStore taskStore;
+        int nextTaskId;
+        SchedulingQueue priorityQueue;
+        TaskHashMap taskLookup;   
+        StatusIndex statusIndex;
+        TimingWheel dueWheel;
+        UndoLog undoLog;
+        RecurrenceSchedule recurrence;
+        LeaseTable leases;
+        void recordForUndo(UndoAction action, const Task* task, uint8_t fields = 0) 
         {
-            int largest = i;
-            int left = 2 * i + 1;
-            int right = 2 * i + 2;
-            if (left < size && heap[left]->taskPriority > heap[largest]->taskPriority)
-                largest = left;
-            if (right < size && heap[right]->taskPriority > heap[largest]->taskPriority)
-                largest = right;
-            if (largest != i) 
+            if (task) 
             {
-                Task* temp = heap[i];
-                heap[i] = heap[largest];
-                heap[largest] = temp;
-                heapify(largest);
+                undoLog.record(action, *task, fields);
             }
         }
-        void buildHeap() 
+        void updateNextTaskId(int taskId) 
         {
-            for (int i = size / 2 - 1; i >= 0; i--)
-                heapify(i);
+            if (taskId >= nextTaskId) 
+            {
+                nextTaskId = taskId + 1;
+            }
         }
-    public:
-        PriorityQueue(int cap = MAX_TASKS) : size(0), capacity(cap) 
+        // Stores a copy of task and indexes it by ID, status and due date, but not
+        // priority; bulk paths queue their tasks together afterwards.
+        Task* storeTask(const Task& task)
         {
-            heap = new Task*[capacity];
+            Task* stored = taskStore.add(task);
+            taskLookup.insertTask(stored);
+            statusIndex.insert(stored);
+            dueWheel.insert(stored);
+            return stored;
         }
-        ~PriorityQueue() 
+        // Stores a copy of task and indexes it by ID, status and (unless completed) priority.
+        Task* insertTask(const Task& task)
         {
-            delete[] heap;
+            Task* stored = storeTask(task);
+            if (stored->taskStatus != COMPLETED)
+                priorityQueue.insert(stored);
+            return stored;
         }
-        void insert(Task* task) 
+        // Re-files a task after its status, priority or due date changed. Completed
+        // and leased tasks leave the priority queue so it only holds actionable
+        // work. A lease lasts only while its task stays in progress.
+        void reindexTask(Task* task)
         {
-            if (size >= capacity) 
-            {
-                cout << "Priority queue is full!" << endl;
-                return;
-            }
-            heap[size] = task;
-            int current = size++;
-            while (current > 0 && heap[(current - 1) / 2]->taskPriority < heap[current]->taskPriority) 
-            {
-                Task* temp = heap[current];
-                heap[current] = heap[(current - 1) / 2];
-                heap[(current - 1) / 2] = temp;
-                current = (current - 1) / 2;
-            }
+            if (task->taskStatus != IN_PROGRESS)
+                leases.release(task->taskId);
+            statusIndex.update(task);
+            dueWheel.update(task);
+            if (task->taskStatus == COMPLETED || leases.isLeased(task->taskId))
+                priorityQueue.removeTask(task->taskId);
+            else
+                priorityQueue.updateTask(task);
         }
-        Task* pop() 
+        // Unindexes and releases a task without scanning the store.
+        void eraseTask(Task* task)
         {
-            if (size == 0) return nullptr;
-            Task* topTask = heap[0];
-            heap[0] = heap[--size];
-            heapify(0);
-            return topTask;
+            leases.release(task->taskId);
+            statusIndex.remove(task);
+            dueWheel.remove(task);
+            priorityQueue.removeTask(task->taskId);
+            taskLookup.deleteTask(task->taskId);
+            taskStore.remove(task->handle);
         }
-        bool removeTask(int taskId) 
+        // Undoes (or redoes) one history record, pushing its inverse onto the other side.
+        void revert(const UndoRecord& record, UndoLog::Side inverse)
         {
-            int index = -1;
-            for (int i = 0; i < size; i++) 
+            Task* task = taskLookup.getTaskByID(record.taskId);
+            if (record.action == UNDO_CREATED) 
             {
-                if (heap[i]->taskId == taskId) 
+                if (task) 
                 {
-                    index = i;
-                    break;
+                    undoLog.push(inverse, UNDO_REMOVED, *task, FIELD_ALL);
+                    eraseTask(task);
                 }
-            }
-            if (index == -1) return false;
-            heap[index] = heap[size - 1];
-            size--;
-            buildHeap();
-            return true;
-        }
-        void updateTask(Task* task) 
-        {
-            bool found = false;
-            for (int i = 0; i < size; i++) 
+            } 
+            else if (record.action == UNDO_REMOVED) 
             {
-                if (heap[i]->taskId == task->taskId) 
+                if (!task) 
                 {
-                    found = true;
-                    break;
+                    Task restored;
+                    restored.taskId = record.taskId;
+                    undoLog.apply(record, restored);
+                    updateNextTaskId(record.taskId);
+                    undoLog.push(inverse, UNDO_CREATED, *insertTask(restored), 0);
                 }
-            }
-            if (!found) 
-            {
-                insert(task);
             } 
-            else 
+            else if (task) 
             {
-                buildHeap();
+                undoLog.push(inverse, UNDO_MODIFIED, *task, record.fields);
+                undoLog.apply(record, *task);
+                reindexTask(task);
             }
         }
-        void display() const 
+        // Undoes (or redoes) a batch record written for addTasks(), pushing one
+        // batch step onto the other side. Returns the IDs it touched.
+        vector<int> revertBatch(const UndoRecord& record, UndoLog::Side inverse)
         {
-            cout << "\n--- Priority Queue (Tasks by Priority) ---\n";
-            if (size == 0) {
-                cout << "No tasks in the priority queue.\n";
-                return;
-            }    
-            for (int i = 0; i < size; i++) 
+            vector<int> touched;
+            if (record.action == UNDO_CREATED) 
             {
-                heap[i]->displayTask();
-            }
-        }
-        bool isEmpty() const 
-        {
-            return size == 0;
-        }
-};
-
-class TaskHashMap 
-{
-    private:
-        Task* table[TABLE_SIZE];
-        int hashFunction(int taskID) const 
-        {
-            return (taskID * 2654435761) % TABLE_SIZE;
-        }
-    public:
-        TaskHashMap() 
-        {
-            for (int i = 0; i < TABLE_SIZE; i++)
-                table[i] = nullptr; 
-        }
-        void insertTask(Task* task) 
-        {
-            int index = hashFunction(task->taskId);
-            task->next = table[index];
-            table[index] = task;
-        }
-        Task* getTaskByID(int taskID) const 
-        {
-            int index = hashFunction(taskID);
-            Task* current = table[index];
-            while (current) 
-            {
-                if (current->taskId == taskID)
-                    return current;
-                current = current->next;
-            }
-            return nullptr;
-        }
-        bool deleteTask(int taskID) 
-        {
-            int index = hashFunction(taskID);
-            Task* current = table[index];
-            Task* prev = nullptr;
-            while (current) 
-            {
-                if (current->taskId == taskID) 
+                for (int id = record.taskId; id < record.taskId + record.count; id++) 
                 {
-                    if (prev) 
-                    {
-                        prev->next = current->next;
-                    } 
-                    else 
-                    {
-                        table[index] = current->next;  
-                    }
-                    return true;
+                    Task* task = taskLookup.getTaskByID(id);
+                    if (!task) continue;
+                    undoLog.push(inverse, UNDO_REMOVED, *task, FIELD_ALL);
+                    eraseTask(task);
+                    touched.push_back(id);
                 }
-                prev = current;
-                current = current->next;
-            }
-            return false;  
-        }
-        void displayTasks() const 
-        {
-            cout << "\n--- Task HashMap ---\n";
-            bool isEmpty = true;    
-            for (int i = 0; i < TABLE_SIZE; i++) 
-            {
-                if (table[i]) 
+                // Under the history budget the oldest removals may already have been
+                // evicted; redoing part of a batch would be worse than not at all.
+                if (undoLog.size(inverse) < (int)touched.size()) 
                 {
-                    isEmpty = false;
-                    Task* current = table[i];
-                    cout << "Bucket " << i << ": ";
-                    while (current) 
-                    {
-                        cout << "[ID: " << current->taskId << ", Name: " << current->taskName
-                            << ", Priority: " << current->taskPriority << "] -> ";
-                        current = current->next;
-                    }
-                    cout << "NULL\n";
+                    undoLog.clearSide(inverse);
+                    cout << "Batch is too large for the undo history and cannot be redone.\n";
                 }
+                else if (!touched.empty()) 
+                {
+                    undoLog.pushBatch(inverse, UNDO_REMOVED, record.taskId, touched.size());
+                }
+                return touched;
             }
-            if (isEmpty) 
-            {
-                cout << "No tasks in the hash map.\n";
-            }
-        }
-};
-
-class TaskState 
-{
-    public:
-        int taskId;
-        string taskName;
-        string taskDescription;
-        TaskStatus taskStatus;
-        int taskPriority;
-        time_t taskDueDate;
-        time_t taskCreationDate;
-        time_t taskCompletionDate;
-        bool exists;
-        TaskState() : taskId(-1), exists(false) {}
-        TaskState(const Task& task, bool exists = true) 
-            : taskId(task.taskId), taskName(task.taskName), 
-            taskDescription(task.taskDescription), taskStatus(task.taskStatus),
-            taskPriority(task.taskPriority), taskDueDate(task.taskDueDate),
-            taskCreationDate(task.taskCreationDate), 
-            taskCompletionDate(task.taskCompletionDate),
-            exists(exists) {}
-};
-
-class StackNode 
-{
-    public:
-        TaskState taskState;
-        StackNode* next;
-        StackNode(const TaskState& ts) : taskState(ts), next(nullptr) {}
-};
-
-class TaskStack 
-{
-    private:
-        StackNode* top;
-    public:
-        TaskStack() : top(nullptr) {}
-        ~TaskStack() 
-        {
-            while (!isEmpty()) 
-            {
-                pop();
-            }
-        }
-        void push(const TaskState& taskState) 
-        {
-            StackNode* newNode = new StackNode(taskState);
-            newNode->next = top;
-            top = newNode;
-        }
-        TaskState pop() 
-        {
-            if (isEmpty()) 
-            {
-                return TaskState(); 
-            }
-            StackNode* temp = top;
-            TaskState taskState = temp->taskState;
-            top = top->next;
-            delete temp;
-            return taskState;
-        }
-        bool isEmpty() const 
-        {
-            return top == nullptr;
-        }
-        void clear() 
-        {
-            while (!isEmpty()) 
+            // The removed tasks are the records beneath the batch header, newest first.
+            UndoLog::Side side = inverse == UndoLog::UNDO ? UndoLog::REDO : UndoLog::UNDO;
+            vector<Task> restored;
+            UndoRecord member;
+            for (int i = 0; i < record.count && undoLog.pop(side, member); i++) 
             {
-                pop();
+                restored.emplace_back();
+                restored.back().taskId = member.taskId;
+                undoLog.apply(member, restored.back());
             }
-        }
-};
-
-class TaskScheduler 
-{
-    private:
-        Task** tasks;
-        int taskCount;
-        int maxTasks;
-        int nextTaskId;
-        PriorityQueue priorityQueue;
-        TaskHashMap taskLookup;   
-        TaskStack undoStack; 
-        TaskStack redoStack;
-        void recordForUndo(const Task* task, bool exists = true) 
-        {
-            if (task) 
+            if ((int)restored.size() < record.count) 
             {
-                undoStack.push(TaskState(*task, exists));
-                redoStack.clear();
+                cout << "Only " << restored.size() << " of " << record.count << " tasks were still in the undo history.\n";
             }
-        }
-        void updateNextTaskId(int taskId) 
-        {
-            if (taskId >= nextTaskId) 
+            vector<Task*> queued;
+            for (auto it = restored.rbegin(); it != restored.rend(); ++it) 
             {
-                nextTaskId = taskId + 1;
+                if (taskLookup.getTaskByID(it->taskId)) continue;
+                updateNextTaskId(it->taskId);
+                Task* stored = storeTask(*it);
+                if (stored->taskStatus != COMPLETED)
+                    queued.push_back(stored);
+                touched.push_back(it->taskId);
             }
+            priorityQueue.insertAll(queued.data(), queued.size());
+            if (!touched.empty())
+                undoLog.pushBatch(inverse, UNDO_CREATED, touched.front(), touched.back() - touched.front() + 1);
+            return touched;
         }
     public:
-        TaskScheduler(int maxTaskCount = TABLE_SIZE) : taskCount(0), maxTasks(maxTaskCount), nextTaskId(1) 
+        TaskScheduler() : nextTaskId(1) {}
+        int addTask(const string& name, const string& description, TaskStatus status, int priority, time_t dueDate) 
         {
-            tasks = new Task*[maxTasks];
-            for (int i = 0; i < maxTasks; i++) 
-            {
-                tasks[i] = nullptr;
-            }
+            OperationTimer timer(OP_ADD);
+            int id = nextTaskId++;
+            Task* newTask = insertTask(Task(id, name, description, status, priority, dueDate));
+            recordForUndo(UNDO_CREATED, newTask);
+            cout << "Task added: " << name << " (ID: " << id << ")" << endl;
+            return id;
         }
-        ~TaskScheduler() 
+        // Adds all specs as a single operation: the priority queue is rebuilt once
+        // (Floyd) instead of sifting each task, the ID index is sized up front, and
+        // the batch is one undo step. Returns the first new ID, or -1 if specs is empty.
+        int addTasks(const TaskSpec* specs, size_t count) 
         {
-            for (int i = 0; i < taskCount; i++) 
+            OperationTimer timer(OP_ADD_BATCH);
+            if (count == 0) return -1;
+            int firstId = nextTaskId;
+            taskStore.reserve(taskStore.size() + count);
+            taskLookup.reserve(taskLookup.getSize() + count);
+            vector<Task*> queued;
+            queued.reserve(count);
+            for (size_t i = 0; i < count; i++) 
             {
-                if (tasks[i]) 
-                {
-                    delete tasks[i];
-                    tasks[i] = nullptr;
-                }
+                const TaskSpec& spec = specs[i];
+                Task* stored = storeTask(Task(nextTaskId++, spec.name, spec.description, spec.status, spec.priority, spec.dueDate));
+                if (stored->taskStatus != COMPLETED)
+                    queued.push_back(stored);
             }
-            delete[] tasks;
+            priorityQueue.insertAll(queued.data(), queued.size());
+            undoLog.recordBatch(UNDO_CREATED, firstId, count);
+            cout << "Added " << count << " tasks (IDs " << firstId << "-" << nextTaskId - 1 << ")" << endl;
+            return firstId;
         }
-        void addTask(const string& name, const string& description, TaskStatus status, int priority, time_t dueDate) 
+        int addTasks(const vector<TaskSpec>& specs) 
         {
-            if (taskCount >= maxTasks) 
-            {
-                cerr << "Task limit reached. Cannot add more tasks.\n";
-                return;
-            }
-            int id = nextTaskId++;
-            Task* newTask = new Task(id, name, description, status, priority, dueDate);
-            tasks[taskCount++] = newTask;
-            taskLookup.insertTask(newTask);
-            priorityQueue.insert(newTask);
-            recordForUndo(newTask);
-            cout << "Task added: " << name << " (ID: " << id << ")" << endl;
+            return addTasks(specs.data(), specs.size());
         }
-        void removeTask(int taskId) 
+        bool removeTask(int taskId) 
         {
+            OperationTimer timer(OP_REMOVE);
             Task* taskToRemove = taskLookup.getTaskByID(taskId);    
             if (!taskToRemove) 
             {
                 cout << "Task not found.\n";
-                return;
-            }
-            recordForUndo(taskToRemove, false);
-            priorityQueue.removeTask(taskId);
-            taskLookup.deleteTask(taskId);
-            int indexToRemove = -1;
-            for (int i = 0; i < taskCount; i++) 
-            {
-                if (tasks[i] && tasks[i]->taskId == taskId) 
-                {
-                    indexToRemove = i;
-                    break;
-                }
-            }
-            if (indexToRemove != -1) 
-            {
-                delete tasks[indexToRemove];
-                if (indexToRemove < taskCount - 1) 
-                {
-                    tasks[indexToRemove] = tasks[taskCount - 1];
-                }
-                tasks[taskCount - 1] = nullptr;
-                taskCount--;
+                timer.fail();
+                return false;
             }
+            recordForUndo(UNDO_REMOVED, taskToRemove, FIELD_ALL);
+            eraseTask(taskToRemove);
             cout << "Task removed successfully.\n";
+            return true;
         }
-        void modifyTask(int taskId, const string& newName, const string& newDescription, TaskStatus newStatus, int newPriority, time_t newDueDate) 
+        bool modifyTask(int taskId, const string& newName, const string& newDescription, TaskStatus newStatus, int newPriority, time_t newDueDate) 
         {
+            OperationTimer timer(OP_MODIFY);
             Task* task = taskLookup.getTaskByID(taskId);
             if (!task) 
             {
                 cout << "Task not found.\n";
-                return;
+                timer.fail();
+                return false;
             }
-            recordForUndo(task);
+            recordForUndo(UNDO_MODIFIED, task, changedFields(*task, newName, newDescription, newStatus, newPriority, newDueDate));
             task->taskName = newName;
             task->taskDescription = newDescription;
             if (newStatus == COMPLETED && task->taskStatus != COMPLETED) 
@@ -471,18 +251,21 @@ class TaskScheduler
             bool needPriorityUpdate = (task->taskPriority != newPriority);
             task->taskPriority = newPriority;
             task->taskDueDate = newDueDate;
-            priorityQueue.updateTask(task);
+            reindexTask(task);
             cout << "Task modified successfully.\n";
+            return true;
         }
-        void changeTaskStatus(int taskId, TaskStatus newStatus) 
+        bool changeTaskStatus(int taskId, TaskStatus newStatus) 
         {
+            OperationTimer timer(OP_STATUS);
             Task* task = taskLookup.getTaskByID(taskId);
             if (!task) 
             {
                 cout << "Task not found.\n";
-                return;
+                timer.fail();
+                return false;
             }
-            recordForUndo(task);
+            recordForUndo(UNDO_MODIFIED, task, FIELD_STATUS | FIELD_COMPLETION_DATE);
             if (newStatus == COMPLETED && task->taskStatus != COMPLETED) 
             {
                 task->completeTask();
@@ -491,209 +274,336 @@ class TaskScheduler
             {
                 task->taskStatus = newStatus;
             }
-            priorityQueue.updateTask(task);
+            reindexTask(task);
             cout << "Task status updated successfully.\n";
+            return true;
         }
-        void undo() 
+        bool undo() 
         {
-            if (undoStack.isEmpty()) 
+            OperationTimer timer(OP_UNDO);
+            UndoRecord lastAction;
+            if (!undoLog.pop(UndoLog::UNDO, lastAction)) 
             {
                 cout << "Nothing to undo.\n";
-                return;
+                timer.fail();
+                return false;
             }
-            TaskState lastAction = undoStack.pop();
-            if (lastAction.exists) 
+            if (lastAction.fields & FIELD_COUNT)
+                revertBatch(lastAction, UndoLog::REDO);
+            else
+                revert(lastAction, UndoLog::REDO);
+            cout << "Undo successful.\n";
+            return true;
+        }
+        bool redo() 
+        {
+            OperationTimer timer(OP_REDO);
+            UndoRecord lastUndone;
+            if (!undoLog.pop(UndoLog::REDO, lastUndone)) 
             {
-                Task* currentTask = taskLookup.getTaskByID(lastAction.taskId);
-                if (currentTask) 
-                {
-                    redoStack.push(TaskState(*currentTask));    
-                    currentTask->taskName = lastAction.taskName;
-                    currentTask->taskDescription = lastAction.taskDescription;
-                    currentTask->taskStatus = lastAction.taskStatus;
-                    currentTask->taskPriority = lastAction.taskPriority;
-                    currentTask->taskDueDate = lastAction.taskDueDate;
-                    currentTask->taskCreationDate = lastAction.taskCreationDate;
-                    currentTask->taskCompletionDate = lastAction.taskCompletionDate;
-                    priorityQueue.updateTask(currentTask);
-                } 
-                else 
-                {
-                    Task* newTask = new Task(lastAction.taskId, lastAction.taskName, lastAction.taskDescription, lastAction.taskStatus, lastAction.taskPriority, lastAction.taskDueDate);
-                    newTask->taskCreationDate = lastAction.taskCreationDate;
-                    newTask->taskCompletionDate = lastAction.taskCompletionDate;  
-                    updateNextTaskId(lastAction.taskId);
-                    if (taskCount < maxTasks) 
-                    {
-                        tasks[taskCount++] = newTask;
-                        taskLookup.insertTask(newTask);
-                        priorityQueue.insert(newTask);    
-                        redoStack.push(TaskState(*newTask, false)); 
-                    } 
-                    else 
-                    {
-                        cout << "Cannot undo - task limit reached.\n";
-                        delete newTask;
-                        return;
-                    }
-                }
-            } 
-            else 
+                cout << "Nothing to redo.\n";
+                timer.fail();
+                return false;
+            }
+            if (lastUndone.fields & FIELD_COUNT)
+                revertBatch(lastUndone, UndoLog::UNDO);
+            else
+                revert(lastUndone, UndoLog::UNDO);
+            cout << "Redo successful.\n";
+            return true;
+        }
+        // Claims the task at the front of the queue for leaseSeconds. It is marked
+        // in progress and stays out of the queue until it is completed, its lease
+        // is released, or the lease runs out. Returns the task ID and sets
+        // leaseToken, or returns -1 if nothing is queued.
+        int claimNextTask(time_t leaseSeconds, uint64_t& leaseToken)
+        {
+            Task* task = priorityQueue.top();
+            if (!task)
             {
-                Task* taskToDelete = taskLookup.getTaskByID(lastAction.taskId);
-                if (taskToDelete) 
-                {
-                    redoStack.push(TaskState(*taskToDelete));    
-                    priorityQueue.removeTask(lastAction.taskId);
-                    taskLookup.deleteTask(lastAction.taskId);
-                    for (int i = 0; i < taskCount; i++) 
-                    {
-                        if (tasks[i] && tasks[i]->taskId == lastAction.taskId) 
-                        {
-                            delete tasks[i];
-                            if (i < taskCount - 1) 
-                            {
-                                tasks[i] = tasks[taskCount - 1];
-                            }
-                            tasks[taskCount - 1] = nullptr;
-                            taskCount--;
-                            break;
-                        }
-                    }
-                }
+                cout << "No tasks to claim.\n";
+                return -1;
             }
-            cout << "Undo successful.\n";
+            leaseToken = leases.grant(task->taskId, time(0) + leaseSeconds);
+            task->taskStatus = IN_PROGRESS;
+            reindexTask(task);
+            cout << "Task claimed: " << task->taskName << " (ID: " << task->taskId << ", lease " << leaseToken << ")" << endl;
+            return task->taskId;
         }
-        void redo() 
+        // Extends a lease the caller holds to leaseSeconds from now.
+        bool heartbeatTask(int taskId, uint64_t leaseToken, time_t leaseSeconds)
         {
-            if (redoStack.isEmpty()) 
+            if (!leases.renew(taskId, leaseToken, time(0) + leaseSeconds))
             {
-                cout << "Nothing to redo.\n";
-                return;
+                cout << "Lease not held.\n";
+                return false;
             }
-            TaskState lastUndone = redoStack.pop();
-            if (lastUndone.exists) 
+            return true;
+        }
+        // Ends a lease the caller holds: the task is completed, or returns to the
+        // queue as pending.
+        bool finishLeasedTask(int taskId, uint64_t leaseToken, bool completed)
+        {
+            if (!leases.holds(taskId, leaseToken))
             {
-                Task* currentTask = taskLookup.getTaskByID(lastUndone.taskId);    
-                if (currentTask) 
-                {
-                    undoStack.push(TaskState(*currentTask));
-                    currentTask->taskName = lastUndone.taskName;
-                    currentTask->taskDescription = lastUndone.taskDescription;
-                    currentTask->taskStatus = lastUndone.taskStatus;
-                    currentTask->taskPriority = lastUndone.taskPriority;
-                    currentTask->taskDueDate = lastUndone.taskDueDate;
-                    currentTask->taskCreationDate = lastUndone.taskCreationDate;
-                    currentTask->taskCompletionDate = lastUndone.taskCompletionDate;    
-                    priorityQueue.updateTask(currentTask);
-                } 
-                else 
-                {
-                    Task* newTask = new Task(lastUndone.taskId, lastUndone.taskName, lastUndone.taskDescription, lastUndone.taskStatus, lastUndone.taskPriority, lastUndone.taskDueDate);
-                    newTask->taskCreationDate = lastUndone.taskCreationDate;
-                    newTask->taskCompletionDate = lastUndone.taskCompletionDate;
-                    updateNextTaskId(lastUndone.taskId);
-                    if (taskCount < maxTasks) 
-                    {
-                        tasks[taskCount++] = newTask;
-                        taskLookup.insertTask(newTask);
-                        priorityQueue.insert(newTask);    
-                        undoStack.push(TaskState(*newTask, false));
-                    } 
-                    else 
-                    {
-                        cout << "Cannot redo - task limit reached.\n";
-                        delete newTask;
-                        return;
-                    }
-                }
-            } 
-            else 
+                cout << "Lease not held.\n";
+                return false;
+            }
+            Task* task = taskLookup.getTaskByID(taskId);
+            if (completed)
+                task->completeTask();
+            else
+                task->taskStatus = PENDING;
+            reindexTask(task);
+            cout << (completed ? "Task completed: " : "Task released: ") << task->taskName << " (ID: " << taskId << ")" << endl;
+            return true;
+        }
+        // Seconds until taskId's lease runs out, or -1 if it holds none.
+        long long getLeaseRemaining(int taskId) const
+        {
+            time_t expiry = leases.expiryOf(taskId);
+            return expiry == 0 ? -1 : max<long long>(0, expiry - time(0));
+        }
+        // Puts tasks whose leases ran out back in the queue as pending. Expired
+        // leases are popped off the lease heap; no task is scanned.
+        void reclaimExpiredLeases()
+        {
+            leases.expire(time(0), [this](int taskId) {
+                Task* task = taskLookup.getTaskByID(taskId);
+                task->taskStatus = PENDING;
+                reindexTask(task);
+                cout << "Lease expired: " << task->taskName << " (ID: " << taskId << ") is back in the queue." << endl;
+            });
+        }
+        // Adds a rule that creates a copy of this task at every time on schedule
+        // ("every N{s,m,h,d,w}" or "cron M H DOM MON DOW"); each copy is due
+        // dueAfter seconds after it is created (0: no due date). Only the rule is
+        // stored until then. Returns the rule ID, or -1 for a bad schedule.
+        int addRecurringTask(const string& name, const string& description, int priority, time_t dueAfter, const string& schedule)
+        {
+            RecurrenceRule rule;
+            string error;
+            time_t now = time(0);
+            if (!rule.parseSchedule(schedule, now, error))
             {
-                Task* taskToDelete = taskLookup.getTaskByID(lastUndone.taskId);
-                if (taskToDelete) 
-                {
-                    undoStack.push(TaskState(*taskToDelete));    
-                    priorityQueue.removeTask(lastUndone.taskId);
-                    taskLookup.deleteTask(lastUndone.taskId);
-                    for (int i = 0; i < taskCount; i++) 
-                    {
-                        if (tasks[i] && tasks[i]->taskId == lastUndone.taskId) 
-                        {
-                            delete tasks[i];
-                            if (i < taskCount - 1) 
-                            {
-                                tasks[i] = tasks[taskCount - 1];
-                            }
-                            tasks[taskCount - 1] = nullptr;
-                            taskCount--;
-                            break;
-                        }
-                    }
-                }
+                cout << "Invalid schedule: " << error << endl;
+                return -1;
             }
-            cout << "Redo successful.\n";
+            if (rule.fireAfter(now - 1) == 0)
+            {
+                cout << "Invalid schedule: it never fires.\n";
+                return -1;
+            }
+            rule.name = name;
+            rule.description = description;
+            rule.priority = priority;
+            rule.dueAfter = dueAfter;
+            int ruleId = recurrence.add(std::move(rule), now);
+            cout << "Recurring task added: " << name << " (rule " << ruleId << ")" << endl;
+            materializeOccurrences();
+            return ruleId;
+        }
+        // Stops a rule; occurrences already created are kept.
+        bool removeRecurringTask(int ruleId)
+        {
+            if (!recurrence.remove(ruleId))
+            {
+                cout << "Recurring task not found.\n";
+                return false;
+            }
+            cout << "Recurring task removed.\n";
+            return true;
+        }
+        vector<const RecurrenceRule*> getRecurringTasks() const
+        {
+            return recurrence.list();
+        }
+        void displayRecurringTasks() const
+        {
+            cout << "\n--- Recurring Tasks ---\n";
+            if (recurrence.size() == 0)
+            {
+                cout << "No recurring tasks.\n";
+                return;
+            }
+            for (const RecurrenceRule* rule : recurrence.list())
+            {
+                char next[20] = "never";
+                if (rule->nextFire != 0)
+                    strftime(next, sizeof(next), "%Y-%m-%d %H:%M:%S", localtime(&rule->nextFire));
+                cout << "Rule ID: " << rule->ruleId << endl;
+                cout << "Task Name: " << rule->name << endl;
+                cout << "Task Description: " << rule->description << endl;
+                cout << "Task Priority: " << rule->priority << endl;
+                cout << "Schedule: " << rule->schedule << endl;
+                cout << "Next Occurrence: " << next << endl;
+                cout << "Occurrences So Far: " << rule->occurrences << endl;
+                cout << "------------------------" << endl;
+            }
+        }
+        // Creates a task for every rule whose time has come. Cheap when none has:
+        // the next fire time is the top of the rules' heap.
+        void materializeOccurrences()
+        {
+            time_t now = time(0);
+            if (recurrence.nextFireTime() == 0 || recurrence.nextFireTime() > now) return;
+            recurrence.fireDue(now, [this](const RecurrenceRule& rule, time_t fireTime) {
+                int id = nextTaskId++;
+                insertTask(Task(id, rule.name, rule.description, PENDING, rule.priority, rule.dueAfter ? fireTime + rule.dueAfter : 0));
+                cout << "Recurring task created: " << rule.name << " (ID: " << id << ", rule " << rule.ruleId << ")" << endl;
+            });
         }
         void displayAllTasks() const 
         {
-            if (taskCount == 0) 
+            if (taskStore.size() == 0) 
             {
                 cout << "No tasks to display.\n";
                 return;
             }
             cout << "\n--- All Tasks ---\n";
-            for (int i = 0; i < taskCount; i++) 
+            for (int i = 0; i < taskStore.size(); i++) 
             {
-                if (tasks[i]) 
-                {
-                    tasks[i]->displayTask();
-                }
+                taskStore.at(i)->displayTask();
             }
         }
         void displayTasksByStatus(TaskStatus status) const 
         {
             cout << "\n--- Tasks with Status: " << (status == PENDING ? "Pending" : (status == IN_PROGRESS ? "In Progress" : "Completed")) << " ---\n";
-            bool found = false;
-            for (int i = 0; i < taskCount; i++) 
+            if (statusIndex.count(status) == 0) 
             {
-                if (tasks[i] && tasks[i]->taskStatus == status) 
-                {
-                    tasks[i]->displayTask();
-                    found = true;
-                }
+                cout << "No tasks with the specified status.\n";
+                return;
             }
-            if (!found) 
+            for (Task* task = statusIndex.first(status); task; task = StatusIndex::next(task)) 
             {
-                cout << "No tasks with the specified status.\n";
+                task->displayTask();
             }
         }
         void displayTasksByPriority() const 
         {
             priorityQueue.display();
         }
+        void setSchedulingPolicy(SchedulingPolicy policy)
+        {
+            priorityQueue.setPolicy(policy);
+            cout << "Tasks are now ordered by " << priorityQueue.policyName() << ".\n";
+        }
         void displayTaskStructure() const 
         {
             taskLookup.displayTasks();
         }
-        int getTaskCount() const 
+        // Creates the recurring tasks that have come due and reclaims expired
+        // leases, then reports tasks whose due date has passed since the last check.
+        void checkDeadlines()
         {
-            return taskCount;
+            checkDeadlines([](Task* task) {
+                cout << "Overdue: " << task->taskName << " (ID: " << task->taskId << ") was due " << task->formatTime(task->taskDueDate) << endl;
+            });
         }
-        Task* getTaskByIndex(int index) const 
+        template <typename Report>
+        void checkDeadlines(Report report)
         {
-            if (index >= 0 && index < taskCount) 
+            materializeOccurrences();
+            reclaimExpiredLeases();
+            dueWheel.advance(time(0), report);
+        }
+        void displayOverdueTasks()
+        {
+            checkDeadlines();
+            cout << "\n--- Overdue Tasks ---\n";
+            if (dueWheel.overdueCount() == 0)
             {
-                return tasks[index];
+                cout << "No overdue tasks.\n";
+                return;
             }
-            return nullptr;
+            dueWheel.forEachOverdue([](Task* task) { task->displayTask(); });
+        }
+        void displayTasksDueWithin(int hours)
+        {
+            checkDeadlines();
+            vector<Task*> dueSoon = getTasksDueWithin(hours);
+            cout << "\n--- Tasks Due Within " << hours << " Hours ---\n";
+            if (dueSoon.empty())
+            {
+                cout << "No tasks due in that window.\n";
+                return;
+            }
+            for (Task* task : dueSoon)
+            {
+                task->displayTask();
+            }
+        }
+        vector<Task*> getTasksByStatus(TaskStatus status) const
+        {
+            vector<Task*> tasks;
+            for (Task* task = statusIndex.first(status); task; task = StatusIndex::next(task))
+                tasks.push_back(task);
+            return tasks;
+        }
+        vector<Task*> getTasksByPriority() const
+        {
+            return priorityQueue.tasksInOrder();
+        }
+        // As of the last checkDeadlines().
+        vector<Task*> getOverdueTasks() const
+        {
+            vector<Task*> overdue;
+            dueWheel.forEachOverdue([&](Task* task) { overdue.push_back(task); });
+            return overdue;
+        }
+        // Not yet overdue and due within hours, soonest first.
+        vector<Task*> getTasksDueWithin(int hours) const
+        {
+            vector<Task*> dueSoon;
+            dueWheel.forEachDueBefore(time(0) + (time_t)hours * 3600, [&](Task* task) { dueSoon.push_back(task); });
+            sort(dueSoon.begin(), dueSoon.end(), [](const Task* a, const Task* b) {
+                return a->taskDueDate < b->taskDueDate;
+            });
+            return dueSoon;
+        }
+        int getTaskCount() const 
+        {
+            return taskStore.size();
+        }
+        int getTaskCount(TaskStatus status) const 
+        {
+            return statusIndex.count(status);
+        }
+        Task* getTaskByIndex(int index) const 
+        {
+            return taskStore.at(index);
         }
 };
-int main() 
+int main(int argc, char* argv[]) 
 {
     TaskScheduler scheduler;
     int choice = 0;   
+    BatchOptions options;
+    if (!parseBatchOptions(argc, argv, options))
+    {
+        cerr << "Usage: " << argv[0] << " [--batch] [--json] [FILE]\n";
+        return 2;
+    }
+    if (options.enabled)
+    {
+        ios::sync_with_stdio(false);
+        ifstream file;
+        if (!options.file.empty())
+        {
+            file.open(options.file);
+            if (!file)
+            {
+                cerr << "Error: cannot open " << options.file << endl;
+                return 1;
+            }
+        }
+        istream& input = options.file.empty() ? cin : file;
+        BatchSession session(options.json);
+        return session.run(scheduler, input) == 0 ? 0 : 1;
+    }
     while (true) 
     {
+        scheduler.checkDeadlines();
         cout << "\n===== TASK SCHEDULER MENU =====\n";
         cout << "1. Add New Task\n";
         cout << "2. Remove Task\n";
@@ -705,9 +615,21 @@ int main()
         cout << "8. Display Task Structure\n";
         cout << "9. Undo Last Action\n";
         cout << "10. Redo Last Action\n";
+        cout << "11. Display Overdue Tasks\n";
+        cout << "12. Display Tasks Due Soon\n";
+        cout << "13. Change Scheduling Policy\n";
+        cout << "14. Display Operation Statistics\n";
+        cout << "15. Add Recurring Task\n";
+        cout << "16. Display Recurring Tasks\n";
+        cout << "17. Remove Recurring Task\n";
         cout << "0. Exit\n";
         cout << "Enter your choice: ";
-        cin >> choice;
+        if (!(cin >> choice))
+        {
+            // End of input exits; anything else that is not a number is an invalid choice
+            choice = cin.eof() ? 0 : -1;
+            cin.clear();
+        }
         cin.ignore();
         if (choice == 0) 
         {
@@ -829,6 +751,72 @@ int main()
         {
             scheduler.redo();
         }
+        else if (choice == 11) 
+        {
+            scheduler.displayOverdueTasks();
+        }
+        else if (choice == 12) 
+        {
+            int hours;
+            cout << "Show tasks due within how many hours? ";
+            cin >> hours;
+            scheduler.displayTasksDueWithin(hours);
+        }
+        else if (choice == 13) 
+        {
+            int policy;
+            cout << "Order by (0: Priority, 1: Due Date, 2: Priority then Due Date, 3: Weighted): ";
+            cin >> policy;
+            if (policy < POLICY_PRIORITY || policy > POLICY_WEIGHTED)
+            {
+                cout << "Invalid policy.\n";
+            }
+            else
+            {
+                scheduler.setSchedulingPolicy((SchedulingPolicy)policy);
+            }
+        }
+        else if (choice == 14) 
+        {
+            writeMetricsTable(cout);
+        }
+        else if (choice == 15) 
+        {
+            string taskName, taskDescription, dueAfter, schedule;
+            int taskPriority;
+            time_t dueSeconds;
+            cout << "Enter task name: ";
+            getline(cin, taskName);
+            cout << "Enter task description: ";
+            getline(cin, taskDescription);
+            cout << "Enter task priority (1-5): ";
+            cin >> taskPriority;
+            cin.ignore();
+            cout << "Due how long after each occurrence is created (e.g. 12h, 0 for no due date): ";
+            getline(cin, dueAfter);
+            cout << "Repeat (every N followed by s, m, h, d or w, or cron M H DOM MON DOW): ";
+            getline(cin, schedule);
+            if (RecurrenceRule::parseDuration(dueAfter, dueSeconds))
+            {
+                scheduler.addRecurringTask(taskName, taskDescription, taskPriority, dueSeconds, schedule);
+            }
+            else
+            {
+                cout << "Invalid duration. Recurring task not added.\n";
+            }
+            continue;
+        }
+        else if (choice == 16) 
+        {
+            scheduler.displayRecurringTasks();
+        }
+        else if (choice == 17) 
+        {
+            int ruleId;
+            cout << "Enter rule ID to remove: ";
+            cin >> ruleId;
+            scheduler.removeRecurringTask(ruleId);
+        }
         else 
         {
             cout << "Invalid choice. Please try again.\n";
@@ -1,864 +1,1399 @@
 #include <iostream>
 #include <string>
 #include <ctime>
+#include <algorithm>
+#include <climits>
+#include <vector>
 #include <fstream>  // Added for file handling
+#include <sys/wait.h>
+#include <unistd.h>
+#include "Task.h"
+#include "PriorityQueue.h"
+#include "TaskHashMap.h"
+#include "TaskStore.h"
+#include "StatusIndex.h"
+#include "TimingWheel.h"
+#include "UndoLog.h"
+#include "Metrics.h"
+#include "RecurrenceRules.h"
+#include "LeaseTable.h"
+#include "TaskJournal.h"
+#include "TaskBTree.h"
+#include "TaskSnapshot.h"
+#include "TaskTextReader.h"
+#include "ChangeLog.h"
+#include "BatchMode.h"
+#include "TaskServer.h"
 
 using namespace std;
 
-const int TABLE_SIZE = 10; 
-const int MAX_TASKS = 100; 
-const string FILENAME = "tasks.txt";  // File to store tasks
+const string FILENAME = "tasks.txt";  // Text export/import file
+const string SNAPSHOT_FILENAME = "tasks.snapshot";  // Binary checkpoint loaded at startup
+const string DAMAGED_SNAPSHOT_FILENAME = "tasks.snapshot.corrupt";  // A snapshot that failed its checks, set aside for the user
+const string JOURNAL_FILENAME = "tasks.journal";  // Changes since the last checkpoint
+const string JOURNAL_SEGMENT_FILENAME = "tasks.journal.old";  // Changes a background save is folding into the snapshot
+const string RULES_FILENAME = "tasks.rules";  // Recurring task rules
+const string DAMAGED_RULES_FILENAME = "tasks.rules.corrupt";  // A rules file that failed to load, set aside for the user
+const string ARCHIVE_FILENAME = "tasks.archive";  // On-disk B+tree of archived completed tasks
+const time_t ARCHIVE_AFTER = 7 * 24 * 3600;  // Completed tasks older than this are archived at load
+const long long CHECKPOINT_BYTES = 1 << 20;  // Journal size that triggers a background save
 
-enum TaskStatus 
-{
-    PENDING,
-    IN_PROGRESS,
-    COMPLETED
-};
-
-class Task 
+class TaskScheduler 
 {
-    public:
-        int taskId;
-        string taskName;
-        string taskDescription;
-        TaskStatus taskStatus;
-        int taskPriority;
-        time_t taskDueDate;
-        time_t taskCreationDate;
-        time_t taskCompletionDate;
-        Task* next;  
-        Task() : taskId(-1), taskName(""), taskDescription(""), taskStatus(PENDING),
-            taskPriority(0), taskDueDate(0), taskCreationDate(0), taskCompletionDate(0), next(nullptr) {}
-        Task(int id, string name, string description, TaskStatus status, int priority, time_t dueDate)
-            : taskId(id), taskName(name), taskDescription(description), taskStatus(status),
-            taskPriority(priority), taskDueDate(dueDate), taskCreationDate(time(0)), taskCompletionDate(0), next(nullptr) {}
-        Task(const Task& other)
-            : taskId(other.taskId), taskName(other.taskName), taskDescription(other.taskDescription),
-            taskStatus(other.taskStatus), taskPriority(other.taskPriority), taskDueDate(other.taskDueDate),
-            taskCreationDate(other.taskCreationDate), taskCompletionDate(other.taskCompletionDate), next(nullptr) {}
-        Task& operator=(const Task& other) 
-        {
-            if (this != &other) 
-            {
-                taskId = other.taskId;
-                taskName = other.taskName;
-                taskDescription = other.taskDescription;
-                taskStatus = other.taskStatus;
-                taskPriority = other.taskPriority;
-                taskDueDate = other.taskDueDate;
-                taskCreationDate = other.taskCreationDate;
-                taskCompletionDate = other.taskCompletionDate;
-            }
-            return *this;
-        }
-        void completeTask() 
-        {
-            taskStatus = COMPLETED;
-            taskCompletionDate = time(0);
-        }
-        string formatTime(time_t t) const 
-        {
-            if (t == 0) return "N/A";
-            char buffer[20];
-            strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", localtime(&t));
-            return string(buffer);
-        }
-        void displayTask() const 
-        {
-            cout << "Task ID: " << taskId << endl;
-            cout << "Task Name: " << taskName << endl;
-            cout << "Task Description: " << taskDescription << endl;
-            cout << "Task Status: " << (taskStatus == PENDING ? "Pending" : (taskStatus == IN_PROGRESS ? "In Progress" : "Completed")) << endl;
-            cout << "Task Priority: " << taskPriority << endl;
-            cout << "Task Due Date: " << formatTime(taskDueDate) << endl;
-            cout << "Task Creation Date: " << formatTime(taskCreationDate) << endl;
-            if (taskCompletionDate != 0)
-                cout << "Task Completion Date: " << formatTime(taskCompletionDate) << endl;
-            cout << "------------------------" << endl;
-        }
-        bool isValid() const 
-        {
-            return taskId != -1;
+    private:
+        TaskStore taskStore;
+        int nextTaskId;
+        SchedulingQueue priorityQueue;
+        TaskHashMap taskLookup;   
+        StatusIndex statusIndex;
+        TimingWheel dueWheel;
+        UndoLog undoLog;
+        RecurrenceSchedule recurrence;
+        LeaseTable leases;
+        TaskJournal journal;
+        mutable TaskBTree archive;  // pages are cached as they are read
+        ChangeLog changes;
+        pid_t saverPid;         // background save in progress, or -1
+        bool saveRequested;     // another background save is due when it finishes
+        bool snapshotStuck;     // a damaged snapshot could not be set aside and must not be overwritten
+        bool rulesStuck;        // likewise for a damaged rules file
+        void recordForUndo(UndoAction action, const Task* task, uint8_t fields = 0) 
+        {
+            if (task) 
+            {
+                undoLog.record(action, *task, fields);
+            }
         }
-        
-        // Added for file handling - write task to file stream
-        void writeToFile(ofstream& outFile) const 
-        {
-            outFile << taskId << endl;
-            outFile << taskName << endl;
-            outFile << taskDescription << endl;
-            outFile << taskStatus << endl;
-            outFile << taskPriority << endl;
-            outFile << taskDueDate << endl;
-            outFile << taskCreationDate << endl;
-            outFile << taskCompletionDate << endl;
+        void updateNextTaskId(int taskId) 
+        {
+            if (taskId >= nextTaskId) 
+            {
+                nextTaskId = taskId + 1;
+            }
         }
-        
-        // Added for file handling - read task from file stream
-        bool readFromFile(ifstream& inFile) 
+        // Stores a copy of task and indexes it by ID, status and due date, but not
+        // priority; bulk paths queue their tasks together afterwards.
+        Task* storeTask(const Task& task)
         {
-            if (!inFile.good()) return false;
-            
-            inFile >> taskId;
-            inFile.ignore(); // Skip newline
-            
-            getline(inFile, taskName);
-            getline(inFile, taskDescription);
-            
-            int status;
-            inFile >> status;
-            taskStatus = static_cast<TaskStatus>(status);
-            
-            inFile >> taskPriority;
-            inFile >> taskDueDate;
-            inFile >> taskCreationDate;
-            inFile >> taskCompletionDate;
-            
-            inFile.ignore(); // Skip newline
-            return true;
+            Task* stored = taskStore.add(task);
+            indexTask(stored);
+            return stored;
         }
-};
-
-class PriorityQueue 
-{
-    private:
-        Task** heap;
-        int size;
-        int capacity;
-        void heapify(int i) 
+        // Indexes a task already in the store by ID, status and due date.
+        void indexTask(Task* task)
+        {
+            taskLookup.insertTask(task);
+            statusIndex.insert(task);
+            dueWheel.insert(task);
+        }
+        // Stores a copy of task and indexes it by ID, status and (unless completed) priority.
+        Task* insertTask(const Task& task)
+        {
+            Task* stored = storeTask(task);
+            if (stored->taskStatus != COMPLETED)
+                priorityQueue.insert(stored);
+            return stored;
+        }
+        // Re-files a task after its status, priority or due date changed. Completed
+        // and leased tasks leave the priority queue so it only holds actionable
+        // work. A lease lasts only while its task stays in progress.
+        void reindexTask(Task* task)
+        {
+            if (task->taskStatus != IN_PROGRESS)
+                leases.release(task->taskId);
+            statusIndex.update(task);
+            dueWheel.update(task);
+            if (task->taskStatus == COMPLETED || leases.isLeased(task->taskId))
+                priorityQueue.removeTask(task->taskId);
+            else
+                priorityQueue.updateTask(task);
+        }
+        // Unindexes and releases a task without scanning the store.
+        void eraseTask(Task* task)
+        {
+            leases.release(task->taskId);
+            statusIndex.remove(task);
+            dueWheel.remove(task);
+            priorityQueue.removeTask(task->taskId);
+            taskLookup.deleteTask(task->taskId);
+            taskStore.remove(task->handle);
+        }
+        // Undoes (or redoes) one history record, pushing its inverse onto the other side.
+        void revert(const UndoRecord& record, UndoLog::Side inverse)
         {
-            int largest = i;
-            int left = 2 * i + 1;
-            int right = 2 * i + 2;
-            if (left < size && heap[left]->taskPriority > heap[largest]->taskPriority)
-                largest = left;
-            if (right < size && heap[right]->taskPriority > heap[largest]->taskPriority)
-                largest = right;
-            if (largest != i) 
+            Task* task = findTask(record.taskId);
+            if (record.action == UNDO_CREATED) 
+            {
+                if (task) 
+                {
+                    undoLog.push(inverse, UNDO_REMOVED, *task, FIELD_ALL);
+                    eraseTask(task);
+                    forgetArchived(record.taskId);
+                }
+            } 
+            else if (record.action == UNDO_REMOVED) 
+            {
+                if (!task) 
+                {
+                    Task restored;
+                    restored.taskId = record.taskId;
+                    undoLog.apply(record, restored);
+                    updateNextTaskId(record.taskId);
+                    undoLog.push(inverse, UNDO_CREATED, *insertTask(restored), 0);
+                }
+            } 
+            else if (task) 
             {
-                Task* temp = heap[i];
-                heap[i] = heap[largest];
-                heap[largest] = temp;
-                heapify(largest);
+                undoLog.push(inverse, UNDO_MODIFIED, *task, record.fields);
+                undoLog.apply(record, *task);
+                reindexTask(task);
             }
         }
-        void buildHeap() 
+        // Undoes (or redoes) a batch record written for addTasks(), pushing one
+        // batch step onto the other side. Returns the IDs it touched.
+        vector<int> revertBatch(const UndoRecord& record, UndoLog::Side inverse)
         {
-            for (int i = size / 2 - 1; i >= 0; i--)
-                heapify(i);
+            vector<int> touched;
+            if (record.action == UNDO_CREATED) 
+            {
+                for (int id = record.taskId; id < record.taskId + record.count; id++) 
+                {
+                    Task* task = findTask(id);
+                    if (!task) continue;
+                    undoLog.push(inverse, UNDO_REMOVED, *task, FIELD_ALL);
+                    eraseTask(task);
+                    forgetArchived(id);
+                    touched.push_back(id);
+                }
+                // Under the history budget the oldest removals may already have been
+                // evicted; redoing part of a batch would be worse than not at all.
+                if (undoLog.size(inverse) < (int)touched.size()) 
+                {
+                    undoLog.clearSide(inverse);
+                    cout << "Batch is too large for the undo history and cannot be redone.\n";
+                }
+                else if (!touched.empty()) 
+                {
+                    undoLog.pushBatch(inverse, UNDO_REMOVED, record.taskId, touched.size());
+                }
+                return touched;
+            }
+            // The removed tasks are the records beneath the batch header, newest first.
+            UndoLog::Side side = inverse == UndoLog::UNDO ? UndoLog::REDO : UndoLog::UNDO;
+            vector<Task> restored;
+            UndoRecord member;
+            for (int i = 0; i < record.count && undoLog.pop(side, member); i++) 
+            {
+                restored.emplace_back();
+                restored.back().taskId = member.taskId;
+                undoLog.apply(member, restored.back());
+            }
+            if ((int)restored.size() < record.count) 
+            {
+                cout << "Only " << restored.size() << " of " << record.count << " tasks were still in the undo history.\n";
+            }
+            vector<Task*> queued;
+            for (auto it = restored.rbegin(); it != restored.rend(); ++it) 
+            {
+                if (taskLookup.getTaskByID(it->taskId)) continue;
+                updateNextTaskId(it->taskId);
+                Task* stored = storeTask(*it);
+                if (stored->taskStatus != COMPLETED)
+                    queued.push_back(stored);
+                touched.push_back(it->taskId);
+            }
+            priorityQueue.insertAll(queued.data(), queued.size());
+            if (!touched.empty())
+                undoLog.pushBatch(inverse, UNDO_CREATED, touched.front(), touched.back() - touched.front() + 1);
+            return touched;
         }
-    public:
-        PriorityQueue(int cap = MAX_TASKS) : size(0), capacity(cap) 
+        // Appends the task's current state, or its removal if it is gone, to the journal.
+        void journalTask(int taskId)
         {
-            heap = new Task*[capacity];
+            changes.record(taskId);
+            Task* task = taskLookup.getTaskByID(taskId);
+            if (task)
+                journal.logUpsert(*task, nextTaskId);
+            else
+                journal.logRemove(taskId, nextTaskId);
+            if (journal.size() >= CHECKPOINT_BYTES)
+                backgroundSave();
         }
-        ~PriorityQueue() 
+        // Journals the current state of several tasks as one record.
+        void journalTasks(const vector<int>& taskIds)
         {
-            delete[] heap;
+            vector<const Task*> upserts;
+            vector<int> removals;
+            for (int taskId : taskIds)
+            {
+                changes.record(taskId);
+                Task* task = taskLookup.getTaskByID(taskId);
+                if (task)
+                    upserts.push_back(task);
+                else
+                    removals.push_back(taskId);
+            }
+            journal.logBatch(upserts, removals, nextTaskId);
+            if (journal.size() >= CHECKPOINT_BYTES)
+                backgroundSave();
         }
-        void insert(Task* task) 
+        // Journal replay - install a task state without undo history or journaling
+        void restoreTask(const Task& state)
         {
-            if (size >= capacity) 
+            updateNextTaskId(state.taskId);
+            Task* task = taskLookup.getTaskByID(state.taskId);
+            if (task)
             {
-                cout << "Priority queue is full!" << endl;
+                *task = state;
+                reindexTask(task);
                 return;
             }
-            heap[size] = task;
-            int current = size++;
-            while (current > 0 && heap[(current - 1) / 2]->taskPriority < heap[current]->taskPriority) 
+            insertTask(state);
+        }
+        void discardTask(int taskId)
+        {
+            Task* task = taskLookup.getTaskByID(taskId);
+            if (task)
+                eraseTask(task);
+            forgetArchived(taskId);
+        }
+        // Looks a task up by ID, bringing it back into memory if it was archived;
+        // archived tasks are never changed in place. The task is journaled before
+        // it leaves the archive, so a crash in between leaves it in both, and
+        // memory wins.
+        Task* findTask(int taskId)
+        {
+            Task* task = taskLookup.getTaskByID(taskId);
+            if (task || !archive.isOpen()) return task;
+            Task archived;
+            if (!archive.get(taskId, archived))
+            {
+                if (!archive.error().empty())
+                    cerr << "Error: Archive: " << archive.error() << endl;
+                return nullptr;
+            }
+            updateNextTaskId(taskId);
+            task = insertTask(archived);
+            journalTask(taskId);
+            journal.commit();
+            forgetArchived(taskId);
+            return task;
+        }
+        // Drops an archived copy of a task that was removed, so it cannot come back.
+        void forgetArchived(int taskId)
+        {
+            if (archive.isOpen() && archive.remove(taskId) && !archive.flush())
+                cerr << "Error: Archive: " << archive.error() << endl;
+        }
+    public:
+        TaskScheduler() : nextTaskId(1), journal(JOURNAL_FILENAME), saverPid(-1), saveRequested(false), snapshotStuck(false), rulesStuck(false) {}
+        int addTask(const string& name, const string& description, TaskStatus status, int priority, time_t dueDate) 
+        {
+            OperationTimer timer(OP_ADD);
+            int id = nextTaskId++;
+            Task* newTask = insertTask(Task(id, name, description, status, priority, dueDate));
+            recordForUndo(UNDO_CREATED, newTask);
+            cout << "Task added: " << name << " (ID: " << id << ")" << endl;
+            journalTask(id);
+            return id;
+        }
+        // Adds all specs as a single operation: the priority queue is rebuilt once
+        // (Floyd) instead of sifting each task, the ID index is sized up front, and
+        // the batch is one undo step and one journal record. Returns the first new
+        // ID, or -1 if specs is empty.
+        int addTasks(const TaskSpec* specs, size_t count) 
+        {
+            OperationTimer timer(OP_ADD_BATCH);
+            if (count == 0) return -1;
+            int firstId = nextTaskId;
+            taskStore.reserve(taskStore.size() + count);
+            taskLookup.reserve(taskLookup.getSize() + count);
+            vector<Task*> queued;
+            queued.reserve(count);
+            vector<int> ids;
+            ids.reserve(count);
+            for (size_t i = 0; i < count; i++) 
             {
-                Task* temp = heap[current];
-                heap[current] = heap[(current - 1) / 2];
-                heap[(current - 1) / 2] = temp;
-                current = (current - 1) / 2;
+                const TaskSpec& spec = specs[i];
+                Task* stored = storeTask(Task(nextTaskId++, spec.name, spec.description, spec.status, spec.priority, spec.dueDate));
+                if (stored->taskStatus != COMPLETED)
+                    queued.push_back(stored);
+                ids.push_back(stored->taskId);
             }
+            priorityQueue.insertAll(queued.data(), queued.size());
+            undoLog.recordBatch(UNDO_CREATED, firstId, count);
+            cout << "Added " << count << " tasks (IDs " << firstId << "-" << nextTaskId - 1 << ")" << endl;
+            journalTasks(ids);
+            return firstId;
         }
-        Task* pop() 
+        int addTasks(const vector<TaskSpec>& specs) 
         {
-            if (size == 0) return nullptr;
-            Task* topTask = heap[0];
-            heap[0] = heap[--size];
-            heapify(0);
-            return topTask;
+            return addTasks(specs.data(), specs.size());
         }
         bool removeTask(int taskId) 
         {
-            int index = -1;
-            for (int i = 0; i < size; i++) 
+            OperationTimer timer(OP_REMOVE);
+            Task* taskToRemove = findTask(taskId);
+            if (!taskToRemove) 
             {
-                if (heap[i]->taskId == taskId) 
-                {
-                    index = i;
-                    break;
-                }
+                cout << "Task not found.\n";
+                timer.fail();
+                return false;
             }
-            if (index == -1) return false;
-            heap[index] = heap[size - 1];
-            size--;
-            buildHeap();
+            recordForUndo(UNDO_REMOVED, taskToRemove, FIELD_ALL);
+            eraseTask(taskToRemove);
+            forgetArchived(taskId);
+            cout << "Task removed successfully.\n";
+            journalTask(taskId);
             return true;
         }
-        void updateTask(Task* task) 
+        bool modifyTask(int taskId, const string& newName, const string& newDescription, TaskStatus newStatus, int newPriority, time_t newDueDate) 
         {
-            bool found = false;
-            for (int i = 0; i < size; i++) 
+            OperationTimer timer(OP_MODIFY);
+            Task* task = findTask(taskId);
+            if (!task) 
             {
-                if (heap[i]->taskId == task->taskId) 
-                {
-                    found = true;
-                    break;
-                }
+                cout << "Task not found.\n";
+                timer.fail();
+                return false;
             }
-            if (!found) 
+            recordForUndo(UNDO_MODIFIED, task, changedFields(*task, newName, newDescription, newStatus, newPriority, newDueDate));
+            task->taskName = newName;
+            task->taskDescription = newDescription;
+            if (newStatus == COMPLETED && task->taskStatus != COMPLETED) 
             {
-                insert(task);
+                task->completeTask();
             } 
             else 
             {
-                buildHeap();
+                task->taskStatus = newStatus;
             }
+            bool needPriorityUpdate = (task->taskPriority != newPriority);
+            task->taskPriority = newPriority;
+            task->taskDueDate = newDueDate;
+            reindexTask(task);
+            cout << "Task modified successfully.\n";
+            journalTask(taskId);
+            return true;
         }
-        void display() const 
+        bool changeTaskStatus(int taskId, TaskStatus newStatus) 
         {
-            cout << "\n--- Priority Queue (Tasks by Priority) ---\n";
-            if (size == 0) {
-                cout << "No tasks in the priority queue.\n";
-                return;
-            }    
-            for (int i = 0; i < size; i++) 
+            OperationTimer timer(OP_STATUS);
+            Task* task = findTask(taskId);
+            if (!task) 
+            {
+                cout << "Task not found.\n";
+                timer.fail();
+                return false;
+            }
+            recordForUndo(UNDO_MODIFIED, task, FIELD_STATUS | FIELD_COMPLETION_DATE);
+            if (newStatus == COMPLETED && task->taskStatus != COMPLETED) 
             {
-                heap[i]->displayTask();
+                task->completeTask();
+            } 
+            else 
+            {
+                task->taskStatus = newStatus;
             }
+            reindexTask(task);
+            cout << "Task status updated successfully.\n";
+            journalTask(taskId);
+            return true;
         }
-        bool isEmpty() const 
+        bool undo() 
         {
-            return size == 0;
+            OperationTimer timer(OP_UNDO);
+            UndoRecord lastAction;
+            if (!undoLog.pop(UndoLog::UNDO, lastAction)) 
+            {
+                cout << "Nothing to undo.\n";
+                timer.fail();
+                return false;
+            }
+            if (lastAction.fields & FIELD_COUNT) 
+            {
+                vector<int> touched = revertBatch(lastAction, UndoLog::REDO);
+                cout << "Undo successful.\n";
+                journalTasks(touched);
+                return true;
+            }
+            revert(lastAction, UndoLog::REDO);
+            cout << "Undo successful.\n";
+            journalTask(lastAction.taskId);
+            return true;
         }
-        
-        // Method to clear the queue - added for file handling
-        void clear()
+        bool redo() 
         {
-            size = 0;
+            OperationTimer timer(OP_REDO);
+            UndoRecord lastUndone;
+            if (!undoLog.pop(UndoLog::REDO, lastUndone)) 
+            {
+                cout << "Nothing to redo.\n";
+                timer.fail();
+                return false;
+            }
+            if (lastUndone.fields & FIELD_COUNT) 
+            {
+                vector<int> touched = revertBatch(lastUndone, UndoLog::UNDO);
+                cout << "Redo successful.\n";
+                journalTasks(touched);
+                return true;
+            }
+            revert(lastUndone, UndoLog::UNDO);
+            cout << "Redo successful.\n";
+            journalTask(lastUndone.taskId);
+            return true;
         }
-};
-
-class TaskHashMap 
-{
-    private:
-        Task* table[TABLE_SIZE];
-        int hashFunction(int taskID) const 
+        // Claims the task at the front of the queue for leaseSeconds. It is marked
+        // in progress and stays out of the queue until it is completed, its lease
+        // is released, or the lease runs out. Returns the task ID and sets
+        // leaseToken, or returns -1 if nothing is queued.
+        int claimNextTask(time_t leaseSeconds, uint64_t& leaseToken)
         {
-            return (taskID * 2654435761) % TABLE_SIZE;
+            Task* task = priorityQueue.top();
+            if (!task)
+            {
+                cout << "No tasks to claim.\n";
+                return -1;
+            }
+            leaseToken = leases.grant(task->taskId, time(0) + leaseSeconds);
+            task->taskStatus = IN_PROGRESS;
+            reindexTask(task);
+            cout << "Task claimed: " << task->taskName << " (ID: " << task->taskId << ", lease " << leaseToken << ")" << endl;
+            journalTask(task->taskId);
+            return task->taskId;
         }
-    public:
-        TaskHashMap() 
+        // Extends a lease the caller holds to leaseSeconds from now.
+        bool heartbeatTask(int taskId, uint64_t leaseToken, time_t leaseSeconds)
+        {
+            if (!leases.renew(taskId, leaseToken, time(0) + leaseSeconds))
+            {
+                cout << "Lease not held.\n";
+                return false;
+            }
+            return true;
+        }
+        // Ends a lease the caller holds: the task is completed, or returns to the
+        // queue as pending.
+        bool finishLeasedTask(int taskId, uint64_t leaseToken, bool completed)
+        {
+            if (!leases.holds(taskId, leaseToken))
+            {
+                cout << "Lease not held.\n";
+                return false;
+            }
+            Task* task = taskLookup.getTaskByID(taskId);
+            if (completed)
+                task->completeTask();
+            else
+                task->taskStatus = PENDING;
+            reindexTask(task);
+            cout << (completed ? "Task completed: " : "Task released: ") << task->taskName << " (ID: " << taskId << ")" << endl;
+            journalTask(taskId);
+            return true;
+        }
+        // Seconds until taskId's lease runs out, or -1 if it holds none.
+        long long getLeaseRemaining(int taskId) const
         {
-            for (int i = 0; i < TABLE_SIZE; i++)
-                table[i] = nullptr; 
+            time_t expiry = leases.expiryOf(taskId);
+            return expiry == 0 ? -1 : max<long long>(0, expiry - time(0));
         }
-        void insertTask(Task* task) 
+        // Puts tasks whose leases ran out back in the queue as pending. Expired
+        // leases are popped off the lease heap; no task is scanned.
+        void reclaimExpiredLeases()
         {
-            int index = hashFunction(task->taskId);
-            task->next = table[index];
-            table[index] = task;
+            leases.expire(time(0), [this](int taskId) {
+                Task* task = taskLookup.getTaskByID(taskId);
+                task->taskStatus = PENDING;
+                reindexTask(task);
+                cout << "Lease expired: " << task->taskName << " (ID: " << taskId << ") is back in the queue." << endl;
+                journalTask(taskId);
+            });
         }
-        Task* getTaskByID(int taskID) const 
+        // Adds a rule that creates a copy of this task at every time on schedule
+        // ("every N{s,m,h,d,w}" or "cron M H DOM MON DOW"); each copy is due
+        // dueAfter seconds after it is created (0: no due date). Only the rule is
+        // stored until then. Returns the rule ID, or -1 for a bad schedule.
+        int addRecurringTask(const string& name, const string& description, int priority, time_t dueAfter, const string& schedule)
         {
-            int index = hashFunction(taskID);
-            Task* current = table[index];
-            while (current) 
+            RecurrenceRule rule;
+            string error;
+            time_t now = time(0);
+            if (!rule.parseSchedule(schedule, now, error))
             {
-                if (current->taskId == taskID)
-                    return current;
-                current = current->next;
+                cout << "Invalid schedule: " << error << endl;
+                return -1;
             }
-            return nullptr;
+            if (rule.fireAfter(now - 1) == 0)
+            {
+                cout << "Invalid schedule: it never fires.\n";
+                return -1;
+            }
+            rule.name = name;
+            rule.description = description;
+            rule.priority = priority;
+            rule.dueAfter = dueAfter;
+            int ruleId = recurrence.add(std::move(rule), now);
+            cout << "Recurring task added: " << name << " (rule " << ruleId << ")" << endl;
+            saveRules();
+            materializeOccurrences();
+            return ruleId;
         }
-        bool deleteTask(int taskID) 
+        // Stops a rule; occurrences already created are kept.
+        bool removeRecurringTask(int ruleId)
         {
-            int index = hashFunction(taskID);
-            Task* current = table[index];
-            Task* prev = nullptr;
-            while (current) 
+            if (!recurrence.remove(ruleId))
             {
-                if (current->taskId == taskID) 
-                {
-                    if (prev) 
-                    {
-                        prev->next = current->next;
-                    } 
-                    else 
-                    {
-                        table[index] = current->next;  
-                    }
-                    return true;
-                }
-                prev = current;
-                current = current->next;
+                cout << "Recurring task not found.\n";
+                return false;
             }
-            return false;  
+            cout << "Recurring task removed.\n";
+            saveRules();
+            return true;
+        }
+        vector<const RecurrenceRule*> getRecurringTasks() const
+        {
+            return recurrence.list();
         }
-        void displayTasks() const 
+        void displayRecurringTasks() const
         {
-            cout << "\n--- Task HashMap ---\n";
-            bool isEmpty = true;    
-            for (int i = 0; i < TABLE_SIZE; i++) 
+            cout << "\n--- Recurring Tasks ---\n";
+            if (recurrence.size() == 0)
             {
-                if (table[i]) 
-                {
-                    isEmpty = false;
-                    Task* current = table[i];
-                    cout << "Bucket " << i << ": ";
-                    while (current) 
-                    {
-                        cout << "[ID: " << current->taskId << ", Name: " << current->taskName
-                            << ", Priority: " << current->taskPriority << "] -> ";
-                        current = current->next;
-                    }
-                    cout << "NULL\n";
-                }
+                cout << "No recurring tasks.\n";
+                return;
             }
-            if (isEmpty) 
+            for (const RecurrenceRule* rule : recurrence.list())
             {
-                cout << "No tasks in the hash map.\n";
+                char next[20] = "never";
+                if (rule->nextFire != 0)
+                    strftime(next, sizeof(next), "%Y-%m-%d %H:%M:%S", localtime(&rule->nextFire));
+                cout << "Rule ID: " << rule->ruleId << endl;
+                cout << "Task Name: " << rule->name << endl;
+                cout << "Task Description: " << rule->description << endl;
+                cout << "Task Priority: " << rule->priority << endl;
+                cout << "Schedule: " << rule->schedule << endl;
+                cout << "Next Occurrence: " << next << endl;
+                cout << "Occurrences So Far: " << rule->occurrences << endl;
+                cout << "------------------------" << endl;
             }
         }
-        
-        // Added for file handling - clear all entries
-        void clear()
+        // Creates a task for every rule whose time has come. Cheap when none has:
+        // the next fire time is the top of the rules' heap.
+        void materializeOccurrences()
         {
-            for (int i = 0; i < TABLE_SIZE; i++)
+            time_t now = time(0);
+            if (recurrence.nextFireTime() == 0 || recurrence.nextFireTime() > now) return;
+            int fired = recurrence.fireDue(now, [this](const RecurrenceRule& rule, time_t fireTime) {
+                int id = nextTaskId++;
+                insertTask(Task(id, rule.name, rule.description, PENDING, rule.priority, rule.dueAfter ? fireTime + rule.dueAfter : 0));
+                cout << "Recurring task created: " << rule.name << " (ID: " << id << ", rule " << rule.ruleId << ")" << endl;
+                journalTask(id);
+            });
+            if (fired > 0)
             {
-                table[i] = nullptr;
+                // The occurrences must be durable before the rules file says they happened.
+                journal.commit();
+                saveRules();
             }
         }
-};
-
-class TaskState 
-{
-    public:
-        int taskId;
-        string taskName;
-        string taskDescription;
-        TaskStatus taskStatus;
-        int taskPriority;
-        time_t taskDueDate;
-        time_t taskCreationDate;
-        time_t taskCompletionDate;
-        bool exists;
-        TaskState() : taskId(-1), exists(false) {}
-        TaskState(const Task& task, bool exists = true) 
-            : taskId(task.taskId), taskName(task.taskName), 
-            taskDescription(task.taskDescription), taskStatus(task.taskStatus),
-            taskPriority(task.taskPriority), taskDueDate(task.taskDueDate),
-            taskCreationDate(task.taskCreationDate), 
-            taskCompletionDate(task.taskCompletionDate),
-            exists(exists) {}
-};
-
-class StackNode 
-{
-    public:
-        TaskState taskState;
-        StackNode* next;
-        StackNode(const TaskState& ts) : taskState(ts), next(nullptr) {}
-};
-
-class TaskStack 
-{
-    private:
-        StackNode* top;
-    public:
-        TaskStack() : top(nullptr) {}
-        ~TaskStack() 
+        void displayAllTasks() const 
         {
-            while (!isEmpty()) 
+            if (taskStore.size() == 0) 
+            {
+                cout << "No tasks to display.\n";
+            }
+            else
             {
-                pop();
+                cout << "\n--- All Tasks ---\n";
+                for (int i = 0; i < taskStore.size(); i++) 
+                {
+                    taskStore.at(i)->displayTask();
+                }
+            }
+            if (archive.size() > 0)
+            {
+                cout << archive.size() << " completed tasks are archived; display them with Display Archived Tasks.\n";
             }
         }
-        void push(const TaskState& taskState) 
+        // Moves tasks completed at least age seconds ago out of memory into the
+        // archive, so the in-memory indexes only hold work that is still live,
+        // then checkpoints so the snapshot drops them too. Tasks are written in
+        // ID order, which appends to the tree. A task created already completed has
+        // no completion date and counts from its creation. Returns how many moved,
+        // or -1.
+        int archiveCompletedTasks(time_t age)
         {
-            StackNode* newNode = new StackNode(taskState);
-            newNode->next = top;
-            top = newNode;
+            if (!archive.isOpen())
+            {
+                cout << "The archive is not available.\n";
+                return -1;
+            }
+            time_t cutoff = time(0) - age;
+            vector<Task*> done;
+            for (Task* task = statusIndex.first(COMPLETED); task; task = StatusIndex::next(task))
+            {
+                time_t completed = task->taskCompletionDate != 0 ? task->taskCompletionDate : task->taskCreationDate;
+                if (completed <= cutoff)
+                    done.push_back(task);
+            }
+            if (done.empty()) return 0;
+            sort(done.begin(), done.end(), [](const Task* a, const Task* b) { return a->taskId < b->taskId; });
+            // The archive must be durable before the tasks leave memory; until the
+            // checkpoint they are in both, and memory wins.
+            bool stored = true;
+            for (Task* task : done)
+            {
+                stored = stored && archive.put(*task);
+            }
+            if (!stored || !archive.flush())
+            {
+                cerr << "Error: Archive: " << archive.error() << endl;
+                return -1;
+            }
+            for (Task* task : done)
+            {
+                changes.record(task->taskId);
+                eraseTask(task);
+            }
+            checkpoint();
+            cout << "Archived " << done.size() << " completed tasks." << endl;
+            return done.size();
         }
-        TaskState pop() 
+        // Lists archived tasks with IDs in [first, last], reading only the pages
+        // that hold them.
+        void displayArchivedTasks(int first, int last)
         {
-            if (isEmpty()) 
+            cout << "\n--- Archived Tasks ---\n";
+            int shown = 0;
+            bool ok = archive.isOpen() && archive.scan(first, last, [&](const Task& task) {
+                if (!taskLookup.getTaskByID(task.taskId))
+                {
+                    task.displayTask();
+                    shown++;
+                }
+                return true;
+            });
+            if (!ok && !archive.error().empty())
+            {
+                cerr << "Error: Archive: " << archive.error() << endl;
+            }
+            if (shown == 0)
             {
-                return TaskState(); 
+                cout << "No archived tasks in that range.\n";
             }
-            StackNode* temp = top;
-            TaskState taskState = temp->taskState;
-            top = top->next;
-            delete temp;
-            return taskState;
         }
-        bool isEmpty() const 
+        long long getArchivedTaskCount() const
         {
-            return top == nullptr;
+            return archive.size();
         }
-        void clear() 
+        void displayTasksByStatus(TaskStatus status) const 
         {
-            while (!isEmpty()) 
+            cout << "\n--- Tasks with Status: " << (status == PENDING ? "Pending" : (status == IN_PROGRESS ? "In Progress" : "Completed")) << " ---\n";
+            if (statusIndex.count(status) == 0) 
             {
-                pop();
+                cout << "No tasks with the specified status.\n";
+                return;
+            }
+            for (Task* task = statusIndex.first(status); task; task = StatusIndex::next(task)) 
+            {
+                task->displayTask();
             }
         }
-};
-
-class TaskScheduler 
-{
-    private:
-        Task** tasks;
-        int taskCount;
-        int maxTasks;
-        int nextTaskId;
-        PriorityQueue priorityQueue;
-        TaskHashMap taskLookup;   
-        TaskStack undoStack; 
-        TaskStack redoStack;
-        void recordForUndo(const Task* task, bool exists = true) 
+        void displayTasksByPriority() const 
         {
-            if (task) 
+            priorityQueue.display();
+        }
+        void setSchedulingPolicy(SchedulingPolicy policy)
+        {
+            priorityQueue.setPolicy(policy);
+            cout << "Tasks are now ordered by " << priorityQueue.policyName() << ".\n";
+        }
+        void displayTaskStructure() const 
+        {
+            taskLookup.displayTasks();
+        }
+        // Creates the recurring tasks that have come due and reclaims expired
+        // leases, then reports tasks whose due date has passed since the last check.
+        void checkDeadlines()
+        {
+            checkDeadlines([](Task* task) {
+                cout << "Overdue: " << task->taskName << " (ID: " << task->taskId << ") was due " << task->formatTime(task->taskDueDate) << endl;
+            });
+        }
+        template <typename Report>
+        void checkDeadlines(Report report)
+        {
+            reapBackgroundSave(false);
+            materializeOccurrences();
+            reclaimExpiredLeases();
+            dueWheel.advance(time(0), report);
+        }
+        void displayOverdueTasks()
+        {
+            checkDeadlines();
+            cout << "\n--- Overdue Tasks ---\n";
+            if (dueWheel.overdueCount() == 0)
             {
-                undoStack.push(TaskState(*task, exists));
-                redoStack.clear();
+                cout << "No overdue tasks.\n";
+                return;
             }
+            dueWheel.forEachOverdue([](Task* task) { task->displayTask(); });
         }
-        void updateNextTaskId(int taskId) 
+        void displayTasksDueWithin(int hours)
         {
-            if (taskId >= nextTaskId) 
+            checkDeadlines();
+            vector<Task*> dueSoon = getTasksDueWithin(hours);
+            cout << "\n--- Tasks Due Within " << hours << " Hours ---\n";
+            if (dueSoon.empty())
             {
-                nextTaskId = taskId + 1;
+                cout << "No tasks due in that window.\n";
+                return;
+            }
+            for (Task* task : dueSoon)
+            {
+                task->displayTask();
             }
         }
-    public:
-        TaskScheduler(int maxTaskCount = TABLE_SIZE) : taskCount(0), maxTasks(maxTaskCount), nextTaskId(1) 
+        vector<Task*> getTasksByStatus(TaskStatus status) const
+        {
+            vector<Task*> tasks;
+            for (Task* task = statusIndex.first(status); task; task = StatusIndex::next(task))
+                tasks.push_back(task);
+            return tasks;
+        }
+        vector<Task*> getTasksByPriority() const
+        {
+            return priorityQueue.tasksInOrder();
+        }
+        // As of the last checkDeadlines().
+        vector<Task*> getOverdueTasks() const
+        {
+            vector<Task*> overdue;
+            dueWheel.forEachOverdue([&](Task* task) { overdue.push_back(task); });
+            return overdue;
+        }
+        // Not yet overdue and due within hours, soonest first.
+        vector<Task*> getTasksDueWithin(int hours) const
+        {
+            vector<Task*> dueSoon;
+            dueWheel.forEachDueBefore(time(0) + (time_t)hours * 3600, [&](Task* task) { dueSoon.push_back(task); });
+            sort(dueSoon.begin(), dueSoon.end(), [](const Task* a, const Task* b) {
+                return a->taskDueDate < b->taskDueDate;
+            });
+            return dueSoon;
+        }
+        int getTaskCount() const 
         {
-            tasks = new Task*[maxTasks];
-            for (int i = 0; i < maxTasks; i++) 
+            return taskStore.size();
+        }
+        int getTaskCount(TaskStatus status) const 
+        {
+            return statusIndex.count(status);
+        }
+        Task* getTaskByIndex(int index) const 
+        {
+            return taskStore.at(index);
+        }
+        Task* getTaskByID(int taskId) const
+        {
+            return taskLookup.getTaskByID(taskId);
+        }
+        // Version of the most recent change; see ChangeLog.
+        uint64_t getVersion() const
+        {
+            return changes.version();
+        }
+        // IDs of tasks added, changed or removed after version since. Returns
+        // false if that is too far back to tell, in which case everything may
+        // have changed.
+        bool getChangesSince(uint64_t since, vector<int>& taskIds) const
+        {
+            return changes.changedSince(since, taskIds);
+        }
+        
+        // New methods for file handling
+        void clearTasks()
+        {
+            // The indexes read the stored tasks while clearing, so empty the store last.
+            taskLookup.clear();
+            priorityQueue.clear();
+            statusIndex.clear();
+            dueWheel.clear();
+            taskStore.clear();
+            nextTaskId = 1;
+            undoLog.clear();
+            leases.clear();
+            changes.reset();
+        }
+        // Writes a binary snapshot to a temporary file and renames it over
+        // SNAPSHOT_FILENAME, so a crash mid-write leaves the previous snapshot intact.
+        bool writeSnapshot(string& error) const
+        {
+            TaskSnapshotWriter writer;
+            writer.reserve(taskStore.size());
+            for (int i = 0; i < taskStore.size(); i++)
             {
-                tasks[i] = nullptr;
+                writer.add(*taskStore.at(i));
             }
+            return writer.write(SNAPSHOT_FILENAME, nextTaskId, error);
         }
-        ~TaskScheduler() 
+        bool saveTasks() const
         {
-            for (int i = 0; i < taskCount; i++) 
+            OperationTimer timer(OP_SAVE);
+            string error;
+            if (!writeSnapshot(error))
             {
-                if (tasks[i]) 
-                {
-                    delete tasks[i];
-                    tasks[i] = nullptr;
-                }
+                cerr << "Error: Could not write snapshot: " << error << endl;
+                timer.fail();
+                return false;
             }
-            delete[] tasks;
+            return true;
         }
-        void addTask(const string& name, const string& description, TaskStatus status, int priority, time_t dueDate) 
+        // Folds the journal into a fresh snapshot and starts an empty journal.
+        // A background save still running is waited for first, so its older
+        // snapshot cannot land on top of this one.
+        bool checkpoint()
         {
-            if (taskCount >= maxTasks) 
+            reapBackgroundSave(true);
+            if (snapshotBlocked() || !saveTasks())
             {
-                cerr << "Task limit reached. Cannot add more tasks.\n";
-                return;
+                journal.commit();
+                return false;
             }
-            int id = nextTaskId++;
-            Task* newTask = new Task(id, name, description, status, priority, dueDate);
-            tasks[taskCount++] = newTask;
-            taskLookup.insertTask(newTask);
-            priorityQueue.insert(newTask);
-            recordForUndo(newTask);
-            cout << "Task added: " << name << " (ID: " << id << ")" << endl;
-            
-            // Save tasks after adding
-            saveTasks();
+            if (unlink(JOURNAL_SEGMENT_FILENAME.c_str()) != 0 && errno != ENOENT)
+            {
+                cerr << "Error: Could not remove " << JOURNAL_SEGMENT_FILENAME << ": " << strerror(errno) << endl;
+            }
+            return journal.truncate();
         }
-        void removeTask(int taskId) 
+        // Checkpoints without stalling the caller, in the manner of Redis's
+        // BGSAVE: the journal so far is rotated aside and a forked child writes
+        // the snapshot from its copy-on-write image of memory, fsyncs and renames
+        // it, while this process carries on journaling into a fresh file. The
+        // caller only pays for the rotation and fork(). A save asked for while
+        // one runs is coalesced into a single save after it. Falls back to a
+        // synchronous checkpoint if the fork fails.
+        bool backgroundSave()
         {
-            Task* taskToRemove = taskLookup.getTaskByID(taskId);    
-            if (!taskToRemove) 
+            reapBackgroundSave(false);
+            if (saverPid != -1)
             {
-                cout << "Task not found.\n";
-                return;
+                saveRequested = true;
+                return true;
+            }
+            if (snapshotBlocked()) return false;
+            OperationTimer timer(OP_BACKGROUND_SAVE);
+            if (!journal.rotate(JOURNAL_SEGMENT_FILENAME))
+            {
+                timer.fail();
+                return false;
             }
-            recordForUndo(taskToRemove, false);
-            priorityQueue.removeTask(taskId);
-            taskLookup.deleteTask(taskId);
-            int indexToRemove = -1;
-            for (int i = 0; i < taskCount; i++) 
+            pid_t pid = fork();
+            if (pid == 0)
             {
-                if (tasks[i] && tasks[i]->taskId == taskId) 
-                {
-                    indexToRemove = i;
-                    break;
-                }
+                // Only write the snapshot: _exit skips destructors and buffered
+                // output that belong to the parent.
+                string error;
+                bool ok = writeSnapshot(error);
+                if (!ok)
+                    cerr << "Error: Background save could not write snapshot: " << error << endl;
+                _exit(ok ? 0 : 1);
             }
-            if (indexToRemove != -1) 
+            if (pid == -1)
             {
-                delete tasks[indexToRemove];
-                if (indexToRemove < taskCount - 1) 
-                {
-                    tasks[indexToRemove] = tasks[taskCount - 1];
-                }
-                tasks[taskCount - 1] = nullptr;
-                taskCount--;
+                cerr << "Error: Could not start background save: " << strerror(errno) << endl;
+                timer.fail();
+                return checkpoint();
             }
-            cout << "Task removed successfully.\n";
-            
-            // Save tasks after removing
-            saveTasks();
+            saverPid = pid;
+            return true;
         }
-        void modifyTask(int taskId, const string& newName, const string& newDescription, TaskStatus newStatus, int newPriority, time_t newDueDate) 
+        // A damaged snapshot is never overwritten: until the user restores or
+        // removes it, checkpoints are refused, changes stay in the journal and
+        // every load recovers what it can from the damaged copy again.
+        bool snapshotBlocked() const
         {
-            Task* task = taskLookup.getTaskByID(taskId);
-            if (!task) 
+            if (!snapshotStuck && access(DAMAGED_SNAPSHOT_FILENAME.c_str(), F_OK) != 0) return false;
+            cerr << "Error: Not saving over the damaged snapshot in " << (snapshotStuck ? SNAPSHOT_FILENAME : DAMAGED_SNAPSHOT_FILENAME)
+                << ". Repair it, or remove it and save again to keep the tasks recovered from it; until then changes are kept in "
+                << JOURNAL_FILENAME << "." << endl;
+            return true;
+        }
+        bool isBackgroundSaveRunning() const
+        {
+            return saverPid != -1;
+        }
+        // Collects a finished background save, waiting for it if wait is set.
+        // On success the rotated journal is covered by the snapshot and deleted;
+        // on failure it stays and is folded into the next save. Unless waiting,
+        // starts the save that was coalesced while this one ran.
+        void reapBackgroundSave(bool wait)
+        {
+            if (saverPid == -1) return;
+            int status = 0;
+            pid_t done;
+            while ((done = waitpid(saverPid, &status, wait ? 0 : WNOHANG)) == -1 && errno == EINTR) {}
+            if (done == 0) return;
+            saverPid = -1;
+            if (done == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
             {
-                cout << "Task not found.\n";
-                return;
+                cerr << "Error: Background save failed; its changes stay in " << JOURNAL_SEGMENT_FILENAME << "." << endl;
             }
-            recordForUndo(task);
-            task->taskName = newName;
-            task->taskDescription = newDescription;
-            if (newStatus == COMPLETED && task->taskStatus != COMPLETED) 
+            else if (unlink(JOURNAL_SEGMENT_FILENAME.c_str()) != 0 && errno != ENOENT)
             {
-                task->completeTask();
-            } 
-            else 
+                cerr << "Error: Could not remove " << JOURNAL_SEGMENT_FILENAME << ": " << strerror(errno) << endl;
+            }
+            if (saveRequested && !wait)
             {
-                task->taskStatus = newStatus;
+                saveRequested = false;
+                backgroundSave();
             }
-            bool needPriorityUpdate = (task->taskPriority != newPriority);
-            task->taskPriority = newPriority;
-            task->taskDueDate = newDueDate;
-            priorityQueue.updateTask(task);
-            cout << "Task modified successfully.\n";
-            
-            // Save tasks after modifying
-            saveTasks();
         }
-        void changeTaskStatus(int taskId, TaskStatus newStatus) 
+        // Like the snapshot, a damaged rules file is never saved over.
+        bool saveRules() const
         {
-            Task* task = taskLookup.getTaskByID(taskId);
-            if (!task) 
+            if (rulesStuck || access(DAMAGED_RULES_FILENAME.c_str(), F_OK) == 0)
             {
-                cout << "Task not found.\n";
-                return;
+                cerr << "Error: Not saving recurring tasks over the damaged " << (rulesStuck ? RULES_FILENAME : DAMAGED_RULES_FILENAME)
+                    << ". Repair it, or remove it to start over with the rules defined since." << endl;
+                return false;
             }
-            recordForUndo(task);
-            if (newStatus == COMPLETED && task->taskStatus != COMPLETED) 
-            {
-                task->completeTask();
-            } 
-            else 
+            if (!recurrence.save(RULES_FILENAME))
             {
-                task->taskStatus = newStatus;
+                cerr << "Error: Could not write " << RULES_FILENAME << "." << endl;
+                return false;
             }
-            priorityQueue.updateTask(task);
-            cout << "Task status updated successfully.\n";
-            
-            // Save tasks after changing status
-            saveTasks();
+            return true;
+        }
+        // Makes every journaled change durable; the command loop calls this before blocking on input.
+        bool commitJournal()
+        {
+            return journal.commit();
         }
-        void undo() 
+        
+        // Recovery: the last snapshot plus every change journaled since, the
+        // rotated journal of an unfinished background save first.
+        bool loadTasks()
         {
-            if (undoStack.isEmpty()) 
+            OperationTimer timer(OP_LOAD);
+            reapBackgroundSave(true);
+            saveRequested = false;
+            string error;
+            rulesStuck = false;
+            if (!recurrence.load(RULES_FILENAME, error))
             {
-                cout << "Nothing to undo.\n";
-                return;
+                cerr << "Error: " << error << endl;
+                setFileAside(RULES_FILENAME, DAMAGED_RULES_FILENAME, rulesStuck);
             }
-            TaskState lastAction = undoStack.pop();
-            if (lastAction.exists) 
-            {
-                Task* currentTask = taskLookup.getTaskByID(lastAction.taskId);
-                if (currentTask) 
-                {
-                    redoStack.push(TaskState(*currentTask));    
-                    currentTask->taskName = lastAction.taskName;
-                    currentTask->taskDescription = lastAction.taskDescription;
-                    currentTask->taskStatus = lastAction.taskStatus;
-                    currentTask->taskPriority = lastAction.taskPriority;
-                    currentTask->taskDueDate = lastAction.taskDueDate;
-                    currentTask->taskCreationDate = lastAction.taskCreationDate;
-                    currentTask->taskCompletionDate = lastAction.taskCompletionDate;
-                    priorityQueue.updateTask(currentTask);
-                } 
-                else 
-                {
-                    Task* newTask = new Task(lastAction.taskId, lastAction.taskName, lastAction.taskDescription, lastAction.taskStatus, lastAction.taskPriority, lastAction.taskDueDate);
-                    newTask->taskCreationDate = lastAction.taskCreationDate;
-                    newTask->taskCompletionDate = lastAction.taskCompletionDate;  
-                    updateNextTaskId(lastAction.taskId);
-                    if (taskCount < maxTasks) 
-                    {
-                        tasks[taskCount++] = newTask;
-                        taskLookup.insertTask(newTask);
-                        priorityQueue.insert(newTask);    
-                        redoStack.push(TaskState(*newTask, false)); 
-                    } 
-                    else 
-                    {
-                        cout << "Cannot undo - task limit reached.\n";
-                        delete newTask;
-                        return;
-                    }
-                }
-            } 
-            else 
+            if (!archive.isOpen() && !archive.open(ARCHIVE_FILENAME))
             {
-                Task* taskToDelete = taskLookup.getTaskByID(lastAction.taskId);
-                if (taskToDelete) 
-                {
-                    redoStack.push(TaskState(*taskToDelete));    
-                    priorityQueue.removeTask(lastAction.taskId);
-                    taskLookup.deleteTask(lastAction.taskId);
-                    for (int i = 0; i < taskCount; i++) 
-                    {
-                        if (tasks[i] && tasks[i]->taskId == lastAction.taskId) 
-                        {
-                            delete tasks[i];
-                            if (i < taskCount - 1) 
-                            {
-                                tasks[i] = tasks[taskCount - 1];
-                            }
-                            tasks[taskCount - 1] = nullptr;
-                            taskCount--;
-                            break;
-                        }
-                    }
-                }
+                cerr << "Error: Archive: " << archive.error() << endl;
             }
-            cout << "Undo successful.\n";
-            
-            // Save tasks after undo
-            saveTasks();
-        }
-        void redo() 
-        {
-            if (redoStack.isEmpty()) 
+            bool loaded = loadSnapshot();
+            TaskJournal segment(JOURNAL_SEGMENT_FILENAME);
+            int replayed = 0;
+            for (TaskJournal* log : { &segment, &journal })
             {
-                cout << "Nothing to redo.\n";
-                return;
+                replayed += log->replay(
+                    [this](const Task& task) { restoreTask(task); },
+                    [this](int taskId) { discardTask(taskId); },
+                    nextTaskId);
             }
-            TaskState lastUndone = redoStack.pop();
-            if (lastUndone.exists) 
+            if (replayed > 0)
             {
-                Task* currentTask = taskLookup.getTaskByID(lastUndone.taskId);    
-                if (currentTask) 
-                {
-                    undoStack.push(TaskState(*currentTask));
-                    currentTask->taskName = lastUndone.taskName;
-                    currentTask->taskDescription = lastUndone.taskDescription;
-                    currentTask->taskStatus = lastUndone.taskStatus;
-                    currentTask->taskPriority = lastUndone.taskPriority;
-                    currentTask->taskDueDate = lastUndone.taskDueDate;
-                    currentTask->taskCreationDate = lastUndone.taskCreationDate;
-                    currentTask->taskCompletionDate = lastUndone.taskCompletionDate;    
-                    priorityQueue.updateTask(currentTask);
-                } 
-                else 
-                {
-                    Task* newTask = new Task(lastUndone.taskId, lastUndone.taskName, lastUndone.taskDescription, lastUndone.taskStatus, lastUndone.taskPriority, lastUndone.taskDueDate);
-                    newTask->taskCreationDate = lastUndone.taskCreationDate;
-                    newTask->taskCompletionDate = lastUndone.taskCompletionDate;
-                    updateNextTaskId(lastUndone.taskId);
-                    if (taskCount < maxTasks) 
-                    {
-                        tasks[taskCount++] = newTask;
-                        taskLookup.insertTask(newTask);
-                        priorityQueue.insert(newTask);    
-                        undoStack.push(TaskState(*newTask, false));
-                    } 
-                    else 
-                    {
-                        cout << "Cannot redo - task limit reached.\n";
-                        delete newTask;
-                        return;
-                    }
-                }
-            } 
-            else 
+                cout << "Replayed " << replayed << " journaled changes." << endl;
+            }
+            if (archive.isOpen())
             {
-                Task* taskToDelete = taskLookup.getTaskByID(lastUndone.taskId);
-                if (taskToDelete) 
-                {
-                    undoStack.push(TaskState(*taskToDelete));    
-                    priorityQueue.removeTask(lastUndone.taskId);
-                    taskLookup.deleteTask(lastUndone.taskId);
-                    for (int i = 0; i < taskCount; i++) 
-                    {
-                        if (tasks[i] && tasks[i]->taskId == lastUndone.taskId) 
-                        {
-                            delete tasks[i];
-                            if (i < taskCount - 1) 
-                            {
-                                tasks[i] = tasks[taskCount - 1];
-                            }
-                            tasks[taskCount - 1] = nullptr;
-                            taskCount--;
-                            break;
-                        }
-                    }
-                }
+                archiveCompletedTasks(ARCHIVE_AFTER);
             }
-            cout << "Redo successful.\n";
-            
-            // Save tasks after redo
-            saveTasks();
+            return loaded || replayed > 0;
         }
-        void displayAllTasks() const 
+        
+        bool loadSnapshot()
         {
-            if (taskCount == 0) 
+            clearTasks();
+            snapshotStuck = false;
+            
+            // A snapshot set aside as damaged stands in for a missing one until the user deals with it.
+            bool present = access(SNAPSHOT_FILENAME.c_str(), F_OK) == 0;
+            const string& path = present ? SNAPSHOT_FILENAME : DAMAGED_SNAPSHOT_FILENAME;
+            if (!present && access(DAMAGED_SNAPSHOT_FILENAME.c_str(), F_OK) != 0)
             {
-                cout << "No tasks to display.\n";
-                return;
+                // No binary snapshot yet - pick up a tasks.txt from an older version
+                ifstream legacy(FILENAME);
+                if (legacy.is_open())
+                {
+                    legacy.close();
+                    return importTasks(FILENAME);
+                }
+                cout << "No saved tasks found or could not open file." << endl;
+                return false;
             }
-            cout << "\n--- All Tasks ---\n";
-            for (int i = 0; i < taskCount; i++) 
+            TaskSnapshotReader reader;
+            string error;
+            bool opened = reader.open(path, error);
+            bool intact = opened && present && reader.verify(error);
+            if (!intact)
             {
-                if (tasks[i]) 
+                if (present)
+                {
+                    cerr << "Error: " << error << endl;
+                    setFileAside(SNAPSHOT_FILENAME, DAMAGED_SNAPSHOT_FILENAME, snapshotStuck);
+                }
+                if (!opened)
                 {
-                    tasks[i]->displayTask();
+                    cerr << "Error: No tasks could be recovered from the damaged snapshot." << endl;
+                    return false;
                 }
             }
-        }
-        void displayTasksByStatus(TaskStatus status) const 
-        {
-            cout << "\n--- Tasks with Status: " << (status == PENDING ? "Pending" : (status == IN_PROGRESS ? "In Progress" : "Completed")) << " ---\n";
-            bool found = false;
-            for (int i = 0; i < taskCount; i++) 
+            nextTaskId = reader.nextTaskId();
+            taskStore.reserve(reader.taskCount());
+            Task task;
+            uint32_t skipped = 0;
+            for (uint32_t i = 0; i < reader.taskCount(); i++)
             {
-                if (tasks[i] && tasks[i]->taskStatus == status) 
+                // Records of a damaged snapshot are loaded if they still make sense.
+                if (!intact && (!reader.recordValid(i) || taskLookup.getTaskByID(reader.record(i).taskId)))
                 {
-                    tasks[i]->displayTask();
-                    found = true;
+                    skipped++;
+                    continue;
                 }
+                reader.readTask(i, task);
+                updateNextTaskId(task.taskId);
+                insertTask(task);
             }
-            if (!found) 
+            if (!intact)
             {
-                cout << "No tasks with the specified status.\n";
+                cerr << "Warning: Recovered " << taskStore.size() << " of " << reader.taskCount()
+                    << " tasks from the damaged snapshot (" << skipped << " unreadable)." << endl;
             }
+            cout << "Loaded " << taskStore.size() << " tasks from file." << endl;
+            return true;
         }
-        void displayTasksByPriority() const 
-        {
-            priorityQueue.display();
-        }
-        void displayTaskStructure() const 
-        {
-            taskLookup.displayTasks();
-        }
-        int getTaskCount() const 
-        {
-            return taskCount;
-        }
-        Task* getTaskByIndex(int index) const 
+        // Renames a file that failed to load to damagedPath so it survives for
+        // the user. An older damaged copy already there is not replaced; saves
+        // wait on it either way. stuck is set when path has to stay put.
+        static void setFileAside(const string& path, const string& damagedPath, bool& stuck)
         {
-            if (index >= 0 && index < taskCount) 
+            if (access(damagedPath.c_str(), F_OK) == 0)
+            {
+                stuck = true;
+                return;
+            }
+            if (rename(path.c_str(), damagedPath.c_str()) != 0)
             {
-                return tasks[index];
+                cerr << "Error: Could not rename " << path << ": " << strerror(errno) << endl;
+                stuck = true;
+                return;
             }
-            return nullptr;
+            cerr << "The damaged " << path << " was moved to " << damagedPath << "." << endl;
         }
         
-        // New methods for file handling
-        bool saveTasks() const
+        // Text format - kept as a human-readable export/import path
+        bool exportTasks(const string& fileName) const
         {
-            ofstream outFile(FILENAME);
+            OperationTimer timer(OP_EXPORT);
+            string tempName = fileName + ".tmp";
+            ofstream outFile(tempName);
             if (!outFile.is_open())
             {
                 cerr << "Error: Could not open file for writing." << endl;
+                timer.fail();
                 return false;
             }
             
+            // Archived tasks are exported too; the count comes first, so they are
+            // scanned once to count them and once to write them.
+            long long archived = 0;
+            auto unshadowed = [this](const Task& task) { return !taskLookup.getTaskByID(task.taskId); };
+            bool scanned = !archive.isOpen() || archive.scan(0, INT_MAX, [&](const Task& task) {
+                archived += unshadowed(task);
+                return true;
+            });
+
             // First, write the next task ID and task count
             outFile << nextTaskId << endl;
-            outFile << taskCount << endl;
+            outFile << taskStore.size() + archived << endl;
             
             // Then write each task's data
-            for (int i = 0; i < taskCount; i++)
+            for (int i = 0; i < taskStore.size(); i++)
             {
-                if (tasks[i])
-                {
-                    tasks[i]->writeToFile(outFile);
-                }
+                taskStore.at(i)->writeToFile(outFile);
             }
+            scanned = scanned && (!archive.isOpen() || archive.scan(0, INT_MAX, [&](const Task& task) {
+                if (unshadowed(task))
+                    task.writeToFile(outFile);
+                return true;
+            }));
             
             outFile.close();
+            if (!scanned)
+            {
+                cerr << "Error: Archive: " << archive.error() << endl;
+            }
+            if (!scanned || outFile.fail() || rename(tempName.c_str(), fileName.c_str()) != 0)
+            {
+                cerr << "Error: Could not write " << fileName << "." << endl;
+                timer.fail();
+                return false;
+            }
             return true;
         }
         
-        bool loadTasks()
+        // Replaces every task with the contents of a text export. Records are parsed
+        // in parallel straight from the mapped file, copied into store slots in
+        // parallel, and then indexed in one pass with a single heap build.
+        // Nothing in memory or in the archive is touched unless the whole file
+        // parses and every ID is positive and distinct.
+        bool importTasks(const string& fileName)
         {
-            ifstream inFile(FILENAME);
-            if (!inFile.is_open())
+            OperationTimer timer(OP_IMPORT);
+            TaskTextReader reader;
+            string error;
+            vector<int> ids;
+            if (!reader.open(fileName, error) || !reader.parse(error) || !checkImportIds(reader.tasks(), ids, error))
             {
-                cout << "No saved tasks found or could not open file." << endl;
+                cerr << "Error: " << error << endl;
+                timer.fail();
                 return false;
             }
-            
-            // Clear existing data
-            for (int i = 0; i < taskCount; i++)
+            if (archive.isOpen() && !archive.clear())
             {
-                if (tasks[i])
+                cerr << "Error: Archive: " << archive.error() << endl;
+                timer.fail();
+                return false;
+            }
+            clearTasks();
+            nextTaskId = max(reader.nextTaskId(), ids.empty() ? 1 : ids.back() + 1);
+
+            const vector<TaskRecordView>& records = reader.tasks();
+            vector<Task*> stored;
+            taskStore.addEmpty(records.size(), stored);
+            parallelRanges(records.size(), 0, 1 << 14, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; i++)
                 {
-                    delete tasks[i];
-                    tasks[i] = nullptr;
+                    const TaskRecordView& record = records[i];
+                    Task& task = *stored[i];
+                    task.taskId = record.taskId;
+                    task.taskName.assign(record.name);
+                    task.taskDescription.assign(record.description);
+                    task.taskStatus = record.status;
+                    task.taskPriority = record.priority;
+                    task.taskDueDate = record.dueDate;
+                    task.taskCreationDate = record.creationDate;
+                    task.taskCompletionDate = record.completionDate;
                 }
-            }
-            taskCount = 0;
-            nextTaskId = 1;
-            taskLookup.clear();
-            priorityQueue.clear();
-            
-            // Read next task ID and task count
-            inFile >> nextTaskId;
-            inFile >> taskCount;
-            inFile.ignore(); // Skip newline
-            
-            // Check if task count is valid
-            if (taskCount > maxTasks)
+            });
+
+            taskLookup.reserve(stored.size());
+            vector<Task*> queued;
+            queued.reserve(stored.size());
+            for (Task* task : stored)
             {
-                cerr << "Error: Task count in file exceeds maximum." << endl;
-                taskCount = 0;
-                inFile.close();
-                return false;
+                indexTask(task);
+                if (task->taskStatus != COMPLETED)
+                    queued.push_back(task);
             }
-            
-            // Read tasks
-            for (int i = 0; i < taskCount; i++)
+            priorityQueue.insertAll(queued.data(), queued.size());
+            cout << "Loaded " << taskStore.size() << " tasks from file." << endl;
+            return true;
+        }
+        // Sorted IDs of records, or false with error set if one is not positive
+        // or appears twice.
+        static bool checkImportIds(const vector<TaskRecordView>& records, vector<int>& ids, string& error)
+        {
+            ids.reserve(records.size());
+            for (const TaskRecordView& record : records)
+                ids.push_back(record.taskId);
+            sort(ids.begin(), ids.end());
+            if (!ids.empty() && ids.front() <= 0)
+                error = "Invalid task ID " + to_string(ids.front()) + " in file.";
+            else
             {
-                Task* newTask = new Task();
-                if (newTask->readFromFile(inFile))
+                auto duplicate = adjacent_find(ids.begin(), ids.end());
+                if (duplicate == ids.end())
+                    return true;
+                error = "Task ID " + to_string(*duplicate) + " appears twice in file.";
+            }
+            return false;
+        }
+};
+
+volatile sig_atomic_t stopServer = 0;
+
+void requestStop(int)
+{
+    stopServer = 1;
+}
+
+// Serves the web UI (index.html and script.js from the working directory) and
+// the JSON API on 127.0.0.1 until interrupted. Tasks are loaded, journaled and
+// checkpointed as in an interactive session.
+int serve(TaskScheduler& scheduler, int port)
+{
+    HttpServer server;
+    string error;
+    if (!server.listen(port, error))
+    {
+        cerr << "Error: " << error << endl;
+        return 1;
+    }
+    scheduler.loadTasks();
+    signal(SIGINT, requestStop);
+    signal(SIGTERM, requestStop);
+    cout << "Serving http://127.0.0.1:" << server.port() << "/ (Ctrl+C to stop)" << endl;
+
+    TaskApi<TaskScheduler> api(scheduler, ".");
+    server.run(
+        [&](const HttpRequest& request, HttpResponse& response) {
+            api.handle(request, response, [&](const HttpRequest& request, HttpResponse& response) {
+                if (request.method == "POST" && request.path == "/api/save")
+                {
+                    if (scheduler.checkpoint())
+                        api.ok(response);
+                    else
+                        api.error(response, 500, "failed to save tasks");
+                }
+                else if (request.method == "POST" && request.path == "/api/bgsave")
+                {
+                    if (scheduler.backgroundSave())
+                        api.ok(response);
+                    else
+                        api.error(response, 500, "failed to start background save");
+                }
+                else if (request.method == "POST" && request.path == "/api/load")
                 {
-                    tasks[i] = newTask;
-                    taskLookup.insertTask(newTask);
-                    priorityQueue.insert(newTask);
+                    if (scheduler.loadTasks())
+                        api.ok(response);
+                    else
+                        api.error(response, 404, "no saved tasks found");
                 }
                 else
                 {
-                    delete newTask;
-                    taskCount = i;
-                    cerr << "Error: Failed to read task " << i + 1 << " from file." << endl;
-                    break;
+                    return false;
                 }
-            }
-            
-            inFile.close();
-            cout << "Loaded " << taskCount << " tasks from file." << endl;
-            return true;
-        }
-};
+                return true;
+            });
+        },
+        [&]() { scheduler.commitJournal(); },
+        [&]() { scheduler.checkDeadlines(); },
+        stopServer);
 
-int main() 
+    scheduler.checkpoint();
+    cout << "Tasks saved. Server stopped." << endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) 
 {
     TaskScheduler scheduler;
     int choice = 0;
     
+    if (argc > 1 && string(argv[1]) == "--serve")
+    {
+        int port = 8080;
+        if (argc > 3 || (argc == 3 && (!parseNumber(argv[2], port) || port < 0 || port > 65535)))
+        {
+            cerr << "Usage: " << argv[0] << " --serve [PORT]\n";
+            return 2;
+        }
+        return serve(scheduler, port);
+    }
+    BatchOptions options;
+    if (!parseBatchOptions(argc, argv, options))
+    {
+        cerr << "Usage: " << argv[0] << " [--batch] [--json] [FILE] | --serve [PORT]\n";
+        return 2;
+    }
+    if (options.enabled)
+    {
+        ios::sync_with_stdio(false);
+        ifstream file;
+        if (!options.file.empty())
+        {
+            file.open(options.file);
+            if (!file)
+            {
+                cerr << "Error: cannot open " << options.file << endl;
+                return 1;
+            }
+        }
+        istream& input = options.file.empty() ? cin : file;
+        // Same persistence as an interactive session: load at start, journal
+        // each change, checkpoint at the end.
+        BatchSession session(options.json);
+        scheduler.loadTasks();
+        int failures = session.run(scheduler, input, [&](const vector<string>& args, BatchReply& reply) {
+            const string& command = args[0];
+            if (command == "save")
+            {
+                if (!scheduler.checkpoint())
+                    reply.fail("failed to save tasks");
+            }
+            else if (command == "bgsave")
+            {
+                if (!scheduler.backgroundSave())
+                    reply.fail("failed to start background save");
+            }
+            else if (command == "load")
+            {
+                // Changes so far are journaled but not yet written; reload them too.
+                if (!scheduler.commitJournal() || !scheduler.loadTasks())
+                    reply.fail("failed to load tasks");
+            }
+            else if (command == "export" || command == "import")
+            {
+                if (args.size() > 2)
+                {
+                    reply.fail("usage: " + command + " [FILE]");
+                    return true;
+                }
+                string fileName = args.size() == 2 ? args[1] : FILENAME;
+                bool ok = command == "export" ? scheduler.exportTasks(fileName) : scheduler.importTasks(fileName) && scheduler.checkpoint();
+                if (!ok)
+                    reply.fail("failed to " + command + " " + fileName);
+            }
+            else if (command == "archive")
+            {
+                // archive [DAYS]: move tasks completed at least DAYS ago (default 7) to disk
+                int days = ARCHIVE_AFTER / (24 * 3600);
+                if (args.size() > 2 || (args.size() == 2 && (!parseNumber(args[1], days) || days < 0)))
+                    reply.fail("usage: archive [DAYS]");
+                else if (scheduler.archiveCompletedTasks((time_t)days * 24 * 3600) < 0)
+                    reply.fail("failed to archive tasks");
+            }
+            else if (command == "archived")
+            {
+                // archived [FIRST [LAST]]: list archived tasks by ID range
+                int first = 0, last = INT_MAX;
+                if (args.size() > 3 || (args.size() >= 2 && !parseNumber(args[1], first)) ||
+                    (args.size() == 3 && !parseNumber(args[2], last)))
+                    reply.fail("usage: archived [FIRST [LAST]]");
+                else
+                {
+                    scheduler.displayArchivedTasks(first, last);
+                    reply.output = session.capturedOutput();
+                }
+            }
+            else
+            {
+                return false;
+            }
+            return true;
+        });
+        scheduler.commitJournal();
+        scheduler.checkpoint();
+        return failures == 0 ? 0 : 1;
+    }
+
     // Load tasks at start
     scheduler.loadTasks();
     
     while (true) 
     {
+        scheduler.checkDeadlines();
         cout << "\n===== TASK SCHEDULER MENU =====\n";
         cout << "1. Add New Task\n";
         cout << "2. Remove Task\n";
@@ -872,14 +1407,32 @@ int main()
         cout << "10. Redo Last Action\n";
         cout << "11. Save Tasks to File\n";  // Added option
         cout << "12. Load Tasks from File\n"; // Added option
+        cout << "13. Export Tasks to Text File\n";
+        cout << "14. Import Tasks from Text File\n";
+        cout << "15. Display Overdue Tasks\n";
+        cout << "16. Display Tasks Due Soon\n";
+        cout << "17. Change Scheduling Policy\n";
+        cout << "18. Display Operation Statistics\n";
+        cout << "19. Add Recurring Task\n";
+        cout << "20. Display Recurring Tasks\n";
+        cout << "21. Remove Recurring Task\n";
+        cout << "22. Archive Completed Tasks\n";
+        cout << "23. Display Archived Tasks\n";
+        cout << "24. Save Tasks in the Background\n";
         cout << "0. Exit\n";
         cout << "Enter your choice: ";
-        cin >> choice;
+        scheduler.commitJournal();
+        if (!(cin >> choice))
+        {
+            // End of input exits; anything else that is not a number is an invalid choice
+            choice = cin.eof() ? 0 : -1;
+            cin.clear();
+        }
         cin.ignore();
         if (choice == 0) 
         {
             // Save tasks before exiting
-            scheduler.saveTasks();
+            scheduler.checkpoint();
             cout << "Tasks saved. Exiting Task Scheduler. Goodbye!\n";
             return 0;
         }
@@ -1000,7 +1553,7 @@ int main()
         }
         else if (choice == 11) 
         {
-            if (scheduler.saveTasks())
+            if (scheduler.checkpoint())
             {
                 cout << "Tasks saved to file successfully.\n";
             }
@@ -1020,6 +1573,124 @@ int main()
                 cout << "Failed to load tasks from file or no saved tasks found.\n";
             }
         }
+        else if (choice == 13 || choice == 14) 
+        {
+            string fileName;
+            cout << "Enter file name (blank for " << FILENAME << "): ";
+            getline(cin, fileName);
+            if (fileName.empty())
+            {
+                fileName = FILENAME;
+            }
+            if (choice == 13 && scheduler.exportTasks(fileName))
+            {
+                cout << "Tasks exported to " << fileName << ".\n";
+            }
+            else if (choice == 14 && scheduler.importTasks(fileName) && scheduler.checkpoint())
+            {
+                cout << "Tasks imported from " << fileName << ".\n";
+            }
+            else
+            {
+                cout << "Operation failed.\n";
+            }
+            continue;
+        }
+        else if (choice == 15) 
+        {
+            scheduler.displayOverdueTasks();
+        }
+        else if (choice == 16) 
+        {
+            int hours;
+            cout << "Show tasks due within how many hours? ";
+            cin >> hours;
+            scheduler.displayTasksDueWithin(hours);
+        }
+        else if (choice == 17) 
+        {
+            int policy;
+            cout << "Order by (0: Priority, 1: Due Date, 2: Priority then Due Date, 3: Weighted): ";
+            cin >> policy;
+            if (policy < POLICY_PRIORITY || policy > POLICY_WEIGHTED)
+            {
+                cout << "Invalid policy.\n";
+            }
+            else
+            {
+                scheduler.setSchedulingPolicy((SchedulingPolicy)policy);
+            }
+        }
+        else if (choice == 18) 
+        {
+            writeMetricsTable(cout);
+        }
+        else if (choice == 19) 
+        {
+            string taskName, taskDescription, dueAfter, schedule;
+            int taskPriority;
+            time_t dueSeconds;
+            cout << "Enter task name: ";
+            getline(cin, taskName);
+            cout << "Enter task description: ";
+            getline(cin, taskDescription);
+            cout << "Enter task priority (1-5): ";
+            cin >> taskPriority;
+            cin.ignore();
+            cout << "Due how long after each occurrence is created (e.g. 12h, 0 for no due date): ";
+            getline(cin, dueAfter);
+            cout << "Repeat (every N followed by s, m, h, d or w, or cron M H DOM MON DOW): ";
+            getline(cin, schedule);
+            if (RecurrenceRule::parseDuration(dueAfter, dueSeconds))
+            {
+                scheduler.addRecurringTask(taskName, taskDescription, taskPriority, dueSeconds, schedule);
+            }
+            else
+            {
+                cout << "Invalid duration. Recurring task not added.\n";
+            }
+            continue;
+        }
+        else if (choice == 20) 
+        {
+            scheduler.displayRecurringTasks();
+        }
+        else if (choice == 21) 
+        {
+            int ruleId;
+            cout << "Enter rule ID to remove: ";
+            cin >> ruleId;
+            scheduler.removeRecurringTask(ruleId);
+        }
+        else if (choice == 22) 
+        {
+            int days;
+            cout << "Archive tasks completed at least how many days ago? ";
+            cin >> days;
+            scheduler.archiveCompletedTasks((time_t)days * 24 * 3600);
+        }
+        else if (choice == 23) 
+        {
+            int first, last;
+            cout << "Enter first and last task ID: ";
+            cin >> first >> last;
+            scheduler.displayArchivedTasks(first, last);
+        }
+        else if (choice == 24) 
+        {
+            if (scheduler.isBackgroundSaveRunning())
+            {
+                cout << "A background save is already running; another will follow it.\n";
+            }
+            if (scheduler.backgroundSave())
+            {
+                cout << "Saving tasks in the background.\n";
+            }
+            else
+            {
+                cout << "Failed to start background save.\n";
+            }
+        }
         else 
         {
             cout << "Invalid choice. Please try again.\n";
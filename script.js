@@ -1,127 +1,34 @@
-// Command pattern for undo/redo functionality
-class CommandManager {
-  constructor() {
-    this.undoStack = [];
-    this.redoStack = [];
-  }
-
-  execute(command) {
-    command.execute();
-    this.undoStack.push(command);
-    // Clear redo stack when a new command is executed
-    this.redoStack = [];
-  }
-
-  undo() {
-    if (this.undoStack.length === 0) return false;
-
-    const command = this.undoStack.pop();
-    command.undo();
-    this.redoStack.push(command);
-    return true;
-  }
-
-  redo() {
-    if (this.redoStack.length === 0) return false;
-
-    const command = this.redoStack.pop();
-    command.execute();
-    this.undoStack.push(command);
-    return true;
-  }
-
-  canUndo() {
-    return this.undoStack.length > 0;
-  }
-
-  canRedo() {
-    return this.redoStack.length > 0;
-  }
-
-  clear() {
-    this.undoStack = [];
-    this.redoStack = [];
-  }
-}
-
-// Command classes for different task operations
-class AddTaskCommand {
-  constructor(taskSystem, task) {
-    this.taskSystem = taskSystem;
-    this.task = task;
-  }
-
-  execute() {
-    this.taskSystem.addTaskWithoutHistory(this.task);
-  }
-
-  undo() {
-    this.taskSystem.removeTaskWithoutHistory(this.task.taskId);
-  }
-}
-
-class ModifyTaskCommand {
-  constructor(taskSystem, taskId, newValues, oldValues) {
-    this.taskSystem = taskSystem;
-    this.taskId = taskId;
-    this.newValues = newValues;
-    this.oldValues = oldValues;
-  }
-
-  execute() {
-    this.taskSystem.modifyTaskWithoutHistory(this.taskId, this.newValues);
-  }
-
-  undo() {
-    this.taskSystem.modifyTaskWithoutHistory(this.taskId, this.oldValues);
-  }
-}
-
-class RemoveTaskCommand {
-  constructor(taskSystem, task) {
-    this.taskSystem = taskSystem;
-    this.task = task;
-  }
-
-  execute() {
-    this.taskSystem.removeTaskWithoutHistory(this.task.taskId);
-  }
-
-  undo() {
-    this.taskSystem.addTaskWithoutHistory(this.task);
-  }
-}
-
-class ChangeTaskStatusCommand {
-  constructor(taskSystem, taskId, newStatus, oldStatus, oldCompletionDate) {
-    this.taskSystem = taskSystem;
-    this.taskId = taskId;
-    this.newStatus = newStatus;
-    this.oldStatus = oldStatus;
-    this.oldCompletionDate = oldCompletionDate;
-  }
-
-  execute() {
-    this.taskSystem.changeTaskStatusWithoutHistory(this.taskId, this.newStatus);
-  }
-
-  undo() {
-    this.taskSystem.changeTaskStatusWithoutHistory(
-      this.taskId,
-      this.oldStatus,
-      this.oldCompletionDate
-    );
-  }
-}
+// The tasks live in the C++ scheduler (main2 --serve), which also serves this
+// page. Every change is a request to it; the page then asks for the tasks
+// changed since the last version it saw, so only deltas cross the wire.
+const api = {
+  async request(method, path, body) {
+    // The server only accepts changes sent as JSON, which a page on another
+    // origin cannot do without a preflight the server never approves.
+    const options = { method, headers: {} };
+    if (method !== "GET") options.headers["Content-Type"] = "application/json";
+    if (body !== undefined) options.body = JSON.stringify(body);
+    let response;
+    try {
+      response = await fetch(path, options);
+    } catch (error) {
+      throw new Error("Cannot reach the task server");
+    }
+    const result = await response.json();
+    if (!result.ok) throw new Error(result.error);
+    return result;
+  },
+};
 
 // Modifications to the existing script
 document.addEventListener("DOMContentLoaded", function () {
-  // Task data store
-  let tasks = [];
-  let nextTaskId = 1;
-
-  // Command manager for undo/redo
-  const commandManager = new CommandManager();
+  // Task data store, keyed by ID, as of server version `version`
+  const tasks = new Map();
+  let version = 0;
+  // Number of tasks per status (0 Pending, 1 In Progress, 2 Completed), kept in
+  // step with every change so the summary cards never rescan the task list
+  let statusCounts = [0, 0, 0];
+  const STATUS_CODES = { pending: 0, in_progress: 1, completed: 2 };
 
   // DOM elements
   const tabs = document.querySelectorAll(".tab");
@@ -139,116 +46,114 @@ document.addEventListener("DOMContentLoaded", function () {
   const changeStatusForm = document.getElementById("changeStatusForm");
   const toast = document.getElementById("toast");
 
-  // TaskSystem object to handle operations with and without history
-  const taskSystem = {
-    // Methods that go through command history
-    addTask(task) {
-      const command = new AddTaskCommand(this, task);
-      commandManager.execute(command);
-      this.updateUndoRedoButtons();
-      refreshTasks();
-      saveTasks();
-    },
-
-    modifyTask(taskId, newValues) {
-      const taskIndex = tasks.findIndex((t) => t.taskId === taskId);
-      if (taskIndex !== -1) {
-        const oldValues = { ...tasks[taskIndex] };
-        const command = new ModifyTaskCommand(
-          this,
-          taskId,
-          newValues,
-          oldValues
-        );
-        commandManager.execute(command);
-        this.updateUndoRedoButtons();
-        refreshTasks();
-        saveTasks();
-      }
-    },
-
-    removeTask(taskId) {
-      const taskIndex = tasks.findIndex((t) => t.taskId === taskId);
-      if (taskIndex !== -1) {
-        const task = { ...tasks[taskIndex] };
-        const command = new RemoveTaskCommand(this, task);
-        commandManager.execute(command);
-        this.updateUndoRedoButtons();
-        refreshTasks();
-        saveTasks();
+  function fromServer(t) {
+    return {
+      taskId: t.id,
+      taskName: t.name,
+      taskDescription: t.description,
+      taskStatus: STATUS_CODES[t.status],
+      taskPriority: t.priority,
+      taskDueDate: t.due,
+      taskCreationDate: t.created,
+      taskCompletionDate: t.completed,
+    };
+  }
+
+  function toServer(values) {
+    return {
+      name: values.taskName,
+      description: values.taskDescription,
+      priority: values.taskPriority,
+      status: values.taskStatus,
+      due: Math.floor(values.taskDueDate),
+    };
+  }
+
+  // Applies the changes since `version`; re-renders only if there were any
+  async function fetchChanges() {
+    const delta = await api.request("GET", `/api/changes?since=${version}`);
+    if (delta.reset) {
+      tasks.clear();
+      statusCounts = [0, 0, 0];
+    }
+    delta.tasks.forEach((t) => {
+      const task = fromServer(t);
+      const old = tasks.get(task.taskId);
+      if (old) statusCounts[old.taskStatus]--;
+      statusCounts[task.taskStatus]++;
+      tasks.set(task.taskId, task);
+    });
+    delta.removed.forEach((taskId) => {
+      const old = tasks.get(taskId);
+      if (old) {
+        statusCounts[old.taskStatus]--;
+        tasks.delete(taskId);
       }
-    },
+    });
+    version = delta.version;
+    if (delta.reset || delta.tasks.length > 0 || delta.removed.length > 0) {
+      refreshTasks();
+    }
+  }
 
-    changeTaskStatus(taskId, newStatus) {
-      const taskIndex = tasks.findIndex((t) => t.taskId === taskId);
-      if (taskIndex !== -1) {
-        const oldStatus = tasks[taskIndex].taskStatus;
-        const oldCompletionDate = tasks[taskIndex].taskCompletionDate;
-        const command = new ChangeTaskStatusCommand(
-          this,
-          taskId,
-          newStatus,
-          oldStatus,
-          oldCompletionDate
-        );
-        commandManager.execute(command);
-        this.updateUndoRedoButtons();
-        refreshTasks();
-        saveTasks();
-      }
-    },
+  // Syncs run one at a time, in the order they were asked for
+  let syncQueue = Promise.resolve();
+  function syncTasks() {
+    syncQueue = syncQueue.then(fetchChanges).catch((error) => {
+      showToast(error.message, true);
+    });
+    return syncQueue;
+  }
 
-    // Methods that bypass command history
-    addTaskWithoutHistory(task) {
-      tasks.push(task);
-      if (task.taskId >= nextTaskId) {
-        nextTaskId = task.taskId + 1;
+  // TaskSystem object: each operation is a request, followed by a sync
+  const taskSystem = {
+    async perform(method, path, body, message) {
+      try {
+        await api.request(method, path, body);
+        await syncTasks();
+        showToast(message);
+        return true;
+      } catch (error) {
+        showToast(error.message, true);
+        return false;
       }
-      showToast(`Task "${task.taskName}" added successfully`);
     },
 
-    modifyTaskWithoutHistory(taskId, values) {
-      const taskIndex = tasks.findIndex((t) => t.taskId === taskId);
-      if (taskIndex !== -1) {
-        // Update all fields from values
-        Object.keys(values).forEach((key) => {
-          tasks[taskIndex][key] = values[key];
-        });
-        showToast(`Task "${tasks[taskIndex].taskName}" modified successfully`);
-      }
+    addTask(values) {
+      return this.perform(
+        "POST",
+        "/api/tasks",
+        toServer(values),
+        `Task "${values.taskName}" added successfully`
+      );
     },
 
-    removeTaskWithoutHistory(taskId) {
-      const taskIndex = tasks.findIndex((t) => t.taskId === taskId);
-      if (taskIndex !== -1) {
-        const taskName = tasks[taskIndex].taskName;
-        tasks.splice(taskIndex, 1);
-        showToast(`Task "${taskName}" removed successfully`);
-      }
+    modifyTask(taskId, values) {
+      return this.perform(
+        "PUT",
+        `/api/tasks/${taskId}`,
+        toServer(values),
+        `Task "${values.taskName}" modified successfully`
+      );
     },
 
-    changeTaskStatusWithoutHistory(taskId, newStatus, completionDate = null) {
-      const taskIndex = tasks.findIndex((t) => t.taskId === taskId);
-      if (taskIndex !== -1) {
-        const task = tasks[taskIndex];
-        task.taskStatus = newStatus;
-
-        // Handle completion date
-        if (completionDate !== null) {
-          task.taskCompletionDate = completionDate;
-        } else if (newStatus === 2 && task.taskCompletionDate === 0) {
-          task.taskCompletionDate = Math.floor(Date.now() / 1000);
-        } else if (newStatus !== 2) {
-          task.taskCompletionDate = 0;
-        }
-
-        showToast(`Task status updated successfully`);
-      }
+    removeTask(taskId) {
+      const task = tasks.get(taskId);
+      return this.perform(
+        "DELETE",
+        `/api/tasks/${taskId}`,
+        undefined,
+        `Task "${task ? task.taskName : taskId}" removed successfully`
+      );
     },
 
-    updateUndoRedoButtons() {
-      undoBtn.disabled = !commandManager.canUndo();
-      redoBtn.disabled = !commandManager.canRedo();
+    changeTaskStatus(taskId, newStatus) {
+      return this.perform(
+        "PUT",
+        `/api/tasks/${taskId}/status`,
+        { status: newStatus },
+        "Task status updated successfully"
+      );
     },
   };
 
@@ -291,30 +196,14 @@ document.addEventListener("DOMContentLoaded", function () {
     taskModal.style.display = "flex";
   });
 
-  // Initialize undo/redo buttons
-  undoBtn.disabled = true;
-  redoBtn.disabled = true;
-
   // Undo button
   undoBtn.addEventListener("click", function () {
-    if (commandManager.undo()) {
-      taskSystem.updateUndoRedoButtons();
-      refreshTasks();
-      showToast("Undo operation performed");
-    } else {
-      showToast("Nothing to undo", true);
-    }
+    taskSystem.perform("POST", "/api/undo", undefined, "Undo operation performed");
   });
 
   // Redo button
   redoBtn.addEventListener("click", function () {
-    if (commandManager.redo()) {
-      taskSystem.updateUndoRedoButtons();
-      refreshTasks();
-      showToast("Redo operation performed");
-    } else {
-      showToast("Nothing to redo", true);
-    }
+    taskSystem.perform("POST", "/api/redo", undefined, "Redo operation performed");
   });
 
   // Save tasks button
@@ -342,30 +231,22 @@ document.addEventListener("DOMContentLoaded", function () {
 
     if (taskId) {
       // Edit existing task
-      const newValues = {
+      taskSystem.modifyTask(parseInt(taskId), {
         taskName,
         taskDescription,
         taskPriority,
         taskStatus,
         taskDueDate: taskDueDate.getTime() / 1000,
-        taskCompletionDate:
-          taskStatus === 2 ? Math.floor(Date.now() / 1000) : 0,
-      };
-      taskSystem.modifyTask(parseInt(taskId), newValues);
+      });
     } else {
       // Add new task
-      const task = {
-        taskId: nextTaskId++,
+      taskSystem.addTask({
         taskName,
         taskDescription,
         taskStatus,
         taskPriority,
         taskDueDate: taskDueDate.getTime() / 1000,
-        taskCreationDate: Math.floor(Date.now() / 1000),
-        taskCompletionDate:
-          taskStatus === 2 ? Math.floor(Date.now() / 1000) : 0,
-      };
-      taskSystem.addTask(task);
+      });
     }
 
     taskModal.style.display = "none";
@@ -382,70 +263,53 @@ document.addEventListener("DOMContentLoaded", function () {
     changeStatusModal.style.display = "none";
   });
 
-  // Save tasks to localStorage (simulating file storage)
-  function saveTasks() {
+  // Checkpoint the scheduler's tasks to disk
+  async function saveTasks() {
     try {
-      localStorage.setItem("tasks", JSON.stringify(tasks));
-      localStorage.setItem("nextTaskId", nextTaskId.toString());
+      await api.request("POST", "/api/save");
       showToast("Tasks saved successfully");
     } catch (error) {
-      showToast("Failed to save tasks", true);
-      console.error("Error saving tasks:", error);
+      showToast(`Failed to save tasks: ${error.message}`, true);
     }
   }
 
-  // Load tasks from localStorage (simulating file loading)
-  function loadTasks() {
+  // Reload the scheduler's tasks from disk; the next sync resends them all
+  async function loadTasks() {
     try {
-      const savedTasks = localStorage.getItem("tasks");
-      const savedNextTaskId = localStorage.getItem("nextTaskId");
-
-      if (savedTasks && savedNextTaskId) {
-        tasks = JSON.parse(savedTasks);
-        nextTaskId = parseInt(savedNextTaskId);
-        // Clear command history when loading tasks
-        commandManager.clear();
-        taskSystem.updateUndoRedoButtons();
-        showToast(`Loaded ${tasks.length} tasks successfully`);
-        refreshTasks();
-      } else {
-        showToast("No saved tasks found", true);
-      }
+      await api.request("POST", "/api/load");
+      await syncTasks();
+      showToast(`Loaded ${tasks.size} tasks successfully`);
     } catch (error) {
-      showToast("Failed to load tasks", true);
-      console.error("Error loading tasks:", error);
+      showToast(`Failed to load tasks: ${error.message}`, true);
     }
   }
 
   // Update task counts in summary cards
   function updateTaskCounts() {
-    document.getElementById("totalTasksCount").textContent = tasks.length;
-    document.getElementById("pendingTasksCount").textContent = tasks.filter(
-      (t) => t.taskStatus === 0
-    ).length;
-    document.getElementById("inProgressTasksCount").textContent = tasks.filter(
-      (t) => t.taskStatus === 1
-    ).length;
-    document.getElementById("completedTasksCount").textContent = tasks.filter(
-      (t) => t.taskStatus === 2
-    ).length;
+    document.getElementById("totalTasksCount").textContent = tasks.size;
+    document.getElementById("pendingTasksCount").textContent = statusCounts[0];
+    document.getElementById("inProgressTasksCount").textContent =
+      statusCounts[1];
+    document.getElementById("completedTasksCount").textContent =
+      statusCounts[2];
   }
 
   // Refresh task lists
   function refreshTasks() {
     updateTaskCounts();
+    const taskList = [...tasks.values()];
 
     // All tasks
     const allTasksBody = document.getElementById("all-tasks-body");
     allTasksBody.innerHTML = "";
-    tasks.forEach((task) => {
+    taskList.forEach((task) => {
       allTasksBody.appendChild(createTaskRow(task));
     });
 
     // Pending tasks
     const pendingTasksBody = document.getElementById("pending-tasks-body");
     pendingTasksBody.innerHTML = "";
-    tasks
+    taskList
       .filter((t) => t.taskStatus === 0)
       .forEach((task) => {
         pendingTasksBody.appendChild(createTaskRow(task, false));
@@ -456,7 +320,7 @@ document.addEventListener("DOMContentLoaded", function () {
       "in-progress-tasks-body"
     );
     inProgressTasksBody.innerHTML = "";
-    tasks
+    taskList
       .filter((t) => t.taskStatus === 1)
       .forEach((task) => {
         inProgressTasksBody.appendChild(createTaskRow(task, false));
@@ -465,7 +329,7 @@ document.addEventListener("DOMContentLoaded", function () {
     // Completed tasks
     const completedTasksBody = document.getElementById("completed-tasks-body");
     completedTasksBody.innerHTML = "";
-    tasks
+    taskList
       .filter((t) => t.taskStatus === 2)
       .forEach((task) => {
         completedTasksBody.appendChild(createCompletedTaskRow(task));
@@ -474,7 +338,7 @@ document.addEventListener("DOMContentLoaded", function () {
     // Priority view (sorted by priority descending)
     const priorityTasksBody = document.getElementById("priority-tasks-body");
     priorityTasksBody.innerHTML = "";
-    [...tasks]
+    [...taskList]
       .sort((a, b) => b.taskPriority - a.taskPriority)
       .forEach((task) => {
         priorityTasksBody.appendChild(createTaskRow(task));
@@ -676,10 +540,10 @@ document.addEventListener("DOMContentLoaded", function () {
     }
 
     content.innerHTML = `
-        <h3>${task.taskName}</h3>
+        <h3>${escapeHtml(task.taskName)}</h3>
         <p><strong>ID:</strong> ${task.taskId}</p>
         <p><strong>Description:</strong></p>
-        <p>${task.taskDescription}</p>
+        <p>${escapeHtml(task.taskDescription)}</p>
         <p><strong>Priority:</strong> ${task.taskPriority}</p>
         <p><strong>Status:</strong> ${statusText}</p>
         <p><strong>Due Date:</strong> ${formatDate(task.taskDueDate)}</p>
@@ -721,6 +585,12 @@ document.addEventListener("DOMContentLoaded", function () {
     }, 3000);
   }
 
+  // Text for use inside innerHTML
+  function escapeHtml(text) {
+    const escapes = { "&": "&amp;", "<": "&lt;", ">": "&gt;", '"': "&quot;", "'": "&#39;" };
+    return String(text).replace(/[&<>"']/g, (c) => escapes[c]);
+  }
+
   // Format date for display
   function formatDate(timestamp) {
     const date = new Date(timestamp * 1000);
@@ -735,68 +605,11 @@ document.addEventListener("DOMContentLoaded", function () {
     return `${year}-${month}-${day}`;
   }
 
-  // Initialize app - load tasks or create sample tasks
+  // Initialize app - fetch every task, then poll for changes made elsewhere
   function initApp() {
-    // Try to load tasks from storage
-    const savedTasks = localStorage.getItem("tasks");
-    const savedNextTaskId = localStorage.getItem("nextTaskId");
-
-    if (savedTasks && savedNextTaskId) {
-      tasks = JSON.parse(savedTasks);
-      nextTaskId = parseInt(savedNextTaskId);
-    } else {
-      // Create sample tasks
-      const today = new Date();
-      const tomorrow = new Date();
-      tomorrow.setDate(tomorrow.getDate() + 1);
-      const nextWeek = new Date();
-      nextWeek.setDate(nextWeek.getDate() + 7);
-
-      // Sample tasks
-      const task1 = {
-        taskId: nextTaskId++,
-        taskName: "Complete project proposal",
-        taskDescription:
-          "Write a detailed proposal for the new client project including timeline and budget estimates.",
-        taskStatus: 0, // Pending
-        taskPriority: 4, // High priority
-        taskDueDate: tomorrow.getTime() / 1000,
-        taskCreationDate: Math.floor(Date.now() / 1000),
-        taskCompletionDate: 0,
-      };
-
-      const task2 = {
-        taskId: nextTaskId++,
-        taskName: "Team meeting preparation",
-        taskDescription:
-          "Prepare slides and agenda for the weekly team meeting.",
-        taskStatus: 1, // In Progress
-        taskPriority: 3, // Medium priority
-        taskDueDate: today.getTime() / 1000,
-        taskCreationDate: Math.floor(Date.now() / 1000),
-        taskCompletionDate: 0,
-      };
-
-      const task3 = {
-        taskId: nextTaskId++,
-        taskName: "Research new technologies",
-        taskDescription:
-          "Research and document potential new technologies for the upcoming development phase.",
-        taskStatus: 0, // Pending
-        taskPriority: 2, // Low priority
-        taskDueDate: nextWeek.getTime() / 1000,
-        taskCreationDate: Math.floor(Date.now() / 1000),
-        taskCompletionDate: 0,
-      };
-
-      tasks.push(task1, task2, task3);
-    }
-
-    // Initially disable undo/redo buttons
-    taskSystem.updateUndoRedoButtons();
-
-    // Refresh task lists
     refreshTasks();
+    syncTasks();
+    setInterval(syncTasks, 2000);
   }
 
   // Initialize the app
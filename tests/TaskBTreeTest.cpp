@@ -0,0 +1,368 @@
+// Checks TaskBTree against a std::map holding the same tasks: random puts,
+// replacements, removals, lookups and range scans, with records long enough
+// to need overflow chains, enough keys to split internal nodes, and the file
+// closed and reopened along the way. A small page cache keeps pages moving in
+// and out of memory. A child process killed while archiving checks that the
+// rollback journal returns the file to its last flushed state.
+//
+//   cmake --build build --target taskbtree_test
+//   ./taskbtree_test [seed]        (default seed: 1)
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "TaskBTree.h"
+
+static int failures = 0;
+
+static bool expect(bool condition, const string& what)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "FAIL: %s\n", what.c_str());
+        failures++;
+    }
+    return condition;
+}
+
+static string treePath()
+{
+    const char* tmp = getenv("TMPDIR");
+    return string(tmp ? tmp : "/tmp") + "/taskbtree_test." + to_string(getpid()) + ".tree";
+}
+
+static void removeTree(const string& path)
+{
+    unlink(path.c_str());
+    unlink((path + ".rollback").c_str());
+}
+
+static long long fileSize(const string& path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? info.st_size : -1;
+}
+
+// Most descriptions fit in a leaf; about one in twenty spans overflow pages.
+static Task makeTask(mt19937& rng, int id)
+{
+    size_t length = rng() % 20 == 0 ? rng() % (3 * BufferPool::PAGE_SIZE) : rng() % 120;
+    string description(length, (char)('a' + rng() % 26));
+    Task task(id, "task " + to_string(id), description, COMPLETED, (int)(rng() % 21) - 10, rng() % 100000);
+    task.taskCreationDate = rng() % 100000;
+    task.taskCompletionDate = rng() % 100000;
+    return task;
+}
+
+static bool sameTask(const Task& a, const Task& b)
+{
+    return a.taskId == b.taskId && a.taskName.view() == b.taskName.view() &&
+        a.taskDescription.view() == b.taskDescription.view() && a.taskStatus == b.taskStatus &&
+        a.taskPriority == b.taskPriority && a.taskDueDate == b.taskDueDate &&
+        a.taskCreationDate == b.taskCreationDate && a.taskCompletionDate == b.taskCompletionDate;
+}
+
+// Whether tree holds exactly the tasks in expected.
+static bool holds(TaskBTree& tree, const map<int, Task>& expected)
+{
+    auto it = expected.begin();
+    bool matched = true;
+    bool ok = tree.scan(INT_MIN, INT_MAX, [&](const Task& task) {
+        matched = it != expected.end() && sameTask(task, it->second);
+        if (matched) ++it;
+        return matched;
+    });
+    return ok && matched && it == expected.end() && tree.size() == expected.size();
+}
+
+// Scans [first, last] and compares the result with the same range of expected.
+static void expectRange(TaskBTree& tree, const map<int, Task>& expected, int first, int last, const string& when)
+{
+    auto it = expected.lower_bound(first);
+    bool matched = true;
+    bool ok = tree.scan(first, last, [&](const Task& task) {
+        matched = it != expected.end() && it->first <= last && sameTask(task, it->second);
+        if (matched) ++it;
+        return matched;
+    });
+    expect(ok, when + ": scan failed: " + tree.error());
+    expect(matched && (it == expected.end() || it->first > last),
+        when + ": scan of [" + to_string(first) + ", " + to_string(last) + "] differs");
+}
+
+static void expectContents(TaskBTree& tree, const map<int, Task>& expected, const string& when)
+{
+    expect(tree.size() == expected.size(), when + ": size " + to_string(tree.size()) + ", expected " + to_string(expected.size()));
+    expectRange(tree, expected, INT_MIN, INT_MAX, when);
+}
+
+// Random operations over a key range small enough for frequent replacements.
+static void testRandomOperations(unsigned seed)
+{
+    string path = treePath();
+    removeTree(path);
+    mt19937 rng(seed);
+    map<int, Task> expected;
+    unique_ptr<TaskBTree> tree(new TaskBTree(16));
+    expect(tree->open(path), "open: " + tree->error());
+    for (int op = 1; op <= 60000 && failures == 0; op++)
+    {
+        int id = rng() % 20000;
+        unsigned kind = rng() % 10;
+        if (kind < 6)
+        {
+            Task task = makeTask(rng, id);
+            if (expect(tree->put(task), "put " + to_string(id) + ": " + tree->error()))
+                expected[id] = task;
+        }
+        else if (kind < 8)
+        {
+            bool stored = expected.erase(id) > 0;
+            expect(tree->remove(id) == stored, "remove " + to_string(id) + " should return " + (stored ? "true" : "false"));
+        }
+        else if (kind < 9)
+        {
+            Task task;
+            auto it = expected.find(id);
+            bool found = tree->get(id, task);
+            expect(found == (it != expected.end()), "get " + to_string(id) + ": " + tree->error());
+            if (found && it != expected.end())
+                expect(sameTask(task, it->second), "get " + to_string(id) + " returned different fields");
+        }
+        else
+        {
+            int first = rng() % 20000;
+            expectRange(*tree, expected, first, first + rng() % 500, "random scan");
+        }
+        if (op % 10000 == 0)
+        {
+            expect(tree->flush(), "flush: " + tree->error());
+            tree.reset(new TaskBTree(16));
+            expect(tree->open(path), "reopen: " + tree->error());
+            expectContents(*tree, expected, "after reopen at op " + to_string(op));
+        }
+    }
+    expectContents(*tree, expected, "after random operations");
+    tree.reset();
+    removeTree(path);
+}
+
+// IDs in ascending order, as archiving writes them: the tree grows several
+// levels and appends leave full leaves, so the file stays close to the data.
+static void testSequentialAppend()
+{
+    string path = treePath();
+    removeTree(path);
+    mt19937 rng(7);
+    map<int, Task> expected;
+    {
+        TaskBTree tree(16);
+        expect(tree.open(path), "open: " + tree.error());
+        size_t bytes = 0;
+        for (int id = 1; id <= 200000; id++)
+        {
+            Task task(id, "t" + to_string(id), "done", COMPLETED, id % 7, 0);
+            if (!expect(tree.put(task), "append " + to_string(id) + ": " + tree.error())) break;
+            expected.emplace(id, task);
+            bytes += 40 + 8 + task.taskName.view().size() + 4;
+        }
+        expect(tree.flush(), "flush: " + tree.error());
+        expect(fileSize(path) < (long long)(bytes * 1.25) + 16 * (long long)BufferPool::PAGE_SIZE,
+            "appended leaves are not full: " + to_string(fileSize(path)) + " bytes for " + to_string(bytes) + " of records");
+    }
+    TaskBTree tree(16);
+    expect(tree.open(path), "reopen: " + tree.error());
+    expectContents(tree, expected, "after sequential append");
+    Task task;
+    expect(tree.get(123456, task) && sameTask(task, expected[123456]), "get after reopen: " + tree.error());
+    expect(!tree.get(0, task) && !tree.get(200001, task) && tree.error().empty(), "get of a missing ID");
+    removeTree(path);
+}
+
+// Replacing and removing records with overflow chains returns their pages to
+// the free list, so churn does not grow the file.
+static void testOverflowReuse()
+{
+    string path = treePath();
+    removeTree(path);
+    mt19937 rng(11);
+    map<int, Task> expected;
+    TaskBTree tree(16);
+    expect(tree.open(path), "open: " + tree.error());
+    auto longTask = [&](int id, size_t length) {
+        return Task(id, "long " + to_string(id), string(length, (char)('A' + id % 26)), COMPLETED, 1, 0);
+    };
+    for (int id = 1; id <= 50; id++)
+    {
+        expected[id] = longTask(id, 3 * BufferPool::PAGE_SIZE);
+        expect(tree.put(expected[id]), "put long " + to_string(id) + ": " + tree.error());
+    }
+    expect(tree.flush(), "flush: " + tree.error());
+    long long grown = fileSize(path);
+    for (int round = 0; round < 20; round++)
+    {
+        for (int id = 1; id <= 50; id++)
+        {
+            // Alternate between inline and overflow records of different lengths.
+            size_t length = (round + id) % 2 ? rng() % 100 : rng() % (3 * BufferPool::PAGE_SIZE);
+            expected[id] = longTask(id, length);
+            expect(tree.put(expected[id]), "replace " + to_string(id) + ": " + tree.error());
+        }
+        for (int id = 1; id <= 50; id += 7)
+        {
+            expect(tree.remove(id), "remove " + to_string(id));
+            expected.erase(id);
+            expected[id] = longTask(id, 3 * BufferPool::PAGE_SIZE);
+            expect(tree.put(expected[id]), "put back " + to_string(id) + ": " + tree.error());
+        }
+        expect(tree.flush(), "flush: " + tree.error());
+    }
+    expectContents(tree, expected, "after overflow churn");
+    expect(fileSize(path) <= grown + 4 * (long long)BufferPool::PAGE_SIZE,
+        "freed overflow pages were not reused: file grew from " + to_string(grown) + " to " + to_string(fileSize(path)));
+    removeTree(path);
+}
+
+// A page whose bytes change on disk fails its checksum instead of being used.
+static void testCorruptPage()
+{
+    string path = treePath();
+    removeTree(path);
+    {
+        TaskBTree tree;
+        expect(tree.open(path), "open: " + tree.error());
+        expect(tree.put(Task(1, "one", "first", COMPLETED, 1, 0)), "put: " + tree.error());
+        expect(tree.flush(), "flush: " + tree.error());
+    }
+    int fd = ::open(path.c_str(), O_RDWR);
+    char byte = 0x5a;
+    expect(fd != -1 && pwrite(fd, &byte, 1, BufferPool::PAGE_SIZE + 100) == 1, "could not damage the tree file");
+    ::close(fd);
+    TaskBTree tree;
+    Task task;
+    expect(tree.open(path), "open: " + tree.error());
+    expect(!tree.get(1, task) && tree.error().find("checksum") != string::npos, "damaged leaf was read without an error");
+    removeTree(path);
+}
+
+// One archiving pass, as main2 runs it: new tasks in ID order, some long
+// enough for overflow pages, plus tasks brought back out of the archive
+// (removed) and archived again with new contents (replaced), which rewrite
+// old leaves and free and reuse pages. Applied to expected, and to tree if
+// given; returns false if the tree reported an error.
+static bool archivePass(mt19937& rng, int pass, map<int, Task>& expected, TaskBTree* tree)
+{
+    for (int i = 0; i < 150; i++)
+    {
+        int id = pass * 1000 + i;
+        Task task = makeTask(rng, id);
+        expected[id] = task;
+        if (tree && !tree->put(task)) return false;
+    }
+    for (int i = 0; i < 40 && !expected.empty(); i++)
+    {
+        int id = (int)(rng() % (pass * 1000));
+        auto it = expected.lower_bound(id);
+        if (it == expected.end()) continue;
+        id = it->first;
+        if (rng() % 2)
+        {
+            expected.erase(it);
+            if (tree && !tree->remove(id)) return false;
+        }
+        else
+        {
+            Task task = makeTask(rng, id);
+            expected[id] = task;
+            if (tree && !tree->put(task)) return false;
+        }
+    }
+    return true;
+}
+
+// Kills a child part way through archive passes, usually with dirty pages
+// already evicted to the file, and reopens the tree. It must hold exactly the
+// tasks of the last pass the child reported flushed, or of the one after if
+// the kill came between that flush and the report.
+static void testCrashRecovery(unsigned seed)
+{
+    mt19937 delays(seed);
+    for (int round = 0; round < 20; round++)
+    {
+        string path = treePath();
+        removeTree(path);
+        int reports[2];
+        if (!expect(pipe(reports) == 0, "pipe failed")) return;
+        pid_t child = fork();
+        if (child == 0)
+        {
+            ::close(reports[0]);
+            mt19937 rng(seed + round);
+            map<int, Task> expected;
+            TaskBTree tree(8);
+            if (!tree.open(path)) _exit(2);
+            for (int pass = 1; ; pass++)
+            {
+                if (!archivePass(rng, pass, expected, &tree) || !tree.flush()) _exit(2);
+                if (write(reports[1], &pass, sizeof(pass)) != sizeof(pass)) _exit(2);
+            }
+        }
+        ::close(reports[1]);
+        usleep(2000 + delays() % 60000);
+        kill(child, SIGKILL);
+        int status;
+        waitpid(child, &status, 0);
+        int flushed = 0, pass;
+        while (read(reports[0], &pass, sizeof(pass)) == sizeof(pass))
+            flushed = pass;
+        ::close(reports[0]);
+        if (!expect(WIFSIGNALED(status), "archiving child failed before it was killed")) return;
+
+        mt19937 rng(seed + round);
+        map<int, Task> expected;
+        for (int p = 1; p <= flushed; p++)
+            archivePass(rng, p, expected, nullptr);
+        map<int, Task> nextPass = expected;
+        archivePass(rng, flushed + 1, nextPass, nullptr);
+        {
+            TaskBTree tree(16);
+            if (!expect(tree.open(path), "reopen after crash: " + tree.error())) return;
+            bool atFlush = holds(tree, expected);
+            if (!expect(atFlush || holds(tree, nextPass),
+                    "after a crash in pass " + to_string(flushed + 1) + " the tree is not as of a flush: " + tree.error()))
+                return;
+            // The recovered tree takes further changes and survives a clean reopen.
+            if (!atFlush)
+                expected = nextPass;
+            expect(archivePass(rng, flushed + 2, expected, &tree) && tree.flush(), "archive after recovery: " + tree.error());
+        }
+        TaskBTree tree(16);
+        expect(tree.open(path) && holds(tree, expected), "reopen after recovery: " + tree.error());
+        removeTree(path);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned seed = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1;
+    testRandomOperations(seed);
+    testSequentialAppend();
+    testOverflowReuse();
+    testCorruptPage();
+    testCrashRecovery(seed);
+    if (failures > 0)
+    {
+        fprintf(stderr, "%d check(s) failed (seed %u)\n", failures, seed);
+        return 1;
+    }
+    printf("all TaskBTree checks passed\n");
+    return 0;
+}
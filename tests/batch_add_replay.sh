@@ -0,0 +1,71 @@
+#!/bin/sh
+# Batch add, undo, redo, reload from the journal, then restart: every task must
+# come back exactly once, and the priority queue built by the batch must pop in
+# priority order.
+#
+# usage: batch_add_replay.sh MAIN2
+set -e
+main2=$1
+count=300
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+cd "$dir"
+
+fail()
+{
+    echo "FAIL: $*" >&2
+    exit 1
+}
+
+i=1
+while [ $i -le $count ]; do
+    echo "\"task $i\" \"batch task $i\" $((i * 7 % 11)) $((i % 3)) none" >> specs.txt
+    i=$((i + 1))
+done
+
+# IDs listed by the Nth reply to COMMAND, one per line.
+ids()
+{
+    grep "\"command\":\"$1\"" replies.txt | sed -n "${2}p" | grep -o '{"id":[0-9]*' | cut -d: -f2
+}
+# Checks that the Nth list reply holds IDs 1..count, each once.
+check_all()
+{
+    ids list "$1" | sort -n > listed.txt
+    seq 1 $count > expected.txt
+    cmp -s listed.txt expected.txt || fail "$2: expected IDs 1-$count exactly once, got $(wc -l < listed.txt) entries"
+}
+
+"$main2" --json > replies.txt <<'COMMANDS'
+add-many specs.txt
+list
+undo
+list
+redo
+list
+load
+list
+by-priority
+COMMANDS
+
+grep -q '"command":"add-many","ok":true,"id":1}' replies.txt || fail "add-many did not report first ID 1"
+check_all 1 "after add-many"
+[ -z "$(ids list 2)" ] || fail "undo left tasks behind"
+check_all 3 "after redo"
+check_all 4 "after replaying the journal"
+
+# Tasks still queued are the ones not completed (status 2), highest priority first.
+queued=$(grep '"command":"by-priority"' replies.txt | grep -o '"status":"[a-z_]*","priority":[0-9]*')
+[ "$(echo "$queued" | grep -c .)" -eq $((count - count / 3)) ] || fail "wrong number of queued tasks"
+echo "$queued" | grep -q completed && fail "completed task in the queue"
+echo "$queued" | cut -d: -f3 | sort -n -r -c || fail "queue does not pop in priority order"
+
+# A fresh process recovers the same tasks and carries on numbering after them.
+"$main2" --json > replies.txt <<'COMMANDS'
+list
+add restart "added after restart" 1 0 none
+COMMANDS
+check_all 1 "after restart"
+grep -q "\"command\":\"add\",\"ok\":true,\"id\":$((count + 1))}" replies.txt || fail "IDs reused after restart"
+
+echo "batch add, undo, redo and replay: $count tasks, each exactly once"
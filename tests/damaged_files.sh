@@ -0,0 +1,92 @@
+#!/bin/sh
+# Damaged files must never cost the tasks they still hold: a snapshot that
+# fails its checksums, or a rules file that does not parse, is set aside and
+# nothing is saved over it until it is dealt with; a malformed import changes
+# nothing.
+#
+# usage: damaged_files.sh MAIN2
+set -e
+main2=$1
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+cd "$dir"
+
+fail()
+{
+    echo "FAIL: $*" >&2
+    exit 1
+}
+
+# IDs listed by the last list reply in replies.txt, space separated.
+listed()
+{
+    grep '"command":"list"' replies.txt | tail -n 1 | grep -o '{"id":[0-9]*' | cut -d: -f2 | sort -n | tr '\n' ' '
+}
+
+"$main2" --json > replies.txt <<'COMMANDS'
+add first "first task" 1 0 none
+add second "second task" 2 0 none
+COMMANDS
+cp tasks.snapshot good.snapshot
+
+# One byte of the first task's name: the string checksum fails, every record still reads.
+# The refused save makes the run fail.
+printf 'X' | dd of=tasks.snapshot bs=1 seek=176 conv=notrunc 2>/dev/null
+"$main2" --json > replies.txt 2> errors.txt <<'COMMANDS' || true
+list
+add third "third task" 3 0 none
+save
+COMMANDS
+[ "$(listed)" = "1 2 " ] || fail "damaged snapshot: listed '$(listed)', expected 1 2"
+[ -f tasks.snapshot.corrupt ] && [ ! -f tasks.snapshot ] || fail "damaged snapshot was not set aside"
+grep -q '"command":"save","ok":false' replies.txt || fail "save wrote over a damaged snapshot"
+grep -q 'Recovered 2 of 2 tasks' errors.txt || fail "no warning about the damaged snapshot"
+
+# Until the user acts, every start recovers from the set-aside copy and the journal.
+"$main2" --json > replies.txt 2> /dev/null <<'COMMANDS'
+list
+COMMANDS
+[ "$(listed)" = "1 2 3 " ] || fail "after restart: listed '$(listed)', expected 1 2 3"
+[ ! -f tasks.snapshot ] || fail "a snapshot was written while the damaged one waits"
+
+# Restoring a good copy and removing the damaged one lets saves through again.
+mv good.snapshot tasks.snapshot
+rm tasks.snapshot.corrupt
+"$main2" --json > replies.txt <<'COMMANDS'
+list
+save
+COMMANDS
+[ "$(listed)" = "1 2 3 " ] || fail "after repair: listed '$(listed)', expected 1 2 3"
+grep -q '"command":"save","ok":true' replies.txt || fail "save still refused after repair"
+
+# A rules file cut short is set aside, and new rules are not saved over it.
+"$main2" --json > replies.txt <<'COMMANDS'
+recur daily "daily task" 1 1d "every 1d"
+COMMANDS
+head -c 20 tasks.rules > rules.txt
+cp rules.txt tasks.rules
+"$main2" --json > replies.txt 2> errors.txt <<'COMMANDS'
+recur hourly "hourly task" 1 1h "every 1h"
+COMMANDS
+[ -f tasks.rules.corrupt ] && [ ! -f tasks.rules ] || fail "damaged rules file was not set aside"
+cmp -s rules.txt tasks.rules.corrupt || fail "damaged rules file was changed"
+grep -q 'Not saving recurring tasks' errors.txt || fail "no error about the damaged rules file"
+
+# A malformed import fails before the tasks or the archive are cleared.
+"$main2" --json > replies.txt <<'COMMANDS'
+add done "finished task" 1 2 none
+archive 0
+list
+COMMANDS
+before=$(listed)
+printf '10\n2\n5\nbroken\n' > bad.txt
+"$main2" --json > replies.txt 2> /dev/null <<'COMMANDS' || true
+import bad.txt
+list
+export all.txt
+COMMANDS
+grep -q '"command":"import","ok":false' replies.txt || fail "a malformed import reported success"
+[ "$(listed)" = "$before" ] || fail "after a failed import: listed '$(listed)', expected '$before'"
+grep -q '^finished task$' all.txt || fail "a failed import cleared the archive"
+
+echo "damaged files: nothing lost"